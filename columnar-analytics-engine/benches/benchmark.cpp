@@ -4,6 +4,7 @@
 
 #include "format.h"
 #include "execution.h"
+#include "join.h"
 #include <iostream>
 #include <chrono>
 #include <random>
@@ -94,6 +95,176 @@ void generateBenchmarkDataset(const std::string& path, size_t num_rows, unsigned
     std::cout << "Dataset generated: " << path << "\n\n";
 }
 
+// One row per event keyed by a high-cardinality user id (about 63% of the
+// rows carry a distinct key), with a Bloom filter on the user column at
+// the given false positive rate (0: none)
+void generateHighCardinalityDataset(const std::string& path, size_t num_rows, unsigned int seed,
+                                    double bloom_fpp = 0.0) {
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<uint64_t> key_dist(0, num_rows > 0 ? num_rows - 1 : 0);
+    std::uniform_int_distribution<int64_t> value_dist(0, 100000);
+
+    Schema schema;
+    schema.columns = {
+        {"user", ColumnType::STRING, EncodingType::PLAIN},
+        {"value", ColumnType::INT64, EncodingType::PLAIN}
+    };
+
+    FileWriter writer(path, schema);
+    writer.setBloomFilter(0, bloom_fpp);
+
+    const size_t chunk_size = 50000;
+    size_t remaining = num_rows;
+
+    while (remaining > 0) {
+        size_t current_chunk = std::min(remaining, chunk_size);
+
+        std::vector<std::string> users(current_chunk);
+        std::vector<int64_t> values(current_chunk);
+
+        for (size_t i = 0; i < current_chunk; i++) {
+            users[i] = "user_" + std::to_string(key_dist(rng));
+            values[i] = value_dist(rng);
+        }
+
+        writer.writeStringColumn(0, users);
+        writer.writeInt64Column(1, values);
+        writer.flushRowGroup();
+
+        remaining -= current_chunk;
+    }
+
+    writer.close();
+}
+
+// Events in roughly time order: ts follows the row number with a jitter of
+// a few thousand, so chunks are not sorted but each 4096-row block covers a
+// narrow ts range. Row groups of 250000 rows, with column indexes at the
+// given block size (0: none)
+void generateClusteredDataset(const std::string& path, size_t num_rows, unsigned int seed,
+                              uint32_t rows_per_block = 0) {
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<int64_t> jitter_dist(-2000, 2000);
+    std::uniform_int_distribution<int64_t> value_dist(0, 100000);
+
+    Schema schema;
+    schema.columns = {
+        {"ts", ColumnType::INT64, EncodingType::DELTA},
+        {"value", ColumnType::INT64, EncodingType::PLAIN}
+    };
+
+    FileWriter writer(path, schema);
+    if (rows_per_block != 0) {
+        writer.setColumnIndex(rows_per_block);
+    }
+
+    const size_t chunk_size = 250000;
+    size_t written = 0;
+
+    while (written < num_rows) {
+        size_t current_chunk = std::min(num_rows - written, chunk_size);
+
+        std::vector<int64_t> ts(current_chunk);
+        std::vector<int64_t> values(current_chunk);
+
+        for (size_t i = 0; i < current_chunk; i++) {
+            ts[i] = static_cast<int64_t>(written + i) + jitter_dist(rng);
+            values[i] = value_dist(rng);
+        }
+
+        writer.writeInt64Column(0, ts);
+        writer.writeInt64Column(1, values);
+        writer.flushRowGroup();
+
+        written += current_chunk;
+    }
+
+    writer.close();
+}
+
+// Dimension table for the join benchmark: one row per possible value of
+// the synthetic dataset's value column (0..100000), with a string label
+void generateDimensionDataset(const std::string& path) {
+    Schema schema;
+    schema.columns = {
+        {"value", ColumnType::INT64, EncodingType::PLAIN},
+        {"segment", ColumnType::STRING, EncodingType::DICTIONARY}
+    };
+
+    FileWriter writer(path, schema);
+
+    const int64_t num_keys = 100001;
+    const int64_t chunk_size = 50000;
+    for (int64_t begin = 0; begin < num_keys; begin += chunk_size) {
+        std::vector<int64_t> keys;
+        std::vector<std::string> segments;
+        for (int64_t key = begin; key < std::min(begin + chunk_size, num_keys); key++) {
+            keys.push_back(key);
+            segments.push_back("segment_" + std::to_string(key % 100));
+        }
+        writer.writeInt64Column(0, keys);
+        writer.writeStringColumn(1, segments);
+        writer.flushRowGroup();
+    }
+    writer.close();
+}
+
+// Same columns as the CLI's synthetic dataset: two low-cardinality string
+// columns (region, status) plus an integer category
+void generateReportDataset(const std::string& path, size_t num_rows, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int32_t> category_dist(1, 5);
+    std::uniform_int_distribution<int64_t> value_dist(0, 10000);
+    std::uniform_int_distribution<int> region_dist(0, 3);
+    std::uniform_int_distribution<int> status_dist(0, 2);
+
+    std::vector<std::string> regions = {"north", "south", "east", "west"};
+    std::vector<std::string> statuses = {"active", "pending", "closed"};
+
+    Schema schema;
+    schema.columns = {
+        {"id", ColumnType::INT64, EncodingType::PLAIN},
+        {"value", ColumnType::INT64, EncodingType::DELTA},
+        {"category", ColumnType::INT32, EncodingType::RLE},
+        {"region", ColumnType::STRING, EncodingType::DICTIONARY},
+        {"status", ColumnType::STRING, EncodingType::DICTIONARY}
+    };
+
+    FileWriter writer(path, schema);
+
+    const size_t chunk_size = 50000;
+    size_t remaining = num_rows;
+
+    while (remaining > 0) {
+        size_t current_chunk = std::min(remaining, chunk_size);
+
+        std::vector<int64_t> ids(current_chunk);
+        std::vector<int64_t> values(current_chunk);
+        std::vector<int32_t> categories(current_chunk);
+        std::vector<std::string> region_vals(current_chunk);
+        std::vector<std::string> status_vals(current_chunk);
+
+        for (size_t i = 0; i < current_chunk; i++) {
+            ids[i] = static_cast<int64_t>(num_rows - remaining + i);
+            values[i] = value_dist(rng);
+            categories[i] = category_dist(rng);
+            region_vals[i] = regions[static_cast<size_t>(region_dist(rng))];
+            status_vals[i] = statuses[static_cast<size_t>(status_dist(rng))];
+        }
+
+        writer.writeInt64Column(0, ids);
+        writer.writeInt64Column(1, values);
+        writer.writeInt32Column(2, categories);
+        writer.writeStringColumn(3, region_vals);
+        writer.writeStringColumn(4, status_vals);
+        writer.flushRowGroup();
+
+        remaining -= current_chunk;
+    }
+
+    writer.close();
+}
+
 BenchmarkResult runFullScan(const std::string& path) {
     Timer timer;
     timer.start();
@@ -101,11 +272,11 @@ BenchmarkResult runFullScan(const std::string& path) {
     auto reader = std::make_shared<FileReader>(path);
     QueryExecutor executor(reader);
 
-    auto batches = executor.executeQuery();
+    auto stream = executor.executeStream();
 
     size_t total_rows = 0;
-    for (const auto& batch : batches) {
-        total_rows += batch.num_rows;
+    while (stream.hasNext()) {
+        total_rows += stream.next().num_rows;
     }
 
     double elapsed = timer.elapsed_ms();
@@ -131,11 +302,11 @@ BenchmarkResult runFilteredScan(const std::string& path) {
     QueryExecutor executor(reader);
 
     executor.addFilter(Predicate{"value", CompareOp::GT, 50000});
-    auto batches = executor.executeQuery();
+    auto stream = executor.executeStream();
 
     size_t total_rows = 0;
-    for (const auto& batch : batches) {
-        total_rows += batch.num_rows;
+    while (stream.hasNext()) {
+        total_rows += stream.next().num_rows;
     }
 
     double elapsed = timer.elapsed_ms();
@@ -152,6 +323,223 @@ BenchmarkResult runFilteredScan(const std::string& path) {
     return result;
 }
 
+// region prefix 'north' (three of eight regions), evaluated once per
+// dictionary entry and then by code; only matching rows are decoded
+BenchmarkResult runStringFilter(const std::string& path) {
+    Timer timer;
+    timer.start();
+
+    auto reader = std::make_shared<FileReader>(path);
+    QueryExecutor executor(reader);
+
+    executor.addFilter(Predicate::startsWith("region", "north"));
+    auto stream = executor.executeStream();
+
+    size_t total_rows = 0;
+    while (stream.hasNext()) {
+        total_rows += stream.next().num_rows;
+    }
+
+    double elapsed = timer.elapsed_ms();
+    size_t file_size = std::filesystem::file_size(path);
+
+    BenchmarkResult result;
+    result.name = "Filtered Scan (region prefix 'north')";
+    result.elapsed_ms = elapsed;
+    result.rows_processed = total_rows;
+    result.bytes_processed = file_size;
+    result.throughput_mbps = (file_size / (1024.0 * 1024.0)) / (elapsed / 1000.0);
+    result.rows_per_sec = total_rows / (elapsed / 1000.0);
+
+    return result;
+}
+
+// id IN (100K keys): every fifth id of the first 500K rows, so row groups
+// past them are skipped from their stats and the others are filtered
+// through the Bloom filter and hash set
+BenchmarkResult runInFilter(const std::string& path) {
+    Timer timer;
+    timer.start();
+
+    auto reader = std::make_shared<FileReader>(path);
+    std::vector<int64_t> keys;
+    for (int64_t i = 0; i < 100000; i++) {
+        keys.push_back(i * 5);
+    }
+    Predicate in = Predicate::in("id", std::move(keys));
+
+    QueryExecutor executor(reader);
+    executor.addFilter(in);
+    auto stream = executor.executeStream();
+
+    size_t total_rows = 0;
+    while (stream.hasNext()) {
+        total_rows += stream.next().num_rows;
+    }
+
+    double elapsed = timer.elapsed_ms();
+    size_t file_size = std::filesystem::file_size(path);
+
+    size_t pruned = 0;
+    for (const auto& rg : reader->metadata().row_groups) {
+        pruned += in.canSkipPage(rg.column_chunks[0].page_headers[0].stats) ? 1 : 0;
+    }
+
+    BenchmarkResult result;
+    result.name = "Filtered Scan (id IN 100000 keys, " + std::to_string(pruned) + "/" +
+                  std::to_string(reader->metadata().row_groups.size()) + " row groups pruned)";
+    result.elapsed_ms = elapsed;
+    result.rows_processed = total_rows;
+    result.bytes_processed = file_size;
+    result.throughput_mbps = (file_size / (1024.0 * 1024.0)) / (elapsed / 1000.0);
+    result.rows_per_sec = total_rows / (elapsed / 1000.0);
+
+    return result;
+}
+
+// user = '<key>' for 20 random keys of the high-cardinality dataset, whose
+// user chunks all span nearly the whole key range: without Bloom filters
+// every row group is read, with them only those that may hold the key
+BenchmarkResult runPointLookup(const std::string& path, const std::string& label) {
+    auto reader = std::make_shared<FileReader>(path);
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<uint32_t> key_dist(0, reader->metadata().total_rows);
+
+    Timer timer;
+    timer.start();
+
+    size_t total_rows = 0;
+    const size_t num_lookups = 20;
+    for (size_t i = 0; i < num_lookups; i++) {
+        Scanner scanner(reader, {"user", "value"});
+        scanner.addFilter(Predicate::compareString("user", CompareOp::EQ, "user_" + std::to_string(key_dist(rng))));
+        while (scanner.hasNext()) {
+            total_rows += scanner.next().num_rows;
+        }
+    }
+
+    double elapsed = timer.elapsed_ms();
+    size_t file_size = std::filesystem::file_size(path);
+
+    BenchmarkResult result;
+    result.name = "Point Lookup (" + std::to_string(num_lookups) + " x user EQ, " + label + ")";
+    result.elapsed_ms = elapsed;
+    result.rows_processed = total_rows;
+    result.bytes_processed = file_size * num_lookups;
+    result.throughput_mbps = (file_size * num_lookups / (1024.0 * 1024.0)) / (elapsed / 1000.0);
+    result.rows_per_sec = total_rows / (elapsed / 1000.0);
+
+    return result;
+}
+
+// id BETWEEN over 1% of the rows: the sorted id chunk of the one row group
+// not skipped from its stats is binary-searched for the range, which is
+// sliced out without comparing its rows
+BenchmarkResult runSortedRangeScan(const std::string& path) {
+    Timer timer;
+    timer.start();
+
+    auto reader = std::make_shared<FileReader>(path);
+    int64_t total = static_cast<int64_t>(reader->metadata().total_rows);
+    QueryExecutor executor(reader);
+    executor.addFilter(FilterExpr::between("id", total / 2 + 1000, total / 2 + 1000 + total / 100));
+    auto stream = executor.executeStream();
+
+    size_t total_rows = 0;
+    while (stream.hasNext()) {
+        total_rows += stream.next().num_rows;
+    }
+
+    double elapsed = timer.elapsed_ms();
+    size_t file_size = std::filesystem::file_size(path);
+
+    BenchmarkResult result;
+    result.name = "Range Scan (sorted id BETWEEN, 1% of rows)";
+    result.elapsed_ms = elapsed;
+    result.rows_processed = total_rows;
+    result.bytes_processed = file_size;
+    result.throughput_mbps = (file_size / (1024.0 * 1024.0)) / (elapsed / 1000.0);
+    result.rows_per_sec = total_rows / (elapsed / 1000.0);
+
+    return result;
+}
+
+// ts BETWEEN over 1% of the clustered dataset: row group stats leave one
+// row group, whose column indexes (if any) narrow the scan to the few
+// blocks that may hold the range
+BenchmarkResult runZoneMapScan(const std::string& path, const std::string& label) {
+    Timer timer;
+    timer.start();
+
+    auto reader = std::make_shared<FileReader>(path);
+    int64_t total = static_cast<int64_t>(reader->metadata().total_rows);
+    QueryExecutor executor(reader);
+    executor.addFilter(FilterExpr::between("ts", total / 2 + 1000, total / 2 + 1000 + total / 100));
+    auto stream = executor.executeStream();
+
+    size_t total_rows = 0;
+    while (stream.hasNext()) {
+        total_rows += stream.next().num_rows;
+    }
+
+    double elapsed = timer.elapsed_ms();
+    size_t file_size = std::filesystem::file_size(path);
+
+    BenchmarkResult result;
+    result.name = "Range Scan (clustered ts BETWEEN, " + label + ")";
+    result.elapsed_ms = elapsed;
+    result.rows_processed = total_rows;
+    result.bytes_processed = file_size;
+    result.throughput_mbps = (file_size / (1024.0 * 1024.0)) / (elapsed / 1000.0);
+    result.rows_per_sec = total_rows / (elapsed / 1000.0);
+
+    return result;
+}
+
+// OR of three narrow id ranges, as a dashboard with several time windows
+// would send in one query
+BenchmarkResult runOrRangesFilter(const std::string& path) {
+    Timer timer;
+    timer.start();
+
+    auto reader = std::make_shared<FileReader>(path);
+    int64_t total = static_cast<int64_t>(reader->metadata().total_rows);
+    std::vector<FilterExpr> ranges;
+    for (int64_t start : {total / 10, total / 2, total * 9 / 10}) {
+        ranges.push_back(FilterExpr::between("id", start, start + total / 100));
+    }
+    FilterExpr any = FilterExpr::anyOf(std::move(ranges));
+
+    QueryExecutor executor(reader);
+    executor.addFilter(any);
+    auto stream = executor.executeStream();
+
+    size_t total_rows = 0;
+    while (stream.hasNext()) {
+        total_rows += stream.next().num_rows;
+    }
+
+    double elapsed = timer.elapsed_ms();
+    size_t file_size = std::filesystem::file_size(path);
+
+    size_t pruned = 0;
+    for (const auto& rg : reader->metadata().row_groups) {
+        auto stats = [&](const std::string&) { return &rg.column_chunks[0].page_headers[0].stats; };
+        pruned += any.matchStats(stats) == StatsMatch::NEVER ? 1 : 0;
+    }
+
+    BenchmarkResult result;
+    result.name = "Filtered Scan (OR of 3 id ranges, " + std::to_string(pruned) + "/" +
+                  std::to_string(reader->metadata().row_groups.size()) + " row groups pruned)";
+    result.elapsed_ms = elapsed;
+    result.rows_processed = total_rows;
+    result.bytes_processed = file_size;
+    result.throughput_mbps = (file_size / (1024.0 * 1024.0)) / (elapsed / 1000.0);
+    result.rows_per_sec = total_rows / (elapsed / 1000.0);
+
+    return result;
+}
+
 BenchmarkResult runAggregation(const std::string& path) {
     Timer timer;
     timer.start();
@@ -176,14 +564,111 @@ BenchmarkResult runAggregation(const std::string& path) {
     return bench_result;
 }
 
-BenchmarkResult runGroupBy(const std::string& path) {
+// ORDER BY column DESC LIMIT 100: row groups whose max cannot reach the
+// current top 100 are skipped, so a column correlated with file order (id)
+// reads a fraction of the file, while a random column (value) reads it all
+BenchmarkResult runTopN(const std::string& path, const std::string& column) {
+    Timer timer;
+    timer.start();
+
+    auto reader = std::make_shared<FileReader>(path);
+    QueryExecutor executor(reader);
+
+    executor.setOrderBy(column, true);
+    executor.setLimit(100);
+    auto batches = executor.executeQuery();
+
+    double elapsed = timer.elapsed_ms();
+    size_t file_size = std::filesystem::file_size(path);
+    size_t total_rows = reader->metadata().total_rows;
+
+    BenchmarkResult result;
+    result.name = "Top 100 by " + column + " (" + std::to_string(executor.prunedRowGroups()) + "/" +
+                  std::to_string(reader->metadata().row_groups.size()) + " row groups pruned)";
+    result.elapsed_ms = elapsed;
+    result.rows_processed = total_rows;
+    result.bytes_processed = file_size;
+    result.throughput_mbps = (file_size / (1024.0 * 1024.0)) / (elapsed / 1000.0);
+    result.rows_per_sec = total_rows / (elapsed / 1000.0);
+
+    return result;
+}
+
+// Full ORDER BY value: sorted runs of at most half the memory budget are
+// spilled and merged back while the result is pulled
+BenchmarkResult runExternalSort(const std::string& path, size_t memory_budget) {
+    Timer timer;
+    timer.start();
+
+    auto reader = std::make_shared<FileReader>(path);
+    QueryExecutor executor(reader);
+
+    executor.setOrderBy("value");
+    executor.setMemoryBudget(memory_budget);
+    auto stream = executor.executeStream();
+
+    size_t total_rows = 0;
+    while (stream.hasNext()) {
+        total_rows += stream.next().num_rows;
+    }
+
+    double elapsed = timer.elapsed_ms();
+    size_t file_size = std::filesystem::file_size(path);
+
+    BenchmarkResult result;
+    result.name = memory_budget == 0 ? "Sort by value (in memory)"
+                                     : "Sort by value (" + std::to_string(memory_budget >> 20) + " MB budget)";
+    result.elapsed_ms = elapsed;
+    result.rows_processed = total_rows;
+    result.bytes_processed = file_size;
+    result.throughput_mbps = (file_size / (1024.0 * 1024.0)) / (elapsed / 1000.0);
+    result.rows_per_sec = total_rows / (elapsed / 1000.0);
+
+    return result;
+}
+
+// Inner join of the synthetic dataset with the dimension table on value:
+// hash tables are built over the dimension rows, and the fact file is
+// probed one row group per thread at a time
+BenchmarkResult runHashJoin(const std::string& path, const std::string& dim_path, size_t num_threads) {
+    Timer timer;
+    timer.start();
+
+    auto fact = std::make_shared<FileReader>(path);
+    auto dim = std::make_shared<FileReader>(dim_path);
+    HashJoin join(fact, "value", dim, "value");
+    join.setLeftColumns({"id", "value"});
+    join.setRightColumns({"segment"});
+    join.setThreads(num_threads);
+    auto stream = join.execute();
+
+    size_t total_rows = 0;
+    while (stream.hasNext()) {
+        total_rows += stream.next().num_rows;
+    }
+
+    double elapsed = timer.elapsed_ms();
+    size_t file_size = std::filesystem::file_size(path) + std::filesystem::file_size(dim_path);
+
+    BenchmarkResult result;
+    result.name = "Hash join on value (" + std::to_string(num_threads) + " thr)";
+    result.elapsed_ms = elapsed;
+    result.rows_processed = total_rows;
+    result.bytes_processed = file_size;
+    result.throughput_mbps = (file_size / (1024.0 * 1024.0)) / (elapsed / 1000.0);
+    result.rows_per_sec = total_rows / (elapsed / 1000.0);
+
+    return result;
+}
+
+BenchmarkResult runGroupBy(const std::string& path, const std::string& column) {
     Timer timer;
     timer.start();
 
     auto reader = std::make_shared<FileReader>(path);
     QueryExecutor executor(reader);
 
-    executor.setGroupBy("region");
+    executor.setGroupBy(column);
     executor.setAggregation(AggFunc::SUM, "value");
     auto results = executor.executeGroupBy();
 
@@ -196,7 +681,7 @@ BenchmarkResult runGroupBy(const std::string& path) {
     size_t file_size = std::filesystem::file_size(path);
 
     BenchmarkResult result;
-    result.name = "Group By (region)";
+    result.name = "Group By (" + column + ")";
     result.elapsed_ms = elapsed;
     result.rows_processed = total_rows;
     result.bytes_processed = file_size;
@@ -206,6 +691,156 @@ BenchmarkResult runGroupBy(const std::string& path) {
     return result;
 }
 
+// With a memory budget the aggregation spills to disk once its table
+// outgrows it
+BenchmarkResult runHighCardinalityGroupBy(const std::string& path, size_t memory_budget = 0) {
+    Timer timer;
+    timer.start();
+
+    auto reader = std::make_shared<FileReader>(path);
+    QueryExecutor executor(reader);
+
+    executor.setMemoryBudget(memory_budget);
+    executor.setGroupBy("user");
+    executor.setAggregation(AggFunc::SUM, "value");
+    auto results = executor.executeGroupBy();
+
+    size_t total_rows = 0;
+    for (const auto& [key, agg] : results) {
+        total_rows += agg.count;
+    }
+
+    double elapsed = timer.elapsed_ms();
+    size_t file_size = std::filesystem::file_size(path);
+
+    BenchmarkResult result;
+    result.name = "Group By (" + std::to_string(results.size()) + " keys" +
+                  (executor.spilledRows() > 0 ? ", spill)" : ")");
+    result.elapsed_ms = elapsed;
+    result.rows_processed = total_rows;
+    result.bytes_processed = file_size;
+    result.throughput_mbps = (file_size / (1024.0 * 1024.0)) / (elapsed / 1000.0);
+    result.rows_per_sec = total_rows / (elapsed / 1000.0);
+
+    return result;
+}
+
+BenchmarkResult runCompositeGroupBy(const std::string& path) {
+    Timer timer;
+    timer.start();
+
+    auto reader = std::make_shared<FileReader>(path);
+    QueryExecutor executor(reader);
+
+    executor.setGroupByColumns({"region", "status", "category"});
+    executor.addAggregation(AggFunc::COUNT, "id");
+    executor.addAggregation(AggFunc::SUM, "value");
+    auto results = executor.executeGroupByAggregates();
+
+    size_t total_rows = 0;
+    for (const auto& group : results) {
+        total_rows += group.aggs[0].count;
+    }
+
+    double elapsed = timer.elapsed_ms();
+    size_t file_size = std::filesystem::file_size(path);
+
+    BenchmarkResult result;
+    result.name = "Group By (3-column key)";
+    result.elapsed_ms = elapsed;
+    result.rows_processed = total_rows;
+    result.bytes_processed = file_size;
+    result.throughput_mbps = (file_size / (1024.0 * 1024.0)) / (elapsed / 1000.0);
+    result.rows_per_sec = total_rows / (elapsed / 1000.0);
+
+    return result;
+}
+
+// Keeps benchmark loops from being optimized away
+static volatile int64_t benchmark_sink = 0;
+
+// Scan value/score with varying batch sizes; small batches stay L2-resident
+// while they are consumed, very large ones spill to main memory
+std::vector<BenchmarkResult> runBatchSizeSweep(const std::string& path) {
+    const std::vector<size_t> batch_sizes = {256, 1024, 4096, 16384, 65536};
+    std::vector<BenchmarkResult> results;
+
+    auto reader = std::make_shared<FileReader>(path);
+    size_t file_size = std::filesystem::file_size(path);
+
+    for (size_t batch_size : batch_sizes) {
+        Timer timer;
+        timer.start();
+
+        Scanner scanner(reader, {"value", "score"}, batch_size);
+
+        size_t total_rows = 0;
+        int64_t checksum = 0;
+        while (scanner.hasNext()) {
+            Batch batch = scanner.next();
+            const auto& values = batch.getColumn<int64_t>(0);
+            const auto& scores = batch.getColumn<int32_t>(1);
+            for (size_t i = 0; i < batch.num_rows; i++) {
+                checksum += values[i] * scores[i];
+            }
+            total_rows += batch.num_rows;
+        }
+
+        double elapsed = timer.elapsed_ms();
+        benchmark_sink = checksum;
+
+        BenchmarkResult result;
+        result.name = "Scan (batch=" + std::to_string(batch_size) + ")";
+        result.elapsed_ms = elapsed;
+        result.rows_processed = total_rows;
+        result.bytes_processed = file_size;
+        result.throughput_mbps = (file_size / (1024.0 * 1024.0)) / (elapsed / 1000.0);
+        result.rows_per_sec = total_rows / (elapsed / 1000.0);
+        results.push_back(result);
+    }
+
+    return results;
+}
+
+// Group by one column with 1..8 worker threads; low-cardinality keys merge
+// trivially, high-cardinality keys exercise the partitioned merge
+std::vector<BenchmarkResult> runThreadSweep(const std::string& path, const std::string& column) {
+    const std::vector<size_t> thread_counts = {1, 2, 4, 8};
+    std::vector<BenchmarkResult> results;
+
+    auto reader = std::make_shared<FileReader>(path);
+    size_t file_size = std::filesystem::file_size(path);
+
+    for (size_t num_threads : thread_counts) {
+        Timer timer;
+        timer.start();
+
+        QueryExecutor executor(reader);
+        executor.setGroupBy(column);
+        executor.setAggregation(AggFunc::SUM, "value");
+        executor.setThreads(num_threads);
+        auto groups = executor.executeGroupBy();
+
+        size_t total_rows = 0;
+        for (const auto& [key, agg] : groups) {
+            total_rows += agg.count;
+        }
+
+        double elapsed = timer.elapsed_ms();
+
+        BenchmarkResult result;
+        result.name = "Group By " + column + " (" + std::to_string(num_threads) + " thr)";
+        result.elapsed_ms = elapsed;
+        result.rows_processed = total_rows;
+        result.bytes_processed = file_size;
+        result.throughput_mbps = (file_size / (1024.0 * 1024.0)) / (elapsed / 1000.0);
+        result.rows_per_sec = total_rows / (elapsed / 1000.0);
+        results.push_back(result);
+    }
+
+    return results;
+}
+
 void printResults(const std::vector<BenchmarkResult>& results) {
     std::cout << "\n=== Benchmark Results ===\n\n";
     std::cout << std::left << std::setw(30) << "Benchmark"
@@ -296,17 +931,82 @@ int main(int argc, char* argv[]) {
 
     std::vector<BenchmarkResult> results;
 
-    std::cout << "[1/4] Running full scan...\n";
+    std::cout << "[1/13] Running full scan...\n";
     results.push_back(runFullScan(dataset_path));
 
-    std::cout << "[2/4] Running filtered scan...\n";
+    std::cout << "[2/13] Running filtered scans...\n";
     results.push_back(runFilteredScan(dataset_path));
+    results.push_back(runInFilter(dataset_path));
+    results.push_back(runOrRangesFilter(dataset_path));
+    results.push_back(runSortedRangeScan(dataset_path));
+    results.push_back(runStringFilter(dataset_path));
 
-    std::cout << "[3/4] Running aggregation...\n";
+    std::cout << "[3/13] Running aggregation...\n";
     results.push_back(runAggregation(dataset_path));
 
-    std::cout << "[4/4] Running group by...\n";
-    results.push_back(runGroupBy(dataset_path));
+    std::cout << "[4/13] Running group by...\n";
+    results.push_back(runGroupBy(dataset_path, "region"));
+    results.push_back(runGroupBy(dataset_path, "score"));
+
+    std::cout << "[5/13] Running batch size sweep...\n";
+    for (auto& result : runBatchSizeSweep(dataset_path)) {
+        results.push_back(result);
+    }
+
+    std::cout << "[6/13] Running high-cardinality group by...\n";
+    const std::string high_card_path = "benchmark_high_card.col";
+    generateHighCardinalityDataset(high_card_path, num_rows, seed);
+    results.push_back(runHighCardinalityGroupBy(high_card_path));
+    results.push_back(runHighCardinalityGroupBy(high_card_path, 8 << 20));
+
+    std::cout << "[7/13] Running composite-key group by...\n";
+    const std::string report_path = "benchmark_report.col";
+    generateReportDataset(report_path, num_rows, seed);
+    results.push_back(runCompositeGroupBy(report_path));
+    std::filesystem::remove(report_path);
+
+    std::cout << "[8/13] Running parallel group by thread sweep...\n";
+    for (auto& result : runThreadSweep(dataset_path, "region")) {
+        results.push_back(result);
+    }
+    for (auto& result : runThreadSweep(high_card_path, "user")) {
+        results.push_back(result);
+    }
+    std::filesystem::remove(high_card_path);
+
+    std::cout << "[9/13] Running top-N (ORDER BY ... LIMIT)...\n";
+    results.push_back(runTopN(dataset_path, "id"));
+    results.push_back(runTopN(dataset_path, "value"));
+
+    std::cout << "[10/13] Running external sort (ORDER BY without LIMIT)...\n";
+    results.push_back(runExternalSort(dataset_path, 0));
+    results.push_back(runExternalSort(dataset_path, 8 << 20));
+
+    std::cout << "[11/13] Running hash join with a dimension table...\n";
+    const std::string dim_path = "benchmark_dim.col";
+    generateDimensionDataset(dim_path);
+    results.push_back(runHashJoin(dataset_path, dim_path, 1));
+    results.push_back(runHashJoin(dataset_path, dim_path, 4));
+    std::filesystem::remove(dim_path);
+
+    std::cout << "[12/13] Running point lookups with and without Bloom filters...\n";
+    const std::string bloom_path = "benchmark_bloom.col";
+    generateHighCardinalityDataset(high_card_path, num_rows, seed);
+    generateHighCardinalityDataset(bloom_path, num_rows, seed, 0.01);
+    results.push_back(runPointLookup(high_card_path, "no Bloom filter"));
+    results.push_back(runPointLookup(bloom_path, "Bloom filter 1% fpp"));
+    std::filesystem::remove(high_card_path);
+    std::filesystem::remove(bloom_path);
+
+    std::cout << "[13/13] Running range scans with and without column indexes...\n";
+    const std::string clustered_path = "benchmark_clustered.col";
+    const std::string zone_map_path = "benchmark_zone_map.col";
+    generateClusteredDataset(clustered_path, num_rows, seed);
+    generateClusteredDataset(zone_map_path, num_rows, seed, 4096);
+    results.push_back(runZoneMapScan(clustered_path, "no column index"));
+    results.push_back(runZoneMapScan(zone_map_path, "column index"));
+    std::filesystem::remove(clustered_path);
+    std::filesystem::remove(zone_map_path);
 
     printResults(results);
 
@@ -0,0 +1,423 @@
+// Columnar Analytics Engine
+// Author: RIAL Fares
+// Hash aggregation primitives
+
+#pragma once
+
+#include "execution.h"
+#include "sketch.h"
+#include <bit>
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+
+namespace columnar {
+
+// Hashing
+uint64_t hashInt64(uint64_t value);
+uint64_t hashBytes(const char* data, size_t len);
+uint64_t hashWords(const uint64_t* words, size_t num_words);
+
+// Batched hashing over a whole column (one tight loop per column)
+void hashColumn(const std::vector<std::string>& values, std::vector<uint64_t>& hashes);
+void hashColumn(const std::vector<int32_t>& values, std::vector<uint64_t>& hashes);
+void hashColumn(const std::vector<int64_t>& values, std::vector<uint64_t>& hashes);
+
+// Group id reported by lookups of keys absent from a table
+constexpr uint32_t NO_GROUP = UINT32_MAX;
+
+// sum += value modulo 2^64, counting the wraps past the int64 range in
+// wraps (+1 upwards, -1 downwards), so sum + wraps * 2^64 stays exact.
+// Branchless: overflow costs no per-row branch.
+inline void addWrapping(int64_t& sum, int64_t& wraps, int64_t value) {
+    int64_t result = static_cast<int64_t>(static_cast<uint64_t>(sum) + static_cast<uint64_t>(value));
+    int64_t overflow = ((sum ^ result) & (value ^ result)) >> 63;  // 0 or -1
+    wraps += overflow & ((value >> 63) | 1);
+    sum = result;
+}
+
+inline Int128 wrappedSum(int64_t sum, int64_t wraps) {
+    Int128 exact(sum);
+    exact.hi += wraps;
+    return exact;
+}
+
+// Variance and standard deviation are computed from each set's count, mean
+// and M2 (sum of squared deviations from the mean), which merge exactly
+// (Chan et al.), so partial states from batches, row groups or threads can
+// be combined in any order
+inline bool needsMoments(AggFunc func) {
+    return func == AggFunc::VAR_POP || func == AggFunc::VAR_SAMP ||
+           func == AggFunc::STDDEV_POP || func == AggFunc::STDDEV;
+}
+
+inline void mergeMoments(int64_t& count, double& mean, double& m2,
+                         int64_t other_count, double other_mean, double other_m2) {
+    if (other_count == 0) {
+        return;
+    }
+    int64_t total = count + other_count;
+    double delta = other_mean - mean;
+    double other_weight = static_cast<double>(other_count) / static_cast<double>(total);
+    mean += delta * other_weight;
+    m2 += other_m2 + delta * delta * static_cast<double>(count) * other_weight;
+    count = total;
+}
+
+// Final value of AVG (from the exact sum) or of a variance or standard
+// deviation (from M2); empty for other functions or too few values
+std::optional<double> aggregateValue(AggFunc func, int64_t count, const Int128& sum, double m2);
+
+// Open-addressing index mapping hashes to dense group ids (0, 1, 2, ...).
+// Slots are probed 16 at a time: each slot has a control byte holding 7 bits
+// of the hash, compared against the probe tag in one SIMD instruction, so
+// full key comparisons only happen on tag matches. Keys themselves live
+// outside the index; callers supply an equality test on group ids.
+class FlatGroupIndex {
+public:
+    FlatGroupIndex();
+
+    // Return the group id of the key with the given hash, calling
+    // eq(group_id) to confirm candidates. A new id (== size()) is assigned
+    // when no candidate matches; inserted reports which case happened.
+    template<typename Eq>
+    uint32_t findOrInsert(uint64_t hash, Eq&& eq, bool& inserted);
+
+    // Group id of the key with the given hash, or NO_GROUP
+    template<typename Eq>
+    uint32_t find(uint64_t hash, Eq&& eq) const;
+
+    size_t size() const { return group_hashes_.size(); }
+    uint64_t groupHash(uint32_t group_id) const { return group_hashes_[group_id]; }
+    size_t memoryUsage() const;
+
+private:
+    static constexpr size_t GROUP_WIDTH = 16;
+    static constexpr uint8_t EMPTY = 0x80;
+
+    static uint32_t matchTag(const uint8_t* ctrl, uint8_t tag);
+    static uint32_t matchEmpty(const uint8_t* ctrl);
+
+    void insertSlot(uint64_t hash, uint32_t group_id);
+    void grow();
+
+    std::vector<uint8_t> ctrl_;
+    std::vector<uint32_t> slots_;
+    std::vector<uint64_t> group_hashes_;
+    size_t num_groups_mask_;  // Number of 16-slot groups - 1
+};
+
+// Group table for string keys. Key bytes are copied once into an arena, so
+// the table holds no per-key heap allocations.
+class StringGroupTable {
+public:
+    // Map each key to its group id, inserting unseen keys
+    void findOrInsert(const std::vector<std::string>& keys, std::vector<uint32_t>& group_ids);
+
+    // Map each key to its group id, or NO_GROUP when it is not in the table
+    void find(const std::vector<std::string>& keys, std::vector<uint32_t>& group_ids);
+
+    // Group id of one key whose hash (hashBytes) the caller computed, or
+    // NO_GROUP. Does not modify the table, so threads may probe it at once.
+    uint32_t find(std::string_view key, uint64_t hash) const {
+        return index_.find(hash, [&](uint32_t g) { return keyEquals(g, key); });
+    }
+
+    std::string_view key(uint32_t group_id) const;
+    size_t size() const { return index_.size(); }
+    size_t memoryUsage() const;
+
+private:
+    bool keyEquals(uint32_t group_id, std::string_view key) const;
+
+    FlatGroupIndex index_;
+    std::vector<char> arena_;
+    std::vector<uint64_t> key_offsets_;
+    std::vector<uint32_t> key_lengths_;
+    std::vector<uint64_t> hashes_;
+};
+
+// Group table for integer keys (INT32 and INT64 columns)
+class IntGroupTable {
+public:
+    template<typename T>
+    void findOrInsert(const std::vector<T>& keys, std::vector<uint32_t>& group_ids);
+
+    template<typename T>
+    void find(const std::vector<T>& keys, std::vector<uint32_t>& group_ids);
+
+    // Group id of one key whose hash (hashInt64) the caller computed, or
+    // NO_GROUP. Does not modify the table, so threads may probe it at once.
+    uint32_t find(int64_t key, uint64_t hash) const {
+        return index_.find(hash, [&](uint32_t g) { return keys_[g] == key; });
+    }
+
+    int64_t key(uint32_t group_id) const { return keys_[group_id]; }
+    size_t size() const { return index_.size(); }
+    size_t memoryUsage() const;
+
+private:
+    FlatGroupIndex index_;
+    std::vector<int64_t> keys_;
+    std::vector<uint64_t> hashes_;
+};
+
+// Integer keys of an IN predicate. Lookups test a Bloom filter first,
+// which rejects most absent keys from one cache line, then a hash table.
+// The keys are also kept sorted, to tell whether a stats range holds any.
+class KeySet {
+public:
+    explicit KeySet(std::vector<int64_t> keys);
+
+    bool contains(int64_t key) const { return contains(key, hashInt64(static_cast<uint64_t>(key))); }
+
+    bool contains(int64_t key, uint64_t hash) const {
+        return bloom_.mayContain(hash) && table_.find(key, hash) != NO_GROUP;
+    }
+
+    // Narrow a selection vector of row indices to the rows holding a key.
+    // When first is set, the selection is built from [begin, end) instead.
+    void select(const std::vector<int32_t>& vals, size_t begin, size_t end, bool first, std::vector<uint32_t>& sel) const;
+    void select(const std::vector<int64_t>& vals, size_t begin, size_t end, bool first, std::vector<uint32_t>& sel) const;
+
+    // Whether some key lies in [min, max]
+    bool intersects(int64_t min, int64_t max) const;
+
+    // Whether every value in [min, max] is a key
+    bool covers(int64_t min, int64_t max) const;
+
+    size_t size() const { return sorted_.size(); }
+    const std::vector<int64_t>& keys() const { return sorted_; }  // Distinct, ascending
+    size_t memoryUsage() const;
+
+private:
+    template<typename T>
+    void selectKeys(const std::vector<T>& vals, size_t begin, size_t end, bool first, std::vector<uint32_t>& sel) const;
+
+    std::vector<int64_t> sorted_;  // Distinct keys, ascending
+    IntGroupTable table_;
+    BloomFilter bloom_;
+};
+
+// Integer keys known (from page stats) to lie in [min_key, min_key + range)
+// map straight to group id key - min_key: no hashing, no probing. Same
+// interface as the hash tables; every id in the range exists up front.
+class DirectGroupTable {
+public:
+    DirectGroupTable(int64_t min_key, size_t range);
+
+    template<typename T>
+    void findOrInsert(const std::vector<T>& keys, std::vector<uint32_t>& group_ids);
+
+    int64_t key(uint32_t group_id) const { return min_key_ + static_cast<int64_t>(group_id); }
+    size_t size() const { return range_; }
+
+private:
+    int64_t min_key_;
+    size_t range_;
+};
+
+// Group table for composite keys normalized into a fixed number of 64-bit
+// words per key, so probing compares integers instead of key tuples
+class PackedGroupTable {
+public:
+    explicit PackedGroupTable(size_t words_per_key);
+
+    // keys holds num_rows keys back to back, words_per_key words each
+    void findOrInsert(const std::vector<uint64_t>& keys, size_t num_rows, std::vector<uint32_t>& group_ids);
+
+    // Map each key to its group id, or NO_GROUP when it is not in the table
+    void find(const std::vector<uint64_t>& keys, size_t num_rows, std::vector<uint32_t>& group_ids) const;
+
+    const uint64_t* key(uint32_t group_id) const { return keys_.data() + group_id * words_per_key_; }
+    size_t size() const { return index_.size(); }
+    size_t wordsPerKey() const { return words_per_key_; }
+    size_t memoryUsage() const;
+
+private:
+    FlatGroupIndex index_;
+    size_t words_per_key_;
+    std::vector<uint64_t> keys_;
+};
+
+// Per-group aggregate state stored column-wise and indexed by group id.
+// min/max start at the int64 extremes so updates need no branches. With
+// moments set (variance and standard deviation) groups keep count, mean and
+// M2 instead, updated per row with Welford's method.
+struct GroupAggStates {
+    std::vector<int64_t> count;
+    std::vector<int64_t> sum;
+    std::vector<int64_t> sum_wraps;  // See addWrapping
+    std::vector<int64_t> min;
+    std::vector<int64_t> max;
+
+    bool moments = false;
+    std::vector<double> mean;
+    std::vector<double> m2;
+
+    void resize(size_t num_groups);
+    size_t memoryUsage() const;
+
+    // Group ids may be dense table ids or dictionary codes (INT32)
+    template<typename Id>
+    void updateCount(const std::vector<Id>& group_ids);
+
+    template<typename Id, typename T>
+    void update(const std::vector<Id>& group_ids, const std::vector<T>& values);
+
+    template<typename Id, typename T>
+    void updateMoments(const std::vector<Id>& group_ids, const std::vector<T>& values);
+
+    // Fold each non-empty group g of partial into group remap[g]
+    void merge(const GroupAggStates& partial, const std::vector<uint32_t>& remap);
+
+    // Fold group src of partial into group dst
+    void mergeGroup(const GroupAggStates& partial, uint32_t src, uint32_t dst) {
+        if (moments) {
+            mergeMoments(count[dst], mean[dst], m2[dst], partial.count[src], partial.mean[src], partial.m2[src]);
+        } else {
+            count[dst] += partial.count[src];
+        }
+        addWrapping(sum[dst], sum_wraps[dst], partial.sum[src]);
+        sum_wraps[dst] += partial.sum_wraps[src];
+        min[dst] = partial.min[src] < min[dst] ? partial.min[src] : min[dst];
+        max[dst] = partial.max[src] > max[dst] ? partial.max[src] : max[dst];
+    }
+
+    bool sumFitsInt64(uint32_t group_id) const { return sum_wraps[group_id] == 0; }
+
+    AggResult result(uint32_t group_id, AggFunc func) const;
+};
+
+// Template implementations
+
+template<typename Eq>
+uint32_t FlatGroupIndex::findOrInsert(uint64_t hash, Eq&& eq, bool& inserted) {
+    uint32_t found = find(hash, eq);
+    if (found != NO_GROUP) {
+        inserted = false;
+        return found;
+    }
+
+    uint32_t group_id = static_cast<uint32_t>(group_hashes_.size());
+    group_hashes_.push_back(hash);
+    if (group_hashes_.size() * 8 > ctrl_.size() * 7) {
+        grow();
+    } else {
+        insertSlot(hash, group_id);
+    }
+
+    inserted = true;
+    return group_id;
+}
+
+template<typename Eq>
+uint32_t FlatGroupIndex::find(uint64_t hash, Eq&& eq) const {
+    uint8_t tag = static_cast<uint8_t>(hash & 0x7F);
+    size_t group = (hash >> 7) & num_groups_mask_;
+
+    // Triangular probing over groups visits every group once
+    for (size_t step = 1;; step++) {
+        const uint8_t* ctrl = ctrl_.data() + group * GROUP_WIDTH;
+
+        for (uint32_t matches = matchTag(ctrl, tag); matches != 0; matches &= matches - 1) {
+            uint32_t group_id = slots_[group * GROUP_WIDTH + static_cast<size_t>(std::countr_zero(matches))];
+            if (group_hashes_[group_id] == hash && eq(group_id)) {
+                return group_id;
+            }
+        }
+
+        if (matchEmpty(ctrl) != 0) {
+            return NO_GROUP;
+        }
+        group = (group + step) & num_groups_mask_;
+    }
+}
+
+template<typename T>
+void IntGroupTable::findOrInsert(const std::vector<T>& keys, std::vector<uint32_t>& group_ids) {
+    hashColumn(keys, hashes_);
+    group_ids.resize(keys.size());
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        int64_t key = static_cast<int64_t>(keys[i]);
+
+        bool inserted = false;
+        uint32_t group_id = index_.findOrInsert(hashes_[i], [&](uint32_t g) {
+            return keys_[g] == key;
+        }, inserted);
+
+        if (inserted) {
+            keys_.push_back(key);
+        }
+        group_ids[i] = group_id;
+    }
+}
+
+template<typename T>
+void IntGroupTable::find(const std::vector<T>& keys, std::vector<uint32_t>& group_ids) {
+    hashColumn(keys, hashes_);
+    group_ids.resize(keys.size());
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        group_ids[i] = find(static_cast<int64_t>(keys[i]), hashes_[i]);
+    }
+}
+
+template<typename T>
+void DirectGroupTable::findOrInsert(const std::vector<T>& keys, std::vector<uint32_t>& group_ids) {
+    group_ids.resize(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        uint64_t offset = static_cast<uint64_t>(static_cast<int64_t>(keys[i])) - static_cast<uint64_t>(min_key_);
+        if (offset >= range_) {
+            throw std::runtime_error("Group key outside its page statistics range");
+        }
+        group_ids[i] = static_cast<uint32_t>(offset);
+    }
+}
+
+template<typename Id>
+void GroupAggStates::updateCount(const std::vector<Id>& group_ids) {
+    int64_t* counts = count.data();
+    for (Id g : group_ids) {
+        counts[g]++;
+    }
+}
+
+template<typename Id, typename T>
+void GroupAggStates::update(const std::vector<Id>& group_ids, const std::vector<T>& values) {
+    int64_t* counts = count.data();
+    int64_t* sums = sum.data();
+    int64_t* wraps = sum_wraps.data();
+    int64_t* mins = min.data();
+    int64_t* maxs = max.data();
+
+    for (size_t row = 0; row < group_ids.size(); row++) {
+        size_t g = static_cast<size_t>(group_ids[row]);
+        int64_t val = static_cast<int64_t>(values[row]);
+        counts[g]++;
+        addWrapping(sums[g], wraps[g], val);
+        mins[g] = val < mins[g] ? val : mins[g];
+        maxs[g] = val > maxs[g] ? val : maxs[g];
+    }
+}
+
+template<typename Id, typename T>
+void GroupAggStates::updateMoments(const std::vector<Id>& group_ids, const std::vector<T>& values) {
+    int64_t* counts = count.data();
+    double* means = mean.data();
+    double* m2s = m2.data();
+
+    for (size_t row = 0; row < group_ids.size(); row++) {
+        size_t g = static_cast<size_t>(group_ids[row]);
+        double val = static_cast<double>(values[row]);
+        int64_t n = ++counts[g];
+        double delta = val - means[g];
+        means[g] += delta / static_cast<double>(n);
+        m2s[g] += delta * (val - means[g]);
+    }
+}
+
+} // namespace columnar
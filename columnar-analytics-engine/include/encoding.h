@@ -47,6 +47,11 @@ public:
     // Decode from dictionary format
     static std::vector<std::string> decode(const uint8_t* data, size_t size, size_t num_values);
 
+    // Decode the dictionary and the per-row codes without materializing
+    // one string per row. Codes are checked against the dictionary size.
+    static std::vector<int32_t> decodeCodes(const uint8_t* data, size_t size, size_t num_values,
+                                            std::vector<std::string>& dictionary);
+
 private:
     std::unordered_map<std::string, uint32_t> dict_;
     std::vector<std::string> dict_values_;
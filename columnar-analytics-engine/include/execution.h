@@ -8,6 +8,7 @@
 #include <cstdint>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <variant>
 #include <functional>
@@ -27,12 +28,19 @@ struct Batch {
     std::vector<std::string> column_names;
     size_t num_rows;
 
+    // Dictionary of each column delivered as INT32 codes (null for columns
+    // holding values). Empty when no column holds codes.
+    std::vector<std::shared_ptr<const std::vector<std::string>>> dictionaries;
+
     template<typename T>
     const std::vector<T>& getColumn(size_t idx) const {
         return std::get<std::vector<T>>(columns[idx]);
     }
 
     size_t columnIndex(const std::string& name) const;
+
+    // Dictionary of a code column, or nullptr if the column holds values
+    const std::vector<std::string>* dictionary(size_t idx) const;
 };
 
 // Comparison operators for filters
@@ -42,57 +50,285 @@ enum class CompareOp {
     LT,  // <
     LE,  // <=
     GT,  // >
-    GE   // >=
+    GE,  // >=
+    IN,     // One of a set of keys, see Predicate::in
+    PREFIX  // Starts with a string, see Predicate::startsWith
 };
 
+// Outcome of checking a predicate against page statistics
+enum class StatsMatch {
+    NEVER,   // No row can match: the page can be skipped
+    MAYBE,   // Some rows may match: the page must be decoded
+    ALWAYS   // Every row matches: the page can be answered from its stats
+};
+
+class KeySet;
+
 // Predicate for filtering
 struct Predicate {
     std::string column;
     CompareOp op;
-    int64_t value;  // Only numeric predicates for MVP
+    int64_t value;  // Operand of a predicate on an integer column
+    std::shared_ptr<const KeySet> keys = nullptr;  // Keys of an IN predicate
+
+    // Operands of a predicate on a STRING column: the compared string, or
+    // the sorted values of an IN list
+    std::shared_ptr<const std::vector<std::string>> strings = nullptr;
+
+    // column IN (keys), for integer columns. Rows are tested a batch at a
+    // time against a Bloom filter and then a hash set of the keys; row
+    // groups whose min/max range holds no key are skipped.
+    static Predicate in(std::string column, std::vector<int64_t> keys);
+
+    // Predicates on STRING columns, comparing bytes lexicographically. On
+    // dictionary-encoded chunks they are evaluated once per dictionary
+    // entry, rows are then filtered by code, and a row group is skipped
+    // when no entry matches.
+    static Predicate compareString(std::string column, CompareOp op, std::string value);  // Any op but IN and PREFIX
+    static Predicate inStrings(std::string column, std::vector<std::string> values);
+    static Predicate startsWith(std::string column, std::string prefix);
+
+    bool onStrings() const { return strings != nullptr; }
 
     bool evaluate(int32_t col_value) const;
     bool evaluate(int64_t col_value) const;
+    bool evaluate(std::string_view col_value) const;
+
+    // Classify a page against the predicate based on stats
+    StatsMatch matchStats(const PageStats& stats) const;
 
     // Check if predicate can eliminate a page based on stats
     bool canSkipPage(const PageStats& stats) const;
 };
 
+// Boolean combination of predicates on integer and STRING columns. Against
+// stats it gives a three-valued verdict: NOT swaps NEVER and ALWAYS, AND is
+// NEVER if any child is and ALWAYS if all are, OR the other way round. Rows
+// are evaluated a leaf at a time into bitmaps that are combined word by word.
+class FilterExpr {
+public:
+    FilterExpr(Predicate pred);  // A single predicate
+
+    static FilterExpr allOf(std::vector<FilterExpr> children);  // AND (true if empty)
+    static FilterExpr anyOf(std::vector<FilterExpr> children);  // OR (false if empty)
+    static FilterExpr negate(FilterExpr child);                 // NOT
+    static FilterExpr between(std::string column, int64_t low, int64_t high);  // low <= column <= high
+
+    bool isPredicate() const { return kind_ == Kind::PREDICATE; }
+    const Predicate& predicate() const { return pred_; }
+    bool isConjunction() const { return kind_ == Kind::AND; }
+    const std::vector<FilterExpr>& children() const { return children_; }
+
+    // Append the columns the expression reads (with repeats)
+    void collectColumns(std::vector<std::string>& columns) const;
+
+    // Verdict from each column's stats; stats(column) may return nullptr
+    // for a column without stats
+    StatsMatch matchStats(const std::function<const PageStats*(const std::string&)>& stats) const;
+
+    // Evaluate rows [begin, end) of the columns returned by column(name):
+    // bit i of bits (word i / 64) tells whether row begin + i passes. A
+    // string leaf whose column is given as dictionary codes tests each
+    // code against code_matches(leaf), which flags the dictionary entries
+    // passing the leaf; it returns nullptr for columns given as strings.
+    void evaluate(const std::function<const Batch::ColumnData&(const std::string&)>& column,
+                  size_t begin, size_t end, std::vector<uint64_t>& bits,
+                  const std::function<const std::vector<uint8_t>*(const Predicate&)>& code_matches = nullptr) const;
+
+private:
+    enum class Kind { PREDICATE, AND, OR, NOT };
+
+    FilterExpr(Kind kind, std::vector<FilterExpr> children);
+
+    Kind kind_;
+    Predicate pred_;  // PREDICATE only
+    std::vector<FilterExpr> children_;
+};
+
 // Aggregation functions
 enum class AggFunc {
     COUNT,
     SUM,
     MIN,
-    MAX
+    MAX,
+    AVG,
+    VAR_POP,
+    VAR_SAMP,
+    STDDEV_POP,
+    STDDEV,      // Sample standard deviation, as in SQL
+    COUNT_DISTINCT,
+    APPROX_COUNT_DISTINCT  // HyperLogLog estimate, see setDistinctError
 };
 
+class HyperLogLog;
+
 // Aggregation result
+// count is always set (for functions of a column, the number of values);
+// sum, min and max are only guaranteed for the requested function, since
+// aggregates may be answered from page statistics (files written before
+// format 1.1 carry no sums). value holds the result of AVG, VAR_* and
+// STDDEV*, empty when there are too few values (none, or one for the
+// sample variants). A SUM that does not fit in int64 throws. distinct holds
+// the result of COUNT_DISTINCT and APPROX_COUNT_DISTINCT; the latter also
+// returns its sketch, which merges with sketches of other files. Row groups
+// answered from chunk sketches coarser than the requested error lower the
+// sketch to their precision, so sketch->relativeError() is the error of
+// the result.
 struct AggResult {
     int64_t count;
     int64_t sum;
     std::optional<int64_t> min;
     std::optional<int64_t> max;
+    std::optional<double> value;
+    std::optional<int64_t> distinct;
+    std::shared_ptr<const HyperLogLog> sketch;
+};
+
+// One aggregate of a multi-aggregate query. Its filters apply to this
+// aggregate only, on top of the query filters, like
+// SUM(column) FILTER (WHERE ...). COUNT counts rows and ignores column.
+struct AggSpec {
+    AggFunc func;
+    std::string column;
+    std::vector<Predicate> filters;
 };
 
 // Scanner: reads batches from file with optional filters
+// Each row group is decoded once and then emitted in slices of at most
+// batch_size rows, so a batch stays cache-sized regardless of row group size.
+// A batch may be empty when the filters reject every row of its slice.
 class Scanner {
 public:
     Scanner(std::shared_ptr<FileReader> reader,
             std::vector<std::string> columns,
             size_t batch_size = 4096);
 
+    // Filters on integer chunks with a column index narrow their row group
+    // to the blocks whose min/max may pass them, and only those blocks of
+    // seekable chunks are decoded. Filters on a sorted column chunk (see
+    // ChunkOrder) narrow the rows further by binary search, so rows outside
+    // the ranges are never compared. An expression's top-level AND is split
+    // into its operands.
     void addFilter(Predicate pred);
+    void addFilter(FilterExpr expr);
     bool hasNext();
     Batch next();
 
+    bool hasFilters() const;
+
+    // Row group of the batch last returned by next()
+    size_t currentRowGroup() const;
+
+    // Deliver a selected STRING column as dictionary codes (INT32) plus
+    // Batch::dictionaries in row groups where it is dictionary encoded,
+    // instead of decoding one string per row
+    void setDictionaryCodes(const std::string& column);
+
+    // Restrict the scan to the given row groups, visited in the given order
+    void setRowGroups(std::vector<size_t> row_groups);
+
+    // Skip up to num_rows rows of an unfiltered scan, returning how many were
+    // skipped. Whole row groups are skipped without being decoded.
+    size_t skipRows(size_t num_rows);
+
 private:
+    bool canSkipRowGroup(size_t rg_idx) const;
+
+    // Whether a point lookup (EQ or IN) finds none of its keys in the
+    // current row group's Bloom filter for its column
+    bool bloomSkipsRowGroup();
+
+    // Column index of a scanned column's chunk in the current row group,
+    // read on first use; nullptr if it has none
+    const ColumnIndex* columnIndex(size_t pos);
+
+    // Narrow rg_ranges_ to the blocks whose column index min/max may
+    // satisfy every filter
+    void applyColumnIndexes();
+
+    // Decode the current row group, or return false as soon as a Bloom
+    // filter rules it out, a string filter matches no entry of a
+    // dictionary-encoded chunk or the column indexes and sorted chunks
+    // leave no row in range
+    bool loadRowGroup();
+    void releaseRowGroup();
+
     std::shared_ptr<FileReader> reader_;
     std::vector<std::string> selected_columns_;
     std::vector<size_t> column_indices_;
     std::vector<Predicate> filters_;
+    std::vector<FilterExpr> exprs_;
     size_t batch_size_;
     size_t current_row_group_;
     size_t current_offset_;
+    std::vector<size_t> row_groups_;
+    size_t rg_cursor_;
+
+    // Decoded columns of the current row group: the selected columns first,
+    // followed by any filter-only columns
+    std::vector<size_t> scan_indices_;
+    std::vector<size_t> filter_positions_;
+    std::vector<Batch::ColumnData> rg_columns_;
+    std::vector<uint64_t> expr_bits_;
+    std::vector<std::vector<uint8_t>> rg_dict_matches_;  // Per string filter on dictionary codes: per entry
+    // Per string leaf of an expression on dictionary codes: per entry
+    std::vector<std::pair<const Predicate*, std::vector<uint8_t>>> rg_expr_matches_;
+    std::vector<std::pair<size_t, size_t>> rg_ranges_;  // Rows of the current row group in range
+    size_t rg_range_;                                   // Range being returned
+    std::vector<std::optional<ColumnIndex>> rg_indexes_;
+    std::vector<uint8_t> rg_indexes_read_;
+    std::vector<uint8_t> rg_settled_;  // Per filter: its rows are exactly the range
+    std::vector<std::shared_ptr<const std::vector<std::string>>> rg_dictionaries_;
+    std::vector<size_t> code_columns_;
+    bool rg_loaded_;
+};
+
+// Producer of result batches other than a plain scan, such as the merge
+// phase of an ORDER BY
+class BatchSource {
+public:
+    virtual ~BatchSource() = default;
+    virtual bool hasNext() = 0;
+    virtual Batch next() = 0;
+};
+
+// Run task(worker) for every worker id, each on its own thread (inline when
+// there is a single worker), and rethrow the first exception raised
+void runWorkers(size_t num_workers, const std::function<void(size_t)>& task);
+
+// Pull-based query result: batches are decoded only when requested, so
+// memory stays bounded by one row group however large the file is.
+// Empty batches are never returned. Stop pulling or call close() to end
+// the scan early; with a limit the scan ends by itself once it is reached.
+// A stream may also pull from a BatchSource, or hand out batches computed
+// up front.
+class ResultStream {
+public:
+    explicit ResultStream(std::unique_ptr<Scanner> scanner,
+                          std::optional<size_t> limit = std::nullopt,
+                          size_t offset = 0);
+    explicit ResultStream(std::unique_ptr<BatchSource> source,
+                          std::optional<size_t> limit = std::nullopt,
+                          size_t offset = 0);
+    explicit ResultStream(std::vector<Batch> batches);
+
+    bool hasNext();
+    Batch next();
+    void close();
+
+private:
+    std::unique_ptr<Scanner> scanner_;
+    std::unique_ptr<BatchSource> source_;
+    std::optional<Batch> pending_;
+    std::optional<size_t> limit_;  // Rows still to be returned
+    size_t offset_;                // Rows still to be dropped
+};
+
+// One GROUP BY output group: its key (one value per GROUP BY column,
+// rendered as a string) and one result per aggregate
+struct GroupResult {
+    std::vector<std::string> keys;
+    std::vector<AggResult> aggs;
 };
 
 // Query executor
@@ -103,20 +339,98 @@ public:
     // Configure query
     void setProjection(std::vector<std::string> columns);
     void addFilter(Predicate pred);
+    void addFilter(FilterExpr expr);
     void setAggregation(AggFunc func, std::string column);
+    void addAggregation(AggFunc func, std::string column, std::vector<Predicate> filters = {});
     void setGroupBy(std::string column);
+    void setGroupByColumns(std::vector<std::string> columns);  // Composite key
+    void setBatchSize(size_t batch_size);
+    void setLimit(size_t limit, size_t offset = 0);
+
+    // Order result rows by one column (ties keep file order). With a
+    // limit, the first limit + offset rows are kept in a bounded heap and
+    // row groups whose stats show they cannot reach it are skipped. Without
+    // one (or with a very large one) rows are sorted in runs bounded by the
+    // memory budget, spilled to the spill directory, and merged as the
+    // result is pulled.
+    void setOrderBy(std::string column, bool descending = false);
+
+    // Worker threads for aggregates and GROUP BY (0 = one per hardware
+    // thread). Row groups are the unit of work; composite GROUP BY keys
+    // are aggregated on one thread.
+    void setThreads(size_t num_threads);
+
+    // Bound on the memory of a GROUP BY's hash table and aggregate states
+    // (0 = unlimited). Past the budget, rows of new keys are spilled to
+    // temporary files under the spill directory (default: the system
+    // temporary directory) and aggregated afterwards, one partition at a
+    // time. This applies to single-column and composite keys alike. A
+    // budgeted GROUP BY runs on one thread; a single integer key with a
+    // small stats range is never spilled. The budget also bounds the
+    // sorted runs of an ORDER BY.
+    void setMemoryBudget(size_t bytes);
+    void setSpillDirectory(std::string path);
+
+    // Relative standard error of APPROX_COUNT_DISTINCT (default 0.01)
+    void setDistinctError(double relative_error);
 
     // Execute and return results
+    ResultStream executeStream();
     std::vector<Batch> executeQuery();
-    AggResult executeAggregate();
+    AggResult executeAggregate();  // First aggregate only
+
+    // All aggregates in one scan, one result per aggregate in the order added
+    std::vector<AggResult> executeAggregates();
+
+    // Groups are ordered by key: integers numerically, strings
+    // lexicographically, composite keys column by column. Distinct counts
+    // are not supported per group.
+    std::vector<GroupResult> executeGroupByAggregates();
+
+    // First aggregate only; composite keys are joined with '|'
     std::vector<std::pair<std::string, AggResult>> executeGroupBy();
 
+    // Rows written to spill files by the last GROUP BY or ORDER BY (0 if it
+    // fit in memory)
+    size_t spilledRows() const { return spilled_rows_; }
+
+    // Row groups the last ORDER BY ... LIMIT skipped from their stats
+    size_t prunedRowGroups() const { return pruned_row_groups_; }
+
 private:
+    // Combined verdict of the given filters against a row group's stats
+    StatsMatch matchRowGroup(size_t rg_idx, const std::vector<Predicate>& filters) const;
+    StatsMatch matchRowGroup(size_t rg_idx, const std::vector<FilterExpr>& filters) const;
+
+    // GROUP BY over several columns, packing each key into integer words
+    std::vector<GroupResult> executeCompositeGroupBy();
+
+    // ORDER BY ... LIMIT over the given scan columns
+    std::vector<Batch> executeTopN(std::vector<std::string> scan_columns);
+
+    // Full ORDER BY: sorted runs, spilled past the memory budget, merged
+    // lazily by the returned source
+    std::unique_ptr<BatchSource> executeSort(std::vector<std::string> scan_columns);
+
+    // Threads to use for num_tasks independent units of work
+    size_t workerCount(size_t num_tasks) const;
+
     std::shared_ptr<FileReader> reader_;
     std::vector<std::string> projection_;
-    std::vector<Predicate> filters_;
-    std::optional<std::pair<AggFunc, std::string>> aggregation_;
-    std::optional<std::string> group_by_column_;
+    std::vector<FilterExpr> filters_;
+    std::vector<AggSpec> aggregations_;
+    std::vector<std::string> group_by_columns_;
+    size_t batch_size_;
+    std::optional<size_t> limit_;
+    size_t offset_;
+    std::string order_by_;
+    bool order_descending_;
+    size_t pruned_row_groups_;
+    size_t num_threads_;
+    size_t memory_budget_;
+    std::string spill_directory_;
+    size_t spilled_rows_;
+    double distinct_error_;
 };
 
 } // namespace columnar
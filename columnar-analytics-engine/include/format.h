@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "sketch.h"
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -35,14 +36,80 @@ enum class EncodingType : uint8_t {
 constexpr uint32_t FILE_MAGIC = 0x454C4F43;  // "COLE" in little-endian
 constexpr uint32_t FOOTER_MAGIC = 0x464F4F54;  // "FOOT" in little-endian
 constexpr uint16_t FORMAT_VERSION_MAJOR = 1;
-constexpr uint16_t FORMAT_VERSION_MINOR = 0;
+constexpr uint16_t FORMAT_VERSION_MINOR = 6;  // 1.1: page stats carry a sum
+                                              // 1.2: and a distinct-count sketch
+                                              // 1.3: and string min/max bounds
+                                              // 1.4: column chunk Bloom filters
+                                              // 1.5: column chunk sort order
+                                              // 1.6: column indexes
+
+// Precision of the HyperLogLog sketch written per column chunk: 1 KiB of
+// registers, about 3% relative error
+constexpr unsigned DEFAULT_CHUNK_SKETCH_PRECISION = 10;
+
+// Bytes kept of the min/max statistics of string pages by default, and at
+// most
+constexpr size_t DEFAULT_STRING_STATS_LENGTH = 64;
+constexpr size_t MAX_STRING_STATS_LENGTH = 4096;
+
+// Signed 128-bit integer used for overflow-safe sums. Stored as two's
+// complement halves so it stays portable to compilers without __int128.
+struct Int128 {
+    uint64_t lo = 0;
+    int64_t hi = 0;
+
+    Int128() = default;
+    Int128(int64_t value)
+        : lo(static_cast<uint64_t>(value)), hi(value < 0 ? -1 : 0) {}
+
+    Int128& operator+=(const Int128& other) {
+        uint64_t new_lo = lo + other.lo;
+        uint64_t carry = new_lo < lo ? 1 : 0;
+        hi = static_cast<int64_t>(static_cast<uint64_t>(hi) + static_cast<uint64_t>(other.hi) + carry);
+        lo = new_lo;
+        return *this;
+    }
+
+    bool fitsInt64() const {
+        return hi == (static_cast<int64_t>(lo) < 0 ? -1 : 0);
+    }
+
+    int64_t toInt64() const {
+        return static_cast<int64_t>(lo);
+    }
+
+    // Negative values convert their magnitude: adding a huge lo to a
+    // negative hi * 2^64 would round lo before the two cancel
+    double toDouble() const {
+        if (fitsInt64()) {
+            return static_cast<double>(toInt64());
+        }
+        if (hi >= 0) {
+            return static_cast<double>(hi) * 18446744073709551616.0 + static_cast<double>(lo);
+        }
+        uint64_t neg_lo = ~lo + 1;
+        uint64_t neg_hi = ~static_cast<uint64_t>(hi) + (neg_lo == 0 ? 1 : 0);
+        return -(static_cast<double>(neg_hi) * 18446744073709551616.0 + static_cast<double>(neg_lo));
+    }
+
+    bool operator==(const Int128& other) const = default;
+};
 
 // Statistics for a page (enables predicate pushdown)
 struct PageStats {
     std::optional<int64_t> min_int;
     std::optional<int64_t> max_int;
+    std::optional<Int128> sum;  // Sum of all values (numeric columns only)
     uint32_t null_count;
     uint32_t distinct_count_estimate;  // Approximate, 0 if unknown
+    std::vector<uint8_t> distinct_sketch;  // Serialized HyperLogLog, empty if unknown
+
+    // Bounds of a string page's values, compared bytewise: min_string is a
+    // prefix of the smallest value, max_string the largest value or, when
+    // that was truncated, a short string sorting after it. Either may be
+    // missing even when the other is present.
+    std::optional<std::string> min_string;
+    std::optional<std::string> max_string;
 };
 
 // Column schema
@@ -69,11 +136,50 @@ struct PageHeader {
     PageStats stats;
 };
 
+// Order of a column chunk's values, detected by the writer (strings
+// compare bytewise). A chunk of equal values is ASCENDING.
+enum class ChunkOrder : uint8_t {
+    UNSORTED = 0,
+    ASCENDING = 1,
+    DESCENDING = 2
+};
+
 // Column chunk metadata (one per column in a row group)
 struct ColumnChunkMeta {
     uint64_t file_offset;
     uint64_t total_size;
     std::vector<PageHeader> page_headers;
+
+    // Split-block Bloom filter of the chunk's values, stored after the row
+    // group's column chunks (size 0: none)
+    uint64_t bloom_offset = 0;
+    uint32_t bloom_size = 0;
+
+    ChunkOrder sort_order = ChunkOrder::UNSORTED;
+
+    // Column index of the chunk, stored after the last row group (size 0:
+    // none)
+    uint64_t index_offset = 0;
+    uint32_t index_size = 0;
+};
+
+// Column index of an integer column chunk: a zone map with the min and max
+// of each block of rows_per_block rows (the last block may be shorter) and,
+// for encodings that can seek (PLAIN and DELTA), an offset index locating
+// each block in the encoded page
+struct ColumnIndex {
+    uint32_t rows_per_block = 0;
+    std::vector<int64_t> min_values;
+    std::vector<int64_t> max_values;
+
+    // Per block: the block's first value, and the position in the page data
+    // where decoding resumes for the block's next row (empty if the
+    // encoding cannot seek)
+    std::vector<int64_t> first_values;
+    std::vector<uint64_t> offsets;
+
+    size_t numBlocks() const { return min_values.size(); }
+    bool seekable() const { return !offsets.empty(); }
 };
 
 // Row group metadata
@@ -89,6 +195,13 @@ struct FileMetadata {
     uint32_t total_rows;
 };
 
+// Dictionary-encoded string column chunk: each distinct value once, plus
+// one code per row indexing into the dictionary
+struct DictionaryColumn {
+    std::vector<std::string> dictionary;
+    std::vector<int32_t> codes;
+};
+
 // Writer API
 class FileWriter {
 public:
@@ -100,6 +213,25 @@ public:
     void writeInt64Column(size_t col_idx, const std::vector<int64_t>& values);
     void writeStringColumn(size_t col_idx, const std::vector<std::string>& values);
 
+    // Precision of the per-chunk distinct-count sketches of columns written
+    // from now on; 0 writes no sketches
+    void setSketchPrecision(unsigned precision);
+
+    // Bytes kept of the min/max statistics of string columns written from
+    // now on (at most MAX_STRING_STATS_LENGTH); 0 writes none
+    void setStringStatsLength(size_t length);
+
+    // Write a Bloom filter of each chunk of a column from now on, sized for
+    // about the given false positive rate over the chunk's distinct values;
+    // 0 stops writing them. Point lookups (EQ and IN) skip row groups whose
+    // filter holds none of their keys.
+    void setBloomFilter(size_t col_idx, double false_positive_rate);
+
+    // Write a column index of every integer column chunk of the row groups
+    // written from now on, with blocks of rows_per_block rows; 0 (the
+    // default) writes none. Only allowed between row groups.
+    void setColumnIndex(uint32_t rows_per_block);
+
     // Flush current row group
     void flushRowGroup();
 
@@ -112,6 +244,8 @@ private:
 };
 
 // Reader API
+// Column reads may be issued from several threads at once: file access is
+// serialized internally and decoding runs in the calling thread.
 class FileReader {
 public:
     explicit FileReader(const std::string& path);
@@ -120,11 +254,39 @@ public:
     const Schema& schema() const;
     const FileMetadata& metadata() const;
 
+    // Page data bytes read from the file so far
+    uint64_t pageBytesRead() const;
+
     // Read a column chunk from a specific row group
     std::vector<int32_t> readInt32Column(size_t row_group_idx, size_t col_idx);
     std::vector<int64_t> readInt64Column(size_t row_group_idx, size_t col_idx);
     std::vector<std::string> readStringColumn(size_t row_group_idx, size_t col_idx);
 
+    // Read a DICTIONARY-encoded string column chunk without decoding the
+    // codes into strings
+    DictionaryColumn readDictionaryColumn(size_t row_group_idx, size_t col_idx);
+
+    // Distinct-count sketch of a column chunk, or of a whole column (the
+    // union of its chunks' sketches, at the coarsest chunk precision).
+    // Read from metadata only; empty if any chunk was written without one.
+    std::optional<HyperLogLog> distinctSketch(size_t row_group_idx, size_t col_idx) const;
+    std::optional<HyperLogLog> distinctSketch(size_t col_idx) const;
+
+    // Bloom filter of a column chunk, read from the file on each call; empty
+    // if the chunk was written without one
+    std::optional<BloomFilter> readBloomFilter(size_t row_group_idx, size_t col_idx);
+
+    // Column index of a column chunk, read from the file on each call;
+    // empty if the chunk was written without one
+    std::optional<ColumnIndex> readColumnIndex(size_t row_group_idx, size_t col_idx);
+
+    // Rows of blocks [first_block, end_block) of an integer column chunk,
+    // decoding only those blocks' bytes; the index must be seekable
+    std::vector<int32_t> readInt32Blocks(size_t row_group_idx, size_t col_idx, const ColumnIndex& index,
+                                         size_t first_block, size_t end_block);
+    std::vector<int64_t> readInt64Blocks(size_t row_group_idx, size_t col_idx, const ColumnIndex& index,
+                                         size_t first_block, size_t end_block);
+
 private:
     struct Impl;
     std::unique_ptr<Impl> impl_;
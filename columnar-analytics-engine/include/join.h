@@ -0,0 +1,83 @@
+// Columnar Analytics Engine
+// Author: RIAL Fares
+// Hash join of two columnar files
+
+#pragma once
+
+#include "execution.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace columnar {
+
+enum class JoinType {
+    INNER,  // Pairs of rows with equal keys
+    LEFT    // Every left row, paired with its matches if any
+};
+
+// Equi-join of two files on one key column each: integer keys (INT32 or
+// INT64, in any mix) or string keys on both sides.
+//
+// One side (the build side) is loaded into hash tables over its key; the
+// other (the probe side) is streamed, and each batch of it hashes its keys
+// in one pass before looking them up. Inner joins build on the file with
+// fewer rows; left joins build on the right file, whose rows are optional.
+// With several threads the build rows are split by key hash into
+// partitions whose tables are built in parallel, and probe row groups are
+// probed in parallel, a wave of one per thread at a time.
+//
+// Result batches hold the left columns followed by the right columns; a
+// right column named like a left column is renamed "right.<name>". Rows
+// come in probe side order, each probe row's matches in build side order.
+// There are no NULLs: in a left join, the right columns of a left row
+// without a match hold 0 or the empty string, and a last INT32 column
+// "matched" holds 1 for matched rows and 0 for the others.
+class HashJoin {
+public:
+    HashJoin(std::shared_ptr<FileReader> left, std::string left_key,
+             std::shared_ptr<FileReader> right, std::string right_key,
+             JoinType type = JoinType::INNER);
+
+    // Columns of each side in the result (default: all of them)
+    void setLeftColumns(std::vector<std::string> columns);
+    void setRightColumns(std::vector<std::string> columns);
+
+    // Filters applied to a side before it is joined
+    void addLeftFilter(Predicate pred);
+    void addRightFilter(Predicate pred);
+
+    void setBatchSize(size_t batch_size);
+
+    // Threads building and probing (0 = one per hardware thread)
+    void setThreads(size_t num_threads);
+
+    // Whether the hash tables are built over the left file
+    bool buildsOnLeft() const;
+
+    // Build the hash tables, then join as the result is pulled. For inner
+    // joins on integer keys, probe row groups whose key stats lie outside
+    // the build keys' range are skipped.
+    ResultStream execute();
+
+    // Rows loaded into the hash tables by the last execute()
+    size_t buildRows() const { return build_rows_; }
+
+private:
+    struct Side {
+        std::shared_ptr<FileReader> reader;
+        std::string key;
+        std::vector<std::string> columns;
+        std::vector<Predicate> filters;
+    };
+
+    Side left_;
+    Side right_;
+    JoinType type_;
+    size_t batch_size_;
+    size_t num_threads_;
+    size_t build_rows_;
+};
+
+} // namespace columnar
@@ -0,0 +1,117 @@
+// Columnar Analytics Engine
+// Author: RIAL Fares
+// Probabilistic sketches
+
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace columnar {
+
+// HyperLogLog distinct-count sketch over 64-bit hashes (hashInt64 or
+// hashBytes of the values). 2^precision one-byte registers give a relative
+// standard error of about 1.04 / sqrt(2^precision). Sketches of the same
+// precision merge losslessly, so partial sketches from threads, row groups
+// or files combine into the sketch of the union.
+class HyperLogLog {
+public:
+    static constexpr unsigned MIN_PRECISION = 4;
+    static constexpr unsigned MAX_PRECISION = 18;
+
+    explicit HyperLogLog(unsigned precision = 14);
+
+    // Smallest precision whose standard error is at most relative_error
+    static unsigned precisionForError(double relative_error);
+
+    void add(uint64_t hash) {
+        size_t index = static_cast<size_t>(hash >> (64 - precision_));
+        uint64_t rest = (hash << precision_) | (uint64_t{1} << (precision_ - 1));
+        uint8_t rank = static_cast<uint8_t>(std::countl_zero(rest) + 1);
+        registers_[index] = rank > registers_[index] ? rank : registers_[index];
+    }
+
+    void add(const std::vector<uint64_t>& hashes);
+
+    // Union with a sketch of the same precision
+    void merge(const HyperLogLog& other);
+
+    // The sketch the same values would give at a lower precision, so
+    // sketches of different precisions can be merged at the coarser one
+    HyperLogLog reduce(unsigned precision) const;
+
+    double estimate() const;
+    unsigned precision() const { return precision_; }
+
+    // Relative standard error of estimate() at this precision
+    double relativeError() const;
+
+    // precision byte followed by the registers
+    std::vector<uint8_t> serialize() const;
+    static HyperLogLog deserialize(const uint8_t* data, size_t size);
+
+private:
+    unsigned precision_;
+    std::vector<uint8_t> registers_;
+};
+
+// Split-block Bloom filter (the layout Parquet uses) over 64-bit hashes:
+// 256-bit blocks of eight 32-bit words. The high half of a hash picks a
+// block and the low half sets one bit in each of its words, so a lookup
+// reads one cache line and its eight bit tests compile to vector code.
+// No false negatives; at 10 bits per key about 1% false positives.
+class BloomFilter {
+public:
+    static constexpr size_t WORDS_PER_BLOCK = 8;
+
+    // Sized for num_keys keys at bits_per_key bits each (one block at least)
+    explicit BloomFilter(size_t num_keys, double bits_per_key = 10.0);
+
+    // Bits per key giving about the given false positive rate (in (0, 1))
+    static double bitsPerKey(double false_positive_rate);
+
+    void add(uint64_t hash) {
+        uint32_t* block = words_.data() + blockIndex(hash) * WORDS_PER_BLOCK;
+        for (size_t i = 0; i < WORDS_PER_BLOCK; i++) {
+            block[i] |= bitMask(static_cast<uint32_t>(hash), i);
+        }
+    }
+
+    bool mayContain(uint64_t hash) const {
+        const uint32_t* block = words_.data() + blockIndex(hash) * WORDS_PER_BLOCK;
+        uint32_t missing = 0;
+        for (size_t i = 0; i < WORDS_PER_BLOCK; i++) {
+            missing |= ~block[i] & bitMask(static_cast<uint32_t>(hash), i);
+        }
+        return missing == 0;
+    }
+
+    size_t numBlocks() const { return words_.size() / WORDS_PER_BLOCK; }
+    size_t memoryUsage() const { return words_.capacity() * sizeof(uint32_t); }
+
+    // The words, little-endian: 32 bytes per block
+    std::vector<uint8_t> serialize() const;
+    static BloomFilter deserialize(const uint8_t* data, size_t size);
+
+private:
+    BloomFilter() = default;
+
+    static constexpr uint32_t SALT[WORDS_PER_BLOCK] = {
+        0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+        0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+    };
+
+    size_t blockIndex(uint64_t hash) const {
+        return static_cast<size_t>(((hash >> 32) * numBlocks()) >> 32);
+    }
+
+    static uint32_t bitMask(uint32_t key, size_t i) {
+        return uint32_t{1} << ((key * SALT[i]) >> 27);
+    }
+
+    std::vector<uint32_t> words_;
+};
+
+} // namespace columnar
@@ -0,0 +1,147 @@
+// Columnar Analytics Engine
+// Author: RIAL Fares
+// Sorting primitives
+
+#pragma once
+
+#include "execution.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace columnar {
+
+// Row order of ORDER BY: by key (ascending or descending), ties in file
+// order. position is the row's place in the file, (row group << 32) plus
+// its index among the row group's rows that passed the filters.
+template<typename Key>
+struct SortOrder {
+    bool descending = false;
+
+    bool before(const Key& a, uint64_t a_position, const Key& b, uint64_t b_position) const {
+        if (a != b) {
+            return descending ? b < a : a < b;
+        }
+        return a_position < b_position;
+    }
+};
+
+inline uint64_t rowPosition(size_t row_group, size_t row) {
+    return (static_cast<uint64_t>(row_group) << 32) | static_cast<uint64_t>(row);
+}
+
+// Sort keys normalized to unsigned integers whose order is the requested
+// order: integers exactly, strings by their first 8 bytes (ties between
+// equal prefixes are broken on the full strings)
+inline uint64_t normalizeKey(int64_t key, bool descending) {
+    uint64_t normalized = static_cast<uint64_t>(key) ^ (uint64_t{1} << 63);
+    return descending ? ~normalized : normalized;
+}
+
+inline uint64_t normalizeKey(std::string_view key, bool descending) {
+    unsigned char prefix[8] = {};
+    std::memcpy(prefix, key.data(), std::min<size_t>(key.size(), sizeof(prefix)));
+    uint64_t normalized = 0;
+    for (unsigned char byte : prefix) {
+        normalized = (normalized << 8) | byte;
+    }
+    return descending ? ~normalized : normalized;
+}
+
+// Stable LSD radix sort of row ids 0..keys.size()-1 by normalized key, one
+// byte per pass; passes where every key has the same byte are skipped
+void radixSortRows(const std::vector<uint64_t>& keys, std::vector<uint32_t>& rows);
+
+// Tournament tree of losers for merging k sorted sources: each internal
+// node holds the loser of its match, so after the winner's source
+// advances only its leaf-to-root path is replayed (log2(k) comparisons).
+// before(a, b) tells whether source a's current row precedes source b's;
+// an exhausted source must precede no other.
+template<typename Before>
+class LoserTree {
+public:
+    LoserTree(size_t num_sources, Before before)
+        : k_(num_sources), tree_(std::max<size_t>(num_sources, 1)), before_(std::move(before)) {
+        std::vector<size_t> winners(2 * k_);
+        for (size_t i = 0; i < k_; i++) {
+            winners[k_ + i] = i;
+        }
+        for (size_t node = k_ - 1; node >= 1 && k_ > 1; node--) {
+            size_t a = winners[2 * node];
+            size_t b = winners[2 * node + 1];
+            bool b_wins = before_(b, a);
+            winners[node] = b_wins ? b : a;
+            tree_[node] = b_wins ? a : b;
+        }
+        tree_[0] = k_ > 1 ? winners[1] : 0;
+    }
+
+    size_t winner() const { return tree_[0]; }
+
+    // Call after the winner's source advanced
+    void replay() {
+        size_t winner = tree_[0];
+        for (size_t node = (winner + k_) / 2; node >= 1; node /= 2) {
+            if (before_(tree_[node], winner)) {
+                std::swap(tree_[node], winner);
+            }
+        }
+        tree_[0] = winner;
+    }
+
+private:
+    size_t k_;
+    std::vector<size_t> tree_;  // tree_[0]: winner, tree_[1..k-1]: losers
+    Before before_;
+};
+
+// First n rows of a SortOrder, kept in a bounded heap whose top is the
+// last row kept. Rows that enter the heap are copied into a row store,
+// which is compacted once evicted rows make up most of it. Key is int64_t
+// for integer key columns and std::string for string key columns.
+template<typename Key>
+class TopN {
+public:
+    TopN(size_t n, SortOrder<Key> order);
+
+    bool full() const { return heap_.size() == n_; }
+
+    // Whether a row with this key and position would be kept: once the
+    // heap is full, whether it comes before the last row kept
+    bool admits(const Key& key, uint64_t position) const;
+
+    // Offer every row of a batch; row i is at first_position + i
+    void add(const Batch& batch, size_t key_column, uint64_t first_position);
+
+    // Kept rows in order, skipping the first offset, in batches of at most
+    // batch_size rows
+    std::vector<Batch> finish(size_t offset, size_t batch_size);
+
+private:
+    struct Entry {
+        Key key;
+        uint64_t position;
+        uint32_t row;  // Index into the row store
+    };
+
+    bool entryBefore(const Entry& a, const Entry& b) const {
+        return order_.before(a.key, a.position, b.key, b.position);
+    }
+
+    void offer(Key key, uint64_t position, std::vector<uint32_t>& sel, uint32_t batch_row);
+    void compact();
+
+    size_t n_;
+    SortOrder<Key> order_;
+    std::vector<Entry> heap_;
+
+    std::vector<Batch::ColumnData> store_;
+    std::vector<std::string> column_names_;
+    size_t store_rows_ = 0;
+};
+
+} // namespace columnar
@@ -0,0 +1,393 @@
+// Columnar Analytics Engine
+// Author: RIAL Fares
+// Hash aggregation implementation
+
+#include "aggregation.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COLUMNAR_HAVE_SSE2 1
+#endif
+
+namespace columnar {
+
+// Hashing (murmur3 finalizer for integers, word-at-a-time mixing for bytes)
+uint64_t hashInt64(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDULL;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+uint64_t hashBytes(const char* data, size_t len) {
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ len;
+
+    size_t pos = 0;
+    for (; pos + 8 <= len; pos += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + pos, sizeof(word));
+        h ^= word * 0xBF58476D1CE4E5B9ULL;
+        h = std::rotl(h, 27) * 0x94D049BB133111EBULL;
+    }
+
+    if (pos < len) {
+        uint64_t word = 0;
+        std::memcpy(&word, data + pos, len - pos);
+        h ^= word * 0xBF58476D1CE4E5B9ULL;
+        h = std::rotl(h, 27) * 0x94D049BB133111EBULL;
+    }
+
+    return hashInt64(h);
+}
+
+uint64_t hashWords(const uint64_t* words, size_t num_words) {
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ num_words;
+    for (size_t i = 0; i < num_words; i++) {
+        h ^= words[i] * 0xBF58476D1CE4E5B9ULL;
+        h = std::rotl(h, 27) * 0x94D049BB133111EBULL;
+    }
+    return hashInt64(h);
+}
+
+void hashColumn(const std::vector<std::string>& values, std::vector<uint64_t>& hashes) {
+    hashes.resize(values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        hashes[i] = hashBytes(values[i].data(), values[i].size());
+    }
+}
+
+void hashColumn(const std::vector<int32_t>& values, std::vector<uint64_t>& hashes) {
+    hashes.resize(values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        hashes[i] = hashInt64(static_cast<uint64_t>(static_cast<int64_t>(values[i])));
+    }
+}
+
+void hashColumn(const std::vector<int64_t>& values, std::vector<uint64_t>& hashes) {
+    hashes.resize(values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        hashes[i] = hashInt64(static_cast<uint64_t>(values[i]));
+    }
+}
+
+std::optional<double> aggregateValue(AggFunc func, int64_t count, const Int128& sum, double m2) {
+    double n = static_cast<double>(count);
+    switch (func) {
+    case AggFunc::AVG:
+        return count > 0 ? std::optional<double>(sum.toDouble() / n) : std::nullopt;
+    case AggFunc::VAR_POP:
+        return count > 0 ? std::optional<double>(m2 / n) : std::nullopt;
+    case AggFunc::VAR_SAMP:
+        return count > 1 ? std::optional<double>(m2 / (n - 1)) : std::nullopt;
+    case AggFunc::STDDEV_POP:
+        return count > 0 ? std::optional<double>(std::sqrt(m2 / n)) : std::nullopt;
+    case AggFunc::STDDEV:
+        return count > 1 ? std::optional<double>(std::sqrt(m2 / (n - 1))) : std::nullopt;
+    default:
+        return std::nullopt;
+    }
+}
+
+// FlatGroupIndex
+FlatGroupIndex::FlatGroupIndex()
+    : ctrl_(GROUP_WIDTH, EMPTY)
+    , slots_(GROUP_WIDTH, 0)
+    , num_groups_mask_(0) {}
+
+uint32_t FlatGroupIndex::matchTag(const uint8_t* ctrl, uint8_t tag) {
+#ifdef COLUMNAR_HAVE_SSE2
+    __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+    __m128i cmp = _mm_cmpeq_epi8(group, _mm_set1_epi8(static_cast<char>(tag)));
+    return static_cast<uint32_t>(_mm_movemask_epi8(cmp));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < GROUP_WIDTH; i++) {
+        mask |= static_cast<uint32_t>(ctrl[i] == tag) << i;
+    }
+    return mask;
+#endif
+}
+
+uint32_t FlatGroupIndex::matchEmpty(const uint8_t* ctrl) {
+#ifdef COLUMNAR_HAVE_SSE2
+    // EMPTY is the only control byte with the high bit set
+    __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+    return static_cast<uint32_t>(_mm_movemask_epi8(group));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < GROUP_WIDTH; i++) {
+        mask |= static_cast<uint32_t>(ctrl[i] == EMPTY) << i;
+    }
+    return mask;
+#endif
+}
+
+size_t FlatGroupIndex::memoryUsage() const {
+    return ctrl_.capacity() + slots_.capacity() * sizeof(uint32_t) +
+           group_hashes_.capacity() * sizeof(uint64_t);
+}
+
+void FlatGroupIndex::insertSlot(uint64_t hash, uint32_t group_id) {
+    size_t group = (hash >> 7) & num_groups_mask_;
+
+    for (size_t step = 1;; step++) {
+        uint32_t empty = matchEmpty(ctrl_.data() + group * GROUP_WIDTH);
+        if (empty != 0) {
+            size_t slot = group * GROUP_WIDTH + static_cast<size_t>(std::countr_zero(empty));
+            ctrl_[slot] = static_cast<uint8_t>(hash & 0x7F);
+            slots_[slot] = group_id;
+            return;
+        }
+        group = (group + step) & num_groups_mask_;
+    }
+}
+
+void FlatGroupIndex::grow() {
+    size_t capacity = ctrl_.size() * 2;
+    if (capacity > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("Group table capacity exceeded");
+    }
+
+    ctrl_.assign(capacity, EMPTY);
+    slots_.assign(capacity, 0);
+    num_groups_mask_ = capacity / GROUP_WIDTH - 1;
+
+    for (size_t group_id = 0; group_id < group_hashes_.size(); group_id++) {
+        insertSlot(group_hashes_[group_id], static_cast<uint32_t>(group_id));
+    }
+}
+
+// StringGroupTable
+void StringGroupTable::findOrInsert(const std::vector<std::string>& keys,
+                                    std::vector<uint32_t>& group_ids) {
+    hashColumn(keys, hashes_);
+    group_ids.resize(keys.size());
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        const std::string& key = keys[i];
+
+        bool inserted = false;
+        uint32_t group_id = index_.findOrInsert(hashes_[i], [&](uint32_t g) { return keyEquals(g, key); }, inserted);
+
+        if (inserted) {
+            key_offsets_.push_back(arena_.size());
+            key_lengths_.push_back(static_cast<uint32_t>(key.size()));
+            arena_.insert(arena_.end(), key.begin(), key.end());
+        }
+
+        group_ids[i] = group_id;
+    }
+}
+
+void StringGroupTable::find(const std::vector<std::string>& keys, std::vector<uint32_t>& group_ids) {
+    hashColumn(keys, hashes_);
+    group_ids.resize(keys.size());
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        group_ids[i] = find(keys[i], hashes_[i]);
+    }
+}
+
+bool StringGroupTable::keyEquals(uint32_t group_id, std::string_view key) const {
+    return key_lengths_[group_id] == key.size() &&
+           (key.empty() || std::memcmp(arena_.data() + key_offsets_[group_id], key.data(), key.size()) == 0);
+}
+
+size_t StringGroupTable::memoryUsage() const {
+    return index_.memoryUsage() + arena_.capacity() + key_offsets_.capacity() * sizeof(uint64_t) +
+           key_lengths_.capacity() * sizeof(uint32_t) + hashes_.capacity() * sizeof(uint64_t);
+}
+
+std::string_view StringGroupTable::key(uint32_t group_id) const {
+    return std::string_view(arena_.data() + key_offsets_[group_id], key_lengths_[group_id]);
+}
+
+// IntGroupTable
+size_t IntGroupTable::memoryUsage() const {
+    return index_.memoryUsage() + (keys_.capacity() + hashes_.capacity()) * sizeof(int64_t);
+}
+
+// KeySet
+KeySet::KeySet(std::vector<int64_t> keys)
+    : sorted_(std::move(keys))
+    , bloom_(0) {
+    std::sort(sorted_.begin(), sorted_.end());
+    sorted_.erase(std::unique(sorted_.begin(), sorted_.end()), sorted_.end());
+
+    std::vector<uint32_t> group_ids;
+    table_.findOrInsert(sorted_, group_ids);
+    bloom_ = BloomFilter(sorted_.size());
+    for (int64_t key : sorted_) {
+        bloom_.add(hashInt64(static_cast<uint64_t>(key)));
+    }
+}
+
+void KeySet::select(const std::vector<int32_t>& vals, size_t begin, size_t end, bool first,
+                    std::vector<uint32_t>& sel) const {
+    selectKeys(vals, begin, end, first, sel);
+}
+
+void KeySet::select(const std::vector<int64_t>& vals, size_t begin, size_t end, bool first,
+                    std::vector<uint32_t>& sel) const {
+    selectKeys(vals, begin, end, first, sel);
+}
+
+template<typename T>
+void KeySet::selectKeys(const std::vector<T>& vals, size_t begin, size_t end, bool first,
+                        std::vector<uint32_t>& sel) const {
+    // Rows are hashed a block at a time in one tight loop, then tested:
+    // the Bloom filter drops most rows before the hash table is read
+    constexpr size_t BLOCK = 256;
+    uint64_t hashes[BLOCK];
+
+    if (first) {
+        sel.clear();
+        for (size_t base = begin; base < end; base += BLOCK) {
+            size_t n = std::min(BLOCK, end - base);
+            for (size_t i = 0; i < n; i++) {
+                hashes[i] = hashInt64(static_cast<uint64_t>(static_cast<int64_t>(vals[base + i])));
+            }
+            for (size_t i = 0; i < n; i++) {
+                if (contains(static_cast<int64_t>(vals[base + i]), hashes[i])) {
+                    sel.push_back(static_cast<uint32_t>(base + i));
+                }
+            }
+        }
+        return;
+    }
+
+    size_t kept = 0;
+    for (size_t base = 0; base < sel.size(); base += BLOCK) {
+        size_t n = std::min(BLOCK, sel.size() - base);
+        for (size_t i = 0; i < n; i++) {
+            hashes[i] = hashInt64(static_cast<uint64_t>(static_cast<int64_t>(vals[sel[base + i]])));
+        }
+        for (size_t i = 0; i < n; i++) {
+            uint32_t row = sel[base + i];
+            if (contains(static_cast<int64_t>(vals[row]), hashes[i])) {
+                sel[kept++] = row;
+            }
+        }
+    }
+    sel.resize(kept);
+}
+
+bool KeySet::intersects(int64_t min, int64_t max) const {
+    auto it = std::lower_bound(sorted_.begin(), sorted_.end(), min);
+    return it != sorted_.end() && *it <= max;
+}
+
+bool KeySet::covers(int64_t min, int64_t max) const {
+    if (min > max) {
+        return false;
+    }
+    auto lo = std::lower_bound(sorted_.begin(), sorted_.end(), min);
+    auto hi = std::upper_bound(lo, sorted_.end(), max);
+    uint64_t span = static_cast<uint64_t>(max) - static_cast<uint64_t>(min);
+    return static_cast<uint64_t>(hi - lo) > span;
+}
+
+size_t KeySet::memoryUsage() const {
+    return sorted_.capacity() * sizeof(int64_t) + table_.memoryUsage() + bloom_.memoryUsage();
+}
+
+// DirectGroupTable
+DirectGroupTable::DirectGroupTable(int64_t min_key, size_t range)
+    : min_key_(min_key)
+    , range_(range) {}
+
+// PackedGroupTable
+PackedGroupTable::PackedGroupTable(size_t words_per_key)
+    : words_per_key_(words_per_key) {
+    if (words_per_key_ == 0) {
+        throw std::runtime_error("Packed group keys need at least one word");
+    }
+}
+
+void PackedGroupTable::findOrInsert(const std::vector<uint64_t>& keys, size_t num_rows,
+                                    std::vector<uint32_t>& group_ids) {
+    group_ids.resize(num_rows);
+
+    for (size_t i = 0; i < num_rows; i++) {
+        const uint64_t* key_words = keys.data() + i * words_per_key_;
+        uint64_t hash = words_per_key_ == 1 ? hashInt64(key_words[0]) : hashWords(key_words, words_per_key_);
+
+        bool inserted = false;
+        uint32_t group_id = index_.findOrInsert(hash, [&](uint32_t g) {
+            return std::equal(key_words, key_words + words_per_key_, keys_.data() + g * words_per_key_);
+        }, inserted);
+
+        if (inserted) {
+            keys_.insert(keys_.end(), key_words, key_words + words_per_key_);
+        }
+        group_ids[i] = group_id;
+    }
+}
+
+void PackedGroupTable::find(const std::vector<uint64_t>& keys, size_t num_rows,
+                            std::vector<uint32_t>& group_ids) const {
+    group_ids.resize(num_rows);
+
+    for (size_t i = 0; i < num_rows; i++) {
+        const uint64_t* key_words = keys.data() + i * words_per_key_;
+        uint64_t hash = words_per_key_ == 1 ? hashInt64(key_words[0]) : hashWords(key_words, words_per_key_);
+        group_ids[i] = index_.find(hash, [&](uint32_t g) {
+            return std::equal(key_words, key_words + words_per_key_, keys_.data() + g * words_per_key_);
+        });
+    }
+}
+
+size_t PackedGroupTable::memoryUsage() const {
+    return index_.memoryUsage() + keys_.capacity() * sizeof(uint64_t);
+}
+
+// GroupAggStates
+void GroupAggStates::resize(size_t num_groups) {
+    count.resize(num_groups, 0);
+    sum.resize(num_groups, 0);
+    sum_wraps.resize(num_groups, 0);
+    min.resize(num_groups, std::numeric_limits<int64_t>::max());
+    max.resize(num_groups, std::numeric_limits<int64_t>::min());
+    if (moments) {
+        mean.resize(num_groups, 0.0);
+        m2.resize(num_groups, 0.0);
+    }
+}
+
+size_t GroupAggStates::memoryUsage() const {
+    return (count.capacity() + sum.capacity() + sum_wraps.capacity() + min.capacity() + max.capacity()) *
+               sizeof(int64_t) +
+           (mean.capacity() + m2.capacity()) * sizeof(double);
+}
+
+void GroupAggStates::merge(const GroupAggStates& partial, const std::vector<uint32_t>& remap) {
+    for (size_t g = 0; g < partial.count.size(); g++) {
+        if (partial.count[g] == 0) {
+            continue;
+        }
+        mergeGroup(partial, static_cast<uint32_t>(g), remap[g]);
+    }
+}
+
+AggResult GroupAggStates::result(uint32_t group_id, AggFunc func) const {
+    AggResult r{};
+    r.count = count[group_id];
+    r.sum = sum[group_id];
+    if (func != AggFunc::COUNT && !moments && r.count > 0) {
+        r.min = min[group_id];
+        r.max = max[group_id];
+    }
+    r.value = aggregateValue(func, r.count, wrappedSum(sum[group_id], sum_wraps[group_id]),
+                             moments ? m2[group_id] : 0.0);
+    return r;
+}
+
+} // namespace columnar
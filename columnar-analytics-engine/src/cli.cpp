@@ -4,12 +4,17 @@
 
 #include "format.h"
 #include "execution.h"
+#include "join.h"
 #include <iostream>
 #include <string>
 #include <vector>
 #include <random>
 #include <cstring>
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <type_traits>
 
 using namespace columnar;
 
@@ -19,11 +24,36 @@ void printUsage(const char* prog) {
     std::cerr << "  write <output.col> <num_rows> [seed]  - Generate and write synthetic dataset\n";
     std::cerr << "  scan <input.col>                      - Display file metadata and stats\n";
     std::cerr << "  query <input.col> [options]           - Execute query\n";
+    std::cerr << "  join <left.col> <right.col> <left_key> <right_key> [options]\n";
+    std::cerr << "                                        - Hash join two files on a key column each\n";
     std::cerr << "\nQuery options:\n";
     std::cerr << "  --select <col1,col2,...>              - Project specific columns\n";
-    std::cerr << "  --where <column> <op> <value>         - Filter (op: eq, lt, le, gt, ge)\n";
-    std::cerr << "  --agg <func> <column>                 - Aggregate (func: count, sum, min, max)\n";
-    std::cerr << "  --groupby <column>                    - Group by column\n";
+    std::cerr << "  --where <column> <op> <value>         - Filter (op: eq, ne, lt, le, gt, ge, in with a\n";
+    std::cerr << "                                          comma-separated value list, between with\n";
+    std::cerr << "                                          <low>,<high>, or prefix on STRING columns)\n";
+    std::cerr << "  --or <column> <op> <value>            - Alternative to the preceding --where (or --or)\n";
+    std::cerr << "  --semi-join <column> <other.col> <key>\n";
+    std::cerr << "                                        - Keep rows whose column value is a key of another file\n";
+    std::cerr << "  --agg <func> <column>                 - Aggregate (count, sum, min, max, avg, var_pop,\n";
+    std::cerr << "                                          var_samp, stddev_pop, stddev, count_distinct,\n";
+    std::cerr << "                                          approx_count_distinct), repeatable\n";
+    std::cerr << "  --agg-where <column> <op> <value>     - Filter applying to the preceding --agg only\n";
+    std::cerr << "  --groupby <col1,col2,...>             - Group by one or more columns\n";
+    std::cerr << "  --limit <n>                           - Return at most n rows\n";
+    std::cerr << "  --offset <n>                          - Skip the first n rows (with --limit or alone)\n";
+    std::cerr << "  --orderby <column> [--desc]           - Order rows by a column (external sort under\n";
+    std::cerr << "                                          --memory-budget; top-N heap with --limit)\n";
+    std::cerr << "  --threads <n>                         - Aggregation worker threads (0 = all cores, default 1)\n";
+    std::cerr << "  --memory-budget <bytes>               - Spill GROUP BY state (single or composite keys) to\n";
+    std::cerr << "                                          disk beyond this size, on one thread\n";
+    std::cerr << "  --spill-dir <path>                    - Directory for spill files (default: system temp)\n";
+    std::cerr << "  --distinct-error <e>                  - Relative error of approx_count_distinct (default 0.01;\n";
+    std::cerr << "                                          0.04 or more is answered from file metadata)\n";
+    std::cerr << "\nJoin options:\n";
+    std::cerr << "  --left                                - Keep left rows without a match (adds a matched column)\n";
+    std::cerr << "  --select-left <col1,col2,...>         - Left columns in the result (default: all)\n";
+    std::cerr << "  --select-right <col1,col2,...>        - Right columns in the result (default: all)\n";
+    std::cerr << "  --threads <n>                         - Build and probe threads (0 = all cores, default 1)\n";
 }
 
 Schema createSyntheticSchema() {
@@ -126,7 +156,8 @@ void scanFile(const std::string& input_path) {
     std::cout << "Row groups: " << metadata.row_groups.size() << "\n\n";
 
     std::cout << "Schema:\n";
-    for (const auto& col : metadata.schema.columns) {
+    for (size_t i = 0; i < metadata.schema.columns.size(); i++) {
+        const auto& col = metadata.schema.columns[i];
         std::cout << "  - " << col.name << " (type=";
         switch (col.type) {
         case ColumnType::INT32: std::cout << "INT32"; break;
@@ -140,6 +171,10 @@ void scanFile(const std::string& input_path) {
         case EncodingType::DELTA: std::cout << "DELTA"; break;
         case EncodingType::DICTIONARY: std::cout << "DICTIONARY"; break;
         }
+        auto sketch = reader.distinctSketch(i);
+        if (sketch.has_value()) {
+            std::cout << ", distinct~" << std::llround(sketch->estimate());
+        }
         std::cout << ")\n";
     }
 
@@ -153,6 +188,15 @@ void scanFile(const std::string& input_path) {
             std::cout << "    Column " << metadata.schema.columns[j].name << ":\n";
             std::cout << "      Offset: " << cc.file_offset << "\n";
             std::cout << "      Size: " << cc.total_size << " bytes\n";
+            if (cc.bloom_size != 0) {
+                std::cout << "      Bloom filter: " << cc.bloom_size << " bytes\n";
+            }
+            if (cc.sort_order != ChunkOrder::UNSORTED) {
+                std::cout << "      Sorted: " << (cc.sort_order == ChunkOrder::ASCENDING ? "ascending" : "descending") << "\n";
+            }
+            if (cc.index_size != 0) {
+                std::cout << "      Column index: " << cc.index_size << " bytes\n";
+            }
 
             for (size_t k = 0; k < cc.page_headers.size(); k++) {
                 const auto& ph = cc.page_headers[k];
@@ -163,6 +207,18 @@ void scanFile(const std::string& input_path) {
                     std::cout << ", min=" << ph.stats.min_int.value();
                     std::cout << ", max=" << ph.stats.max_int.value();
                 }
+                if (ph.stats.min_string.has_value()) {
+                    std::cout << ", min='" << ph.stats.min_string.value() << "'";
+                }
+                if (ph.stats.max_string.has_value()) {
+                    std::cout << ", max='" << ph.stats.max_string.value() << "'";
+                }
+                if (ph.stats.sum.has_value() && ph.stats.sum->fitsInt64()) {
+                    std::cout << ", sum=" << ph.stats.sum->toInt64();
+                }
+                if (ph.stats.distinct_count_estimate != 0) {
+                    std::cout << ", distinct~" << ph.stats.distinct_count_estimate;
+                }
                 std::cout << "\n";
             }
         }
@@ -176,17 +232,83 @@ CompareOp parseCompareOp(const std::string& op) {
     if (op == "le") return CompareOp::LE;
     if (op == "gt") return CompareOp::GT;
     if (op == "ge") return CompareOp::GE;
+    if (op == "in") return CompareOp::IN;
+    if (op == "prefix") return CompareOp::PREFIX;
     throw std::runtime_error("Invalid comparison operator: " + op);
 }
 
+std::string formatCompareOp(CompareOp op) {
+    switch (op) {
+    case CompareOp::EQ: return "eq";
+    case CompareOp::NE: return "ne";
+    case CompareOp::LT: return "lt";
+    case CompareOp::LE: return "le";
+    case CompareOp::GT: return "gt";
+    case CompareOp::GE: return "ge";
+    case CompareOp::IN: return "in";
+    case CompareOp::PREFIX: return "prefix";
+    }
+    return "";
+}
+
 AggFunc parseAggFunc(const std::string& func) {
     if (func == "count") return AggFunc::COUNT;
     if (func == "sum") return AggFunc::SUM;
     if (func == "min") return AggFunc::MIN;
     if (func == "max") return AggFunc::MAX;
+    if (func == "avg") return AggFunc::AVG;
+    if (func == "var_pop") return AggFunc::VAR_POP;
+    if (func == "var_samp") return AggFunc::VAR_SAMP;
+    if (func == "stddev_pop") return AggFunc::STDDEV_POP;
+    if (func == "stddev") return AggFunc::STDDEV;
+    if (func == "count_distinct") return AggFunc::COUNT_DISTINCT;
+    if (func == "approx_count_distinct") return AggFunc::APPROX_COUNT_DISTINCT;
     throw std::runtime_error("Invalid aggregation function: " + func);
 }
 
+std::string aggLabel(const AggSpec& spec) {
+    std::string label;
+    switch (spec.func) {
+    case AggFunc::COUNT: label = "count(*)"; break;
+    case AggFunc::SUM: label = "sum(" + spec.column + ")"; break;
+    case AggFunc::MIN: label = "min(" + spec.column + ")"; break;
+    case AggFunc::MAX: label = "max(" + spec.column + ")"; break;
+    case AggFunc::AVG: label = "avg(" + spec.column + ")"; break;
+    case AggFunc::VAR_POP: label = "var_pop(" + spec.column + ")"; break;
+    case AggFunc::VAR_SAMP: label = "var_samp(" + spec.column + ")"; break;
+    case AggFunc::STDDEV_POP: label = "stddev_pop(" + spec.column + ")"; break;
+    case AggFunc::STDDEV: label = "stddev(" + spec.column + ")"; break;
+    case AggFunc::COUNT_DISTINCT: label = "count(distinct " + spec.column + ")"; break;
+    case AggFunc::APPROX_COUNT_DISTINCT: label = "approx_count_distinct(" + spec.column + ")"; break;
+    }
+    for (const auto& filter : spec.filters) {
+        std::string value = filter.op == CompareOp::IN ? "(...)"
+                            : filter.onStrings() ? "'" + (*filter.strings)[0] + "'"
+                            : std::to_string(filter.value);
+        label += " [" + filter.column + " " + formatCompareOp(filter.op) + " " + value + "]";
+    }
+    return label;
+}
+
+std::string aggValue(const AggSpec& spec, const AggResult& result) {
+    switch (spec.func) {
+    case AggFunc::COUNT: return std::to_string(result.count);
+    case AggFunc::SUM: return std::to_string(result.sum);
+    case AggFunc::MIN: return result.min.has_value() ? std::to_string(result.min.value()) : "null";
+    case AggFunc::MAX: return result.max.has_value() ? std::to_string(result.max.value()) : "null";
+    case AggFunc::COUNT_DISTINCT:
+    case AggFunc::APPROX_COUNT_DISTINCT: return std::to_string(result.distinct.value_or(0));
+    default: break;
+    }
+    if (!result.value.has_value()) {
+        return "null";
+    }
+    std::ostringstream out;
+    out.precision(10);
+    out << result.value.value();
+    return out.str();
+}
+
 std::vector<std::string> split(const std::string& str, char delimiter) {
     std::vector<std::string> tokens;
     std::string token;
@@ -206,6 +328,92 @@ std::vector<std::string> split(const std::string& str, char delimiter) {
     return tokens;
 }
 
+// <column> <op> <value>; the value of "in" is a comma-separated list.
+// Values of STRING columns are taken as strings, which "prefix" needs.
+Predicate parsePredicate(const Schema& schema, const std::string& column, const std::string& op,
+                         const std::string& value) {
+    CompareOp compare_op = parseCompareOp(op);
+    if (schema.columns[schema.columnIndex(column)].type == ColumnType::STRING) {
+        switch (compare_op) {
+        case CompareOp::IN: return Predicate::inStrings(column, split(value, ','));
+        case CompareOp::PREFIX: return Predicate::startsWith(column, value);
+        default: return Predicate::compareString(column, compare_op, value);
+        }
+    }
+    if (compare_op == CompareOp::PREFIX) {
+        throw std::runtime_error("prefix applies to STRING columns: " + column);
+    }
+    if (compare_op != CompareOp::IN) {
+        return Predicate{column, compare_op, std::stoll(value)};
+    }
+
+    std::vector<int64_t> keys;
+    for (const auto& key : split(value, ',')) {
+        keys.push_back(std::stoll(key));
+    }
+    return Predicate::in(column, std::move(keys));
+}
+
+// Like parsePredicate, plus "between" with an inclusive <low>,<high> range
+FilterExpr parseFilter(const Schema& schema, const std::string& column, const std::string& op,
+                       const std::string& value) {
+    if (op != "between") {
+        return parsePredicate(schema, column, op, value);
+    }
+
+    auto bounds = split(value, ',');
+    if (bounds.size() != 2) {
+        throw std::runtime_error("between expects <low>,<high>: " + value);
+    }
+    return FilterExpr::between(column, std::stoll(bounds[0]), std::stoll(bounds[1]));
+}
+
+// Every value of an integer column of another file, for a semi-join filter
+std::vector<int64_t> readKeys(const std::string& path, const std::string& column) {
+    auto reader = std::make_shared<FileReader>(path);
+    std::vector<int64_t> keys;
+    Scanner scanner(reader, {column});
+    while (scanner.hasNext()) {
+        Batch batch = scanner.next();
+        std::visit([&](const auto& vals) {
+            using T = typename std::decay_t<decltype(vals)>::value_type;
+            if constexpr (std::is_same_v<T, std::string>) {
+                throw std::runtime_error("Semi-join keys must be integers: " + column);
+            } else {
+                keys.insert(keys.end(), vals.begin(), vals.end());
+            }
+        }, batch.columns[0]);
+    }
+    return keys;
+}
+
+// Print every row of a small result
+void printPreview(const std::vector<Batch>& preview) {
+    if (preview.empty()) {
+        return;
+    }
+
+    std::cout << "\nFirst rows:\n";
+    for (const auto& batch : preview) {
+        for (size_t row = 0; row < batch.num_rows; row++) {
+            for (size_t col = 0; col < batch.columns.size(); col++) {
+                if (col > 0) std::cout << ", ";
+                std::cout << batch.column_names[col] << "=";
+
+                const auto& col_data = batch.columns[col];
+                if (std::holds_alternative<std::vector<int32_t>>(col_data)) {
+                    std::cout << std::get<std::vector<int32_t>>(col_data)[row];
+                } else if (std::holds_alternative<std::vector<int64_t>>(col_data)) {
+                    std::cout << std::get<std::vector<int64_t>>(col_data)[row];
+                } else if (std::holds_alternative<std::vector<std::string>>(col_data)) {
+                    std::cout << std::get<std::vector<std::string>>(col_data)[row];
+                }
+            }
+            std::cout << "\n";
+        }
+    }
+}
+
 void executeQuery(int argc, char* argv[]) {
     if (argc < 3) {
         printUsage(argv[0]);
@@ -217,8 +425,14 @@ void executeQuery(int argc, char* argv[]) {
 
     QueryExecutor executor(reader);
     std::vector<std::string> projection;
-    std::optional<std::pair<AggFunc, std::string>> aggregation;
+    std::vector<AggSpec> aggregations;
     std::optional<std::string> group_by;
+    std::optional<size_t> limit;
+    size_t offset = 0;
+    std::optional<std::string> order_by;
+    bool descending = false;
+    // Each --where with the --or alternatives following it
+    std::vector<std::vector<FilterExpr>> where;
 
     for (int i = 3; i < argc; i++) {
         std::string arg = std::string(argv[i]);
@@ -229,74 +443,186 @@ void executeQuery(int argc, char* argv[]) {
         } else if (arg == "--where" && i + 3 < argc) {
             std::string col = std::string(argv[++i]);
             std::string op = std::string(argv[++i]);
-            int64_t value = std::stoll(std::string(argv[++i]));
-            executor.addFilter(Predicate{col, parseCompareOp(op), value});
+            where.push_back({parseFilter(reader->schema(), col, op, std::string(argv[++i]))});
+        } else if (arg == "--or" && i + 3 < argc) {
+            if (where.empty()) {
+                throw std::runtime_error("--or must follow a --where");
+            }
+            std::string col = std::string(argv[++i]);
+            std::string op = std::string(argv[++i]);
+            where.back().push_back(parseFilter(reader->schema(), col, op, std::string(argv[++i])));
+        } else if (arg == "--semi-join" && i + 3 < argc) {
+            std::string col = std::string(argv[++i]);
+            std::string other_path = std::string(argv[++i]);
+            std::string other_col = std::string(argv[++i]);
+            executor.addFilter(Predicate::in(col, readKeys(other_path, other_col)));
         } else if (arg == "--agg" && i + 2 < argc) {
             std::string func = std::string(argv[++i]);
             std::string col = std::string(argv[++i]);
-            aggregation = std::make_pair(parseAggFunc(func), col);
-            executor.setAggregation(aggregation->first, aggregation->second);
+            aggregations.push_back(AggSpec{parseAggFunc(func), col, {}});
+        } else if (arg == "--agg-where" && i + 3 < argc) {
+            if (aggregations.empty()) {
+                throw std::runtime_error("--agg-where must follow an --agg");
+            }
+            std::string col = std::string(argv[++i]);
+            std::string op = std::string(argv[++i]);
+            aggregations.back().filters.push_back(parsePredicate(reader->schema(), col, op, std::string(argv[++i])));
         } else if (arg == "--groupby" && i + 1 < argc) {
             group_by = std::string(argv[++i]);
-            executor.setGroupBy(group_by.value());
+            executor.setGroupByColumns(split(group_by.value(), ','));
+        } else if (arg == "--limit" && i + 1 < argc) {
+            limit = std::stoull(std::string(argv[++i]));
+        } else if (arg == "--offset" && i + 1 < argc) {
+            offset = std::stoull(std::string(argv[++i]));
+        } else if (arg == "--orderby" && i + 1 < argc) {
+            order_by = std::string(argv[++i]);
+        } else if (arg == "--desc") {
+            descending = true;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            executor.setThreads(std::stoull(std::string(argv[++i])));
+        } else if (arg == "--memory-budget" && i + 1 < argc) {
+            executor.setMemoryBudget(std::stoull(std::string(argv[++i])));
+        } else if (arg == "--spill-dir" && i + 1 < argc) {
+            executor.setSpillDirectory(std::string(argv[++i]));
+        } else if (arg == "--distinct-error" && i + 1 < argc) {
+            executor.setDistinctError(std::stod(std::string(argv[++i])));
         }
     }
 
+    for (auto& alternatives : where) {
+        executor.addFilter(alternatives.size() == 1 ? std::move(alternatives[0])
+                                                    : FilterExpr::anyOf(std::move(alternatives)));
+    }
+
+    for (const auto& spec : aggregations) {
+        executor.addAggregation(spec.func, spec.column, spec.filters);
+    }
+
+    if (order_by.has_value()) {
+        executor.setOrderBy(order_by.value(), descending);
+    }
+
+    if (limit.has_value()) {
+        executor.setLimit(limit.value(), offset);
+    } else if (offset > 0) {
+        executor.setLimit(std::numeric_limits<size_t>::max(), offset);
+    }
+
     if (group_by.has_value()) {
-        auto results = executor.executeGroupBy();
+        if (aggregations.empty()) {
+            executor.addAggregation(AggFunc::COUNT, group_by.value());
+            aggregations.push_back(AggSpec{AggFunc::COUNT, group_by.value(), {}});
+        }
+
+        auto results = executor.executeGroupByAggregates();
         std::cout << "GROUP BY " << group_by.value() << ":\n";
-        for (const auto& [key, agg] : results) {
-            std::cout << "  " << key << ": count=" << agg.count;
-            if (agg.sum != 0 || aggregation.has_value()) {
-                std::cout << ", sum=" << agg.sum;
+        for (const auto& group : results) {
+            std::cout << " ";
+            for (const auto& key : group.keys) {
+                std::cout << " " << key;
+            }
+            std::cout << ":";
+            for (size_t a = 0; a < group.aggs.size(); a++) {
+                std::cout << (a > 0 ? ", " : " ") << aggLabel(aggregations[a]) << "="
+                          << aggValue(aggregations[a], group.aggs[a]);
             }
             std::cout << "\n";
         }
-    } else if (aggregation.has_value()) {
-        auto result = executor.executeAggregate();
-        std::cout << "Aggregation result:\n";
-        std::cout << "  count: " << result.count << "\n";
-        if (aggregation->first != AggFunc::COUNT) {
-            std::cout << "  sum: " << result.sum << "\n";
-            if (result.min.has_value()) {
-                std::cout << "  min: " << result.min.value() << "\n";
-            }
-            if (result.max.has_value()) {
-                std::cout << "  max: " << result.max.value() << "\n";
-            }
+        if (executor.spilledRows() > 0) {
+            std::cout << "(" << executor.spilledRows() << " rows spilled to disk)\n";
+        }
+    } else if (!aggregations.empty()) {
+        auto results = executor.executeAggregates();
+        std::cout << "Aggregation results:\n";
+        for (size_t a = 0; a < results.size(); a++) {
+            std::cout << "  " << aggLabel(aggregations[a]) << ": " << aggValue(aggregations[a], results[a]) << "\n";
         }
     } else {
-        auto batches = executor.executeQuery();
+        // Stream batches so only a row group is resident at a time; keep
+        // the first few around in case the result is small enough to print
+        auto stream = executor.executeStream();
+        std::vector<Batch> preview;
         size_t total_rows = 0;
-        for (const auto& batch : batches) {
+        size_t num_batches = 0;
+
+        while (stream.hasNext()) {
+            Batch batch = stream.next();
             total_rows += batch.num_rows;
-        }
-        std::cout << "Query returned " << total_rows << " rows in " << batches.size() << " batches\n";
-
-        if (!batches.empty() && total_rows <= 20) {
-            std::cout << "\nFirst rows:\n";
-            for (const auto& batch : batches) {
-                for (size_t row = 0; row < std::min(batch.num_rows, static_cast<size_t>(20)); row++) {
-                    for (size_t col = 0; col < batch.columns.size(); col++) {
-                        if (col > 0) std::cout << ", ";
-                        std::cout << batch.column_names[col] << "=";
-
-                        const auto& col_data = batch.columns[col];
-                        if (std::holds_alternative<std::vector<int32_t>>(col_data)) {
-                            std::cout << std::get<std::vector<int32_t>>(col_data)[row];
-                        } else if (std::holds_alternative<std::vector<int64_t>>(col_data)) {
-                            std::cout << std::get<std::vector<int64_t>>(col_data)[row];
-                        } else if (std::holds_alternative<std::vector<std::string>>(col_data)) {
-                            std::cout << std::get<std::vector<std::string>>(col_data)[row];
-                        }
-                    }
-                    std::cout << "\n";
-                }
+            num_batches++;
+
+            if (total_rows <= 20) {
+                preview.push_back(std::move(batch));
+            } else {
+                preview.clear();
             }
         }
+        std::cout << "Query returned " << total_rows << " rows in " << num_batches << " batches\n";
+        if (executor.prunedRowGroups() > 0) {
+            std::cout << "(" << executor.prunedRowGroups() << " row groups skipped from stats)\n";
+        }
+        if (executor.spilledRows() > 0) {
+            std::cout << "(" << executor.spilledRows() << " rows spilled to disk)\n";
+        }
+
+        printPreview(preview);
     }
 }
 
+void executeJoin(int argc, char* argv[]) {
+    if (argc < 6) {
+        printUsage(argv[0]);
+        return;
+    }
+
+    auto left = std::make_shared<FileReader>(std::string(argv[2]));
+    auto right = std::make_shared<FileReader>(std::string(argv[3]));
+    std::string left_key = std::string(argv[4]);
+    std::string right_key = std::string(argv[5]);
+
+    JoinType type = JoinType::INNER;
+    std::vector<std::string> left_columns;
+    std::vector<std::string> right_columns;
+    size_t num_threads = 1;
+
+    for (int i = 6; i < argc; i++) {
+        std::string arg = std::string(argv[i]);
+
+        if (arg == "--left") {
+            type = JoinType::LEFT;
+        } else if (arg == "--select-left" && i + 1 < argc) {
+            left_columns = split(std::string(argv[++i]), ',');
+        } else if (arg == "--select-right" && i + 1 < argc) {
+            right_columns = split(std::string(argv[++i]), ',');
+        } else if (arg == "--threads" && i + 1 < argc) {
+            num_threads = std::stoull(std::string(argv[++i]));
+        } else {
+            throw std::runtime_error("Unknown join option: " + arg);
+        }
+    }
+
+    HashJoin join(left, left_key, right, right_key, type);
+    join.setLeftColumns(left_columns);
+    join.setRightColumns(right_columns);
+    join.setThreads(num_threads);
+
+    auto stream = join.execute();
+    std::vector<Batch> preview;
+    size_t total_rows = 0;
+    while (stream.hasNext()) {
+        Batch batch = stream.next();
+        total_rows += batch.num_rows;
+        if (total_rows <= 20) {
+            preview.push_back(std::move(batch));
+        } else {
+            preview.clear();
+        }
+    }
+
+    std::cout << "Join returned " << total_rows << " rows (hash tables built over the "
+              << (join.buildsOnLeft() ? "left" : "right") << " file, " << join.buildRows() << " rows)\n";
+    printPreview(preview);
+}
+
 int main(int argc, char* argv[]) {
     if (argc < 2) {
         printUsage(argv[0]);
@@ -329,6 +655,9 @@ int main(int argc, char* argv[]) {
         } else if (command == "query") {
             executeQuery(argc, argv);
 
+        } else if (command == "join") {
+            executeJoin(argc, argv);
+
         } else {
             std::cerr << "Unknown command: " << command << "\n";
             printUsage(argv[0]);
@@ -269,7 +269,8 @@ std::vector<uint8_t> DeltaEncoder::encodeInt32(const std::vector<int32_t>& value
 
     int32_t prev = base;
     for (size_t i = 1; i < values.size(); i++) {
-        int32_t delta = values[i] - prev;
+        // Wrapping difference: the decoder's wrapping sum restores the value
+        int32_t delta = static_cast<int32_t>(static_cast<uint32_t>(values[i]) - static_cast<uint32_t>(prev));
         len = VarintCodec::encodeInt32(delta, temp);
         result.insert(result.end(), temp, temp + len);
         prev = values[i];
@@ -295,7 +296,7 @@ std::vector<uint8_t> DeltaEncoder::encodeInt64(const std::vector<int64_t>& value
 
     int64_t prev = base;
     for (size_t i = 1; i < values.size(); i++) {
-        int64_t delta = values[i] - prev;
+        int64_t delta = static_cast<int64_t>(static_cast<uint64_t>(values[i]) - static_cast<uint64_t>(prev));
         len = VarintCodec::encodeInt64(delta, temp);
         result.insert(result.end(), temp, temp + len);
         prev = values[i];
@@ -325,7 +326,7 @@ std::vector<int32_t> DeltaEncoder::decodeInt32(const uint8_t* data, size_t size,
     for (uint32_t i = 0; i < num_deltas; i++) {
         int32_t delta = VarintCodec::decodeInt32Safe(data + pos, size - pos, &bytes_read);
         pos += bytes_read;
-        current += delta;
+        current = static_cast<int32_t>(static_cast<uint32_t>(current) + static_cast<uint32_t>(delta));
         result.push_back(current);
     }
 
@@ -353,7 +354,7 @@ std::vector<int64_t> DeltaEncoder::decodeInt64(const uint8_t* data, size_t size,
     for (uint32_t i = 0; i < num_deltas; i++) {
         int64_t delta = VarintCodec::decodeInt64Safe(data + pos, size - pos, &bytes_read);
         pos += bytes_read;
-        current += delta;
+        current = static_cast<int64_t>(static_cast<uint64_t>(current) + static_cast<uint64_t>(delta));
         result.push_back(current);
     }
 
@@ -403,13 +404,28 @@ std::vector<uint8_t> DictionaryEncoder::encode(const std::vector<std::string>& v
 }
 
 std::vector<std::string> DictionaryEncoder::decode(const uint8_t* data, size_t size, size_t num_values) {
+    std::vector<std::string> dictionary;
+    auto codes = decodeCodes(data, size, num_values, dictionary);
+
+    std::vector<std::string> result;
+    result.reserve(num_values);
+
+    for (int32_t code : codes) {
+        result.push_back(dictionary[code]);
+    }
+
+    return result;
+}
+
+std::vector<int32_t> DictionaryEncoder::decodeCodes(const uint8_t* data, size_t size, size_t num_values,
+                                                    std::vector<std::string>& dictionary) {
     size_t pos = 0;
 
     uint32_t dict_size;
     std::memcpy(&dict_size, data + pos, sizeof(uint32_t));
     pos += sizeof(uint32_t);
 
-    std::vector<std::string> dictionary;
+    dictionary.clear();
     dictionary.reserve(dict_size);
 
     for (uint32_t i = 0; i < dict_size; i++) {
@@ -422,19 +438,15 @@ std::vector<std::string> DictionaryEncoder::decode(const uint8_t* data, size_t s
         pos += len;
     }
 
-    auto indices = RLEEncoder::decodeInt32(data + pos, size - pos, num_values);
+    auto codes = RLEEncoder::decodeInt32(data + pos, size - pos, num_values);
 
-    std::vector<std::string> result;
-    result.reserve(num_values);
-
-    for (int32_t idx : indices) {
-        if (idx < 0 || idx >= static_cast<int32_t>(dictionary.size())) {
+    for (int32_t code : codes) {
+        if (code < 0 || code >= static_cast<int32_t>(dictionary.size())) {
             throw std::runtime_error("Invalid dictionary index");
         }
-        result.push_back(dictionary[idx]);
     }
 
-    return result;
+    return codes;
 }
 
 } // namespace columnar
@@ -3,9 +3,21 @@
 // Vectorized execution engine implementation
 
 #include "execution.h"
+#include "aggregation.h"
+#include "sketch.h"
+#include "sort.h"
 #include <algorithm>
-#include <unordered_map>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <exception>
+#include <filesystem>
+#include <iterator>
+#include <limits>
+#include <random>
 #include <stdexcept>
+#include <thread>
+#include <type_traits>
 
 namespace columnar {
 
@@ -19,7 +31,38 @@ size_t Batch::columnIndex(const std::string& name) const {
     throw std::runtime_error("Column not found in batch: " + name);
 }
 
+const std::vector<std::string>* Batch::dictionary(size_t idx) const {
+    if (idx >= dictionaries.size()) {
+        return nullptr;
+    }
+    return dictionaries[idx].get();
+}
+
 // Predicate evaluation
+Predicate Predicate::in(std::string column, std::vector<int64_t> keys) {
+    return Predicate{std::move(column), CompareOp::IN, 0, std::make_shared<const KeySet>(std::move(keys))};
+}
+
+Predicate Predicate::compareString(std::string column, CompareOp op, std::string value) {
+    if (op == CompareOp::IN || op == CompareOp::PREFIX) {
+        throw std::runtime_error("Use inStrings or startsWith for IN and PREFIX string predicates");
+    }
+    return Predicate{std::move(column), op, 0, nullptr,
+                     std::make_shared<const std::vector<std::string>>(1, std::move(value))};
+}
+
+Predicate Predicate::inStrings(std::string column, std::vector<std::string> values) {
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    return Predicate{std::move(column), CompareOp::IN, 0, nullptr,
+                     std::make_shared<const std::vector<std::string>>(std::move(values))};
+}
+
+Predicate Predicate::startsWith(std::string column, std::string prefix) {
+    return Predicate{std::move(column), CompareOp::PREFIX, 0, nullptr,
+                     std::make_shared<const std::vector<std::string>>(1, std::move(prefix))};
+}
+
 bool Predicate::evaluate(int32_t col_value) const {
     int64_t val = static_cast<int64_t>(col_value);
     switch (op) {
@@ -29,6 +72,8 @@ bool Predicate::evaluate(int32_t col_value) const {
     case CompareOp::LE: return val <= value;
     case CompareOp::GT: return val > value;
     case CompareOp::GE: return val >= value;
+    case CompareOp::IN: return keys->contains(val);
+    case CompareOp::PREFIX: return false;
     }
     return false;
 }
@@ -41,13 +86,105 @@ bool Predicate::evaluate(int64_t col_value) const {
     case CompareOp::LE: return col_value <= value;
     case CompareOp::GT: return col_value > value;
     case CompareOp::GE: return col_value >= value;
+    case CompareOp::IN: return keys->contains(col_value);
+    case CompareOp::PREFIX: return false;
     }
     return false;
 }
 
-bool Predicate::canSkipPage(const PageStats& stats) const {
+bool Predicate::evaluate(std::string_view col_value) const {
+    const auto& operands = *strings;
+    switch (op) {
+    case CompareOp::EQ: return col_value == operands[0];
+    case CompareOp::NE: return col_value != operands[0];
+    case CompareOp::LT: return col_value < operands[0];
+    case CompareOp::LE: return col_value <= operands[0];
+    case CompareOp::GT: return col_value > operands[0];
+    case CompareOp::GE: return col_value >= operands[0];
+    case CompareOp::IN: return std::binary_search(operands.begin(), operands.end(), col_value);
+    case CompareOp::PREFIX: return col_value.starts_with(operands[0]);
+    }
+    return false;
+}
+
+namespace {
+
+// Smallest string after every string starting with prefix, if any: the
+// prefix without its trailing 0xFF bytes, last byte incremented
+std::optional<std::string> prefixEnd(std::string prefix) {
+    while (!prefix.empty() && static_cast<unsigned char>(prefix.back()) == 0xFF) {
+        prefix.pop_back();
+    }
+    if (prefix.empty()) {
+        return std::nullopt;
+    }
+    prefix.back() = static_cast<char>(static_cast<unsigned char>(prefix.back()) + 1);
+    return prefix;
+}
+
+// Verdict of a string predicate from the page's bounds, each optional: the
+// min is at most and the max at least every value
+StatsMatch matchStringStats(const Predicate& pred, const PageStats& stats) {
+    const auto& lo = stats.min_string;
+    const auto& hi = stats.max_string;
+    if (!lo.has_value() && !hi.has_value()) {
+        return StatsMatch::MAYBE;
+    }
+
+    const auto& operands = *pred.strings;
+    std::string_view value = operands.empty() ? std::string_view() : std::string_view(operands[0]);
+    bool single = lo.has_value() && hi.has_value() && *lo == *hi;
+
+    switch (pred.op) {
+    case CompareOp::EQ:
+        if ((lo && value < *lo) || (hi && value > *hi)) return StatsMatch::NEVER;
+        if (single && *lo == value) return StatsMatch::ALWAYS;
+        return StatsMatch::MAYBE;
+    case CompareOp::NE:
+        if (single && *lo == value) return StatsMatch::NEVER;
+        if ((lo && value < *lo) || (hi && value > *hi)) return StatsMatch::ALWAYS;
+        return StatsMatch::MAYBE;
+    case CompareOp::LT:
+        if (lo && *lo >= value) return StatsMatch::NEVER;
+        if (hi && *hi < value) return StatsMatch::ALWAYS;
+        return StatsMatch::MAYBE;
+    case CompareOp::LE:
+        if (lo && *lo > value) return StatsMatch::NEVER;
+        if (hi && *hi <= value) return StatsMatch::ALWAYS;
+        return StatsMatch::MAYBE;
+    case CompareOp::GT:
+        if (hi && *hi <= value) return StatsMatch::NEVER;
+        if (lo && *lo > value) return StatsMatch::ALWAYS;
+        return StatsMatch::MAYBE;
+    case CompareOp::GE:
+        if (hi && *hi < value) return StatsMatch::NEVER;
+        if (lo && *lo >= value) return StatsMatch::ALWAYS;
+        return StatsMatch::MAYBE;
+    case CompareOp::IN: {
+        auto first = lo ? std::lower_bound(operands.begin(), operands.end(), *lo) : operands.begin();
+        if (first == operands.end() || (hi && *first > *hi)) return StatsMatch::NEVER;
+        if (single && *first == *lo) return StatsMatch::ALWAYS;
+        return StatsMatch::MAYBE;
+    }
+    case CompareOp::PREFIX: {
+        // Strings starting with the prefix are those in [prefix, end)
+        auto end = prefixEnd(std::string(value));
+        if ((hi && *hi < value) || (lo && end && *lo >= *end)) return StatsMatch::NEVER;
+        if (lo && hi && *lo >= value && (!end || *hi < *end)) return StatsMatch::ALWAYS;
+        return StatsMatch::MAYBE;
+    }
+    }
+    return StatsMatch::MAYBE;
+}
+
+} // namespace
+
+StatsMatch Predicate::matchStats(const PageStats& stats) const {
+    if (onStrings()) {
+        return matchStringStats(*this, stats);
+    }
     if (!stats.min_int.has_value() || !stats.max_int.has_value()) {
-        return false;
+        return StatsMatch::MAYBE;
     }
 
     int64_t min_val = stats.min_int.value();
@@ -55,349 +192,3240 @@ bool Predicate::canSkipPage(const PageStats& stats) const {
 
     switch (op) {
     case CompareOp::EQ:
-        return value < min_val || value > max_val;
+        if (value < min_val || value > max_val) return StatsMatch::NEVER;
+        if (min_val == value && max_val == value) return StatsMatch::ALWAYS;
+        return StatsMatch::MAYBE;
     case CompareOp::NE:
-        return false;
+        if (min_val == value && max_val == value) return StatsMatch::NEVER;
+        if (value < min_val || value > max_val) return StatsMatch::ALWAYS;
+        return StatsMatch::MAYBE;
     case CompareOp::LT:
-        return min_val >= value;
+        if (min_val >= value) return StatsMatch::NEVER;
+        if (max_val < value) return StatsMatch::ALWAYS;
+        return StatsMatch::MAYBE;
     case CompareOp::LE:
-        return min_val > value;
+        if (min_val > value) return StatsMatch::NEVER;
+        if (max_val <= value) return StatsMatch::ALWAYS;
+        return StatsMatch::MAYBE;
     case CompareOp::GT:
-        return max_val <= value;
+        if (max_val <= value) return StatsMatch::NEVER;
+        if (min_val > value) return StatsMatch::ALWAYS;
+        return StatsMatch::MAYBE;
     case CompareOp::GE:
-        return max_val < value;
+        if (max_val < value) return StatsMatch::NEVER;
+        if (min_val >= value) return StatsMatch::ALWAYS;
+        return StatsMatch::MAYBE;
+    case CompareOp::IN:
+        if (!keys->intersects(min_val, max_val)) return StatsMatch::NEVER;
+        if (keys->covers(min_val, max_val)) return StatsMatch::ALWAYS;
+        return StatsMatch::MAYBE;
+    case CompareOp::PREFIX:
+        return StatsMatch::MAYBE;
     }
-    return false;
+    return StatsMatch::MAYBE;
 }
 
-// Scanner implementation
-Scanner::Scanner(std::shared_ptr<FileReader> reader,
-                 std::vector<std::string> columns,
-                 size_t batch_size)
-    : reader_(std::move(reader))
-    , selected_columns_(std::move(columns))
-    , batch_size_(batch_size)
-    , current_row_group_(0)
-    , current_offset_(0) {
-
-    for (const auto& col : selected_columns_) {
-        column_indices_.push_back(reader_->schema().columnIndex(col));
-    }
+bool Predicate::canSkipPage(const PageStats& stats) const {
+    return matchStats(stats) == StatsMatch::NEVER;
 }
 
-void Scanner::addFilter(Predicate pred) {
-    filters_.push_back(pred);
+// Column slicing helpers
+namespace {
+
+// ORDER BY limits up to this many rows (and offsets) are answered with a
+// bounded heap, larger ones by a full sort
+constexpr size_t TOP_N_MAX_ROWS = size_t{1} << 20;
+
+Batch::ColumnData sliceColumn(const Batch::ColumnData& col, size_t begin, size_t count) {
+    return std::visit([begin, count](const auto& vals) -> Batch::ColumnData {
+        using Vec = std::decay_t<decltype(vals)>;
+        return Vec(vals.begin() + begin, vals.begin() + begin + count);
+    }, col);
 }
 
-bool Scanner::hasNext() {
-    return current_row_group_ < reader_->metadata().row_groups.size();
+Batch::ColumnData gatherColumn(const Batch::ColumnData& col, const std::vector<uint32_t>& sel) {
+    return std::visit([&sel](const auto& vals) -> Batch::ColumnData {
+        using Vec = std::decay_t<decltype(vals)>;
+        Vec out;
+        out.reserve(sel.size());
+        for (uint32_t idx : sel) {
+            out.push_back(vals[idx]);
+        }
+        return out;
+    }, col);
 }
 
-Batch Scanner::next() {
-    if (!hasNext()) {
-        throw std::runtime_error("No more batches");
+// Narrow a selection vector of row indices to the rows passing pred.
+// When first is set, the selection is built from [begin, end) instead.
+template<typename T>
+void selectRows(const std::vector<T>& vals, const Predicate& pred,
+                size_t begin, size_t end, bool first, std::vector<uint32_t>& sel) {
+    if constexpr (!std::is_same_v<T, std::string>) {
+        if (pred.op == CompareOp::IN) {
+            pred.keys->select(vals, begin, end, first, sel);
+            return;
+        }
     }
 
-    // Loop instead of recursion to avoid stack overflow on many skipped row groups
-    while (true) {
-        const auto& rg = reader_->metadata().row_groups[current_row_group_];
-
-        bool can_skip = false;
-        for (const auto& filter : filters_) {
-            size_t filter_col_idx = reader_->schema().columnIndex(filter.column);
-            const auto& cc = rg.column_chunks[filter_col_idx];
-
-            if (!cc.page_headers.empty()) {
-                if (filter.canSkipPage(cc.page_headers[0].stats)) {
-                    can_skip = true;
-                    break;
-                }
+    if (first) {
+        sel.clear();
+        for (size_t row = begin; row < end; row++) {
+            if (pred.evaluate(vals[row])) {
+                sel.push_back(static_cast<uint32_t>(row));
             }
         }
+        return;
+    }
 
-        if (can_skip) {
-            current_row_group_++;
-            current_offset_ = 0;
-            if (!hasNext()) {
-                throw std::runtime_error("No more batches after skipping");
-            }
-            continue;  // Skip to next row group
+    size_t kept = 0;
+    for (uint32_t row : sel) {
+        if (pred.evaluate(vals[row])) {
+            sel[kept++] = row;
         }
-
-        // Found a non-skippable row group, process it
-        break;
     }
+    sel.resize(kept);
+}
 
-    const auto& rg = reader_->metadata().row_groups[current_row_group_];
-    Batch batch;
-    batch.column_names = selected_columns_;
-    batch.num_rows = rg.num_rows;
-
-    for (size_t i = 0; i < selected_columns_.size(); i++) {
-        size_t col_idx = column_indices_[i];
-        const auto& col_schema = reader_->schema().columns[col_idx];
+// Rows of [begin, end) of a sorted column passing pred, found by binary
+// search: on sorted values, the matches of a comparison or prefix are
+// contiguous. nullopt for NE and IN, whose matches may be scattered.
+template<typename T>
+std::optional<std::pair<size_t, size_t>> sortedRange(const std::vector<T>& vals, size_t begin, size_t end,
+                                                     const Predicate& pred, ChunkOrder order) {
+    constexpr bool is_string = std::is_same_v<T, std::string>;
+    bool comparison = pred.op == CompareOp::EQ || pred.op == CompareOp::LT || pred.op == CompareOp::LE ||
+                      pred.op == CompareOp::GT || pred.op == CompareOp::GE;
+    if (order == ChunkOrder::UNSORTED || pred.onStrings() != is_string ||
+        !(comparison || (is_string && pred.op == CompareOp::PREFIX))) {
+        return std::nullopt;
+    }
 
-        switch (col_schema.type) {
-        case ColumnType::INT32: {
-            auto values = reader_->readInt32Column(current_row_group_, col_idx);
-            batch.columns.push_back(std::move(values));
-            break;
-        }
-        case ColumnType::INT64: {
-            auto values = reader_->readInt64Column(current_row_group_, col_idx);
-            batch.columns.push_back(std::move(values));
-            break;
+    using Key = std::conditional_t<is_string, std::string, int64_t>;
+    Key key;
+    std::optional<std::string> prefix_end;
+    if constexpr (is_string) {
+        key = pred.strings->front();
+        if (pred.op == CompareOp::PREFIX) {
+            prefix_end = prefixEnd(key);
         }
-        case ColumnType::STRING: {
-            auto values = reader_->readStringColumn(current_row_group_, col_idx);
-            batch.columns.push_back(std::move(values));
-            break;
+    } else {
+        key = pred.value;
+    }
+
+    // Whether a value sorts before or after every match, in ascending order
+    auto below = [&](const T& v) {
+        switch (pred.op) {
+        case CompareOp::EQ:
+        case CompareOp::GE:
+        case CompareOp::PREFIX: return v < key;
+        case CompareOp::GT: return !(key < v);
+        default: return false;
         }
+    };
+    auto above = [&](const T& v) {
+        switch (pred.op) {
+        case CompareOp::EQ:
+        case CompareOp::LE: return key < v;
+        case CompareOp::LT: return !(v < key);
+        case CompareOp::PREFIX:
+            if constexpr (is_string) {
+                return prefix_end.has_value() && !(v < *prefix_end);
+            }
+            return false;
+        default: return false;
         }
+    };
+
+    auto from = vals.begin() + static_cast<std::ptrdiff_t>(begin);
+    auto to = vals.begin() + static_cast<std::ptrdiff_t>(end);
+    auto first = from;
+    auto last = to;
+    if (order == ChunkOrder::ASCENDING) {
+        first = std::partition_point(from, to, below);
+        last = std::partition_point(first, to, [&](const T& v) { return !above(v); });
+    } else {
+        first = std::partition_point(from, to, above);
+        last = std::partition_point(first, to, [&](const T& v) { return !below(v); });
     }
+    return std::make_pair(static_cast<size_t>(first - vals.begin()), static_cast<size_t>(last - vals.begin()));
+}
 
-    if (!filters_.empty()) {
-        std::vector<size_t> keep_indices;
-        keep_indices.reserve(batch.num_rows);
-
-        for (size_t row = 0; row < batch.num_rows; row++) {
-            bool pass = true;
-
-            for (const auto& filter : filters_) {
-                size_t filter_col_batch_idx = batch.columnIndex(filter.column);
-                const auto& col = batch.columns[filter_col_batch_idx];
-
-                if (std::holds_alternative<std::vector<int32_t>>(col)) {
-                    const auto& vals = std::get<std::vector<int32_t>>(col);
-                    if (!filter.evaluate(vals[row])) {
-                        pass = false;
-                        break;
-                    }
-                } else if (std::holds_alternative<std::vector<int64_t>>(col)) {
-                    const auto& vals = std::get<std::vector<int64_t>>(col);
-                    if (!filter.evaluate(vals[row])) {
-                        pass = false;
-                        break;
-                    }
-                }
+// selectRows for dictionary codes, given which dictionary entries match
+void selectCodes(const std::vector<int32_t>& codes, const std::vector<uint8_t>& matches,
+                 size_t begin, size_t end, bool first, std::vector<uint32_t>& sel) {
+    if (first) {
+        sel.clear();
+        for (size_t row = begin; row < end; row++) {
+            if (matches[static_cast<size_t>(codes[row])]) {
+                sel.push_back(static_cast<uint32_t>(row));
             }
+        }
+        return;
+    }
 
-            if (pass) {
-                keep_indices.push_back(row);
-            }
+    size_t kept = 0;
+    for (uint32_t row : sel) {
+        if (matches[static_cast<size_t>(codes[row])]) {
+            sel[kept++] = row;
         }
+    }
+    sel.resize(kept);
+}
 
-        Batch filtered_batch;
-        filtered_batch.column_names = batch.column_names;
-        filtered_batch.num_rows = keep_indices.size();
+// Strings of rows [begin, end) of a dictionary-encoded column, or of the
+// selected rows when sel is given
+Batch::ColumnData decodeCodes(const std::vector<int32_t>& codes, const std::vector<std::string>& dictionary,
+                              size_t begin, size_t end, const std::vector<uint32_t>* sel) {
+    std::vector<std::string> out;
+    if (sel) {
+        out.reserve(sel->size());
+        for (uint32_t row : *sel) {
+            out.push_back(dictionary[static_cast<size_t>(codes[row])]);
+        }
+    } else {
+        out.reserve(end - begin);
+        for (size_t row = begin; row < end; row++) {
+            out.push_back(dictionary[static_cast<size_t>(codes[row])]);
+        }
+    }
+    return out;
+}
 
-        for (auto& col : batch.columns) {
-            if (std::holds_alternative<std::vector<int32_t>>(col)) {
-                const auto& vals = std::get<std::vector<int32_t>>(col);
-                std::vector<int32_t> filtered_vals;
-                filtered_vals.reserve(keep_indices.size());
-                for (size_t idx : keep_indices) {
-                    filtered_vals.push_back(vals[idx]);
-                }
-                filtered_batch.columns.push_back(std::move(filtered_vals));
-            } else if (std::holds_alternative<std::vector<int64_t>>(col)) {
-                const auto& vals = std::get<std::vector<int64_t>>(col);
-                std::vector<int64_t> filtered_vals;
-                filtered_vals.reserve(keep_indices.size());
-                for (size_t idx : keep_indices) {
-                    filtered_vals.push_back(vals[idx]);
-                }
-                filtered_batch.columns.push_back(std::move(filtered_vals));
-            } else if (std::holds_alternative<std::vector<std::string>>(col)) {
-                const auto& vals = std::get<std::vector<std::string>>(col);
-                std::vector<std::string> filtered_vals;
-                filtered_vals.reserve(keep_indices.size());
-                for (size_t idx : keep_indices) {
-                    filtered_vals.push_back(vals[idx]);
-                }
-                filtered_batch.columns.push_back(std::move(filtered_vals));
+// Bits of rows [begin, end) passing pred, 64 rows per word. String
+// predicates test each string or, given the dictionary entries that pass
+// (matches), each dictionary code.
+template<typename T>
+void predicateBits(const std::vector<T>& vals, const Predicate& pred,
+                   size_t begin, size_t end, std::vector<uint64_t>& bits,
+                   const std::vector<uint8_t>* matches = nullptr) {
+    size_t num_rows = end - begin;
+    bits.assign((num_rows + 63) / 64, 0);
+
+    // One branch-free test per row, packed a word at a time
+    auto fill = [&](auto test) {
+        for (size_t w = 0; w < bits.size(); w++) {
+            const T* row = vals.data() + begin + w * 64;
+            size_t count = std::min<size_t>(64, num_rows - w * 64);
+            uint64_t word = 0;
+            for (size_t i = 0; i < count; i++) {
+                word |= static_cast<uint64_t>(test(row[i])) << i;
             }
+            bits[w] = word;
+        }
+    };
+
+    if constexpr (std::is_same_v<T, std::string>) {
+        fill([&pred](const std::string& v) { return pred.evaluate(std::string_view(v)); });
+    } else if (matches) {
+        fill([matches](T code) { return (*matches)[static_cast<size_t>(code)] != 0; });
+    } else if (pred.op == CompareOp::IN) {
+        std::vector<uint32_t> sel;
+        pred.keys->select(vals, begin, end, true, sel);
+        for (uint32_t row : sel) {
+            size_t i = row - begin;
+            bits[i / 64] |= uint64_t{1} << (i % 64);
+        }
+    } else {
+        int64_t value = pred.value;
+        switch (pred.op) {
+        case CompareOp::EQ: fill([value](int64_t v) { return v == value; }); break;
+        case CompareOp::NE: fill([value](int64_t v) { return v != value; }); break;
+        case CompareOp::LT: fill([value](int64_t v) { return v < value; }); break;
+        case CompareOp::LE: fill([value](int64_t v) { return v <= value; }); break;
+        case CompareOp::GT: fill([value](int64_t v) { return v > value; }); break;
+        case CompareOp::GE: fill([value](int64_t v) { return v >= value; }); break;
+        case CompareOp::IN:
+        case CompareOp::PREFIX: break;
         }
+    }
+}
 
-        batch = std::move(filtered_batch);
+// Call fn on every predicate of an expression
+template<typename Fn>
+void forEachPredicate(const FilterExpr& expr, Fn&& fn) {
+    if (expr.isPredicate()) {
+        fn(expr.predicate());
+        return;
+    }
+    for (const auto& child : expr.children()) {
+        forEachPredicate(child, fn);
     }
+}
 
-    current_row_group_++;
-    current_offset_ = 0;
+// Clear the bits past the last of num_rows rows
+void clearTailBits(std::vector<uint64_t>& bits, size_t num_rows) {
+    if (num_rows % 64 != 0 && !bits.empty()) {
+        bits.back() &= (uint64_t{1} << (num_rows % 64)) - 1;
+    }
+}
 
-    return batch;
+} // namespace
+
+// Filter expressions
+FilterExpr::FilterExpr(Predicate pred)
+    : kind_(Kind::PREDICATE)
+    , pred_(std::move(pred)) {}
+
+FilterExpr::FilterExpr(Kind kind, std::vector<FilterExpr> children)
+    : kind_(kind)
+    , pred_()
+    , children_(std::move(children)) {}
+
+FilterExpr FilterExpr::allOf(std::vector<FilterExpr> children) {
+    return FilterExpr(Kind::AND, std::move(children));
 }
 
-// Query executor
-QueryExecutor::QueryExecutor(std::shared_ptr<FileReader> reader)
-    : reader_(std::move(reader)) {}
+FilterExpr FilterExpr::anyOf(std::vector<FilterExpr> children) {
+    return FilterExpr(Kind::OR, std::move(children));
+}
 
-void QueryExecutor::setProjection(std::vector<std::string> columns) {
-    projection_ = std::move(columns);
+FilterExpr FilterExpr::negate(FilterExpr child) {
+    return FilterExpr(Kind::NOT, {std::move(child)});
 }
 
-void QueryExecutor::addFilter(Predicate pred) {
-    filters_.push_back(pred);
+FilterExpr FilterExpr::between(std::string column, int64_t low, int64_t high) {
+    return allOf({Predicate{column, CompareOp::GE, low}, Predicate{column, CompareOp::LE, high}});
 }
 
-void QueryExecutor::setAggregation(AggFunc func, std::string column) {
-    aggregation_ = std::make_pair(func, std::move(column));
+void FilterExpr::collectColumns(std::vector<std::string>& columns) const {
+    if (kind_ == Kind::PREDICATE) {
+        columns.push_back(pred_.column);
+    }
+    for (const auto& child : children_) {
+        child.collectColumns(columns);
+    }
 }
 
-void QueryExecutor::setGroupBy(std::string column) {
-    group_by_column_ = std::move(column);
+StatsMatch FilterExpr::matchStats(const std::function<const PageStats*(const std::string&)>& stats) const {
+    switch (kind_) {
+    case Kind::PREDICATE: {
+        const PageStats* column_stats = stats(pred_.column);
+        return column_stats ? pred_.matchStats(*column_stats) : StatsMatch::MAYBE;
+    }
+    case Kind::NOT: {
+        StatsMatch match = children_[0].matchStats(stats);
+        if (match == StatsMatch::ALWAYS) return StatsMatch::NEVER;
+        if (match == StatsMatch::NEVER) return StatsMatch::ALWAYS;
+        return StatsMatch::MAYBE;
+    }
+    case Kind::AND:
+    case Kind::OR: {
+        // A single NEVER child decides an AND, a single ALWAYS child an OR
+        StatsMatch decisive = kind_ == Kind::AND ? StatsMatch::NEVER : StatsMatch::ALWAYS;
+        StatsMatch result = kind_ == Kind::AND ? StatsMatch::ALWAYS : StatsMatch::NEVER;
+        for (const auto& child : children_) {
+            StatsMatch match = child.matchStats(stats);
+            if (match == decisive) {
+                return decisive;
+            }
+            if (match == StatsMatch::MAYBE) {
+                result = StatsMatch::MAYBE;
+            }
+        }
+        return result;
+    }
+    }
+    return StatsMatch::MAYBE;
 }
 
-std::vector<Batch> QueryExecutor::executeQuery() {
-    std::vector<std::string> scan_columns = projection_.empty() ?
-        [this]() {
-            std::vector<std::string> cols;
-            for (const auto& c : reader_->schema().columns) {
-                cols.push_back(c.name);
+void FilterExpr::evaluate(const std::function<const Batch::ColumnData&(const std::string&)>& column,
+                          size_t begin, size_t end, std::vector<uint64_t>& bits,
+                          const std::function<const std::vector<uint8_t>*(const Predicate&)>& code_matches) const {
+    size_t num_rows = end - begin;
+
+    switch (kind_) {
+    case Kind::PREDICATE: {
+        const auto& col = column(pred_.column);
+        // String leaves read strings, or dictionary codes when given matches
+        const std::vector<uint8_t>* matches = pred_.onStrings() && code_matches ? code_matches(pred_) : nullptr;
+        bool strings = std::holds_alternative<std::vector<std::string>>(col);
+        bool codes = matches != nullptr && std::holds_alternative<std::vector<int32_t>>(col);
+        if (pred_.onStrings() ? !strings && !codes : strings) {
+            throw std::runtime_error(pred_.onStrings() ? "String predicate on integer column: " + pred_.column
+                                                       : "Numeric predicate on STRING column: " + pred_.column);
+        }
+        std::visit([&](const auto& vals) { predicateBits(vals, pred_, begin, end, bits, matches); }, col);
+        return;
+    }
+    case Kind::NOT:
+        children_[0].evaluate(column, begin, end, bits, code_matches);
+        for (auto& word : bits) {
+            word = ~word;
+        }
+        break;
+    case Kind::AND:
+    case Kind::OR: {
+        bool is_and = kind_ == Kind::AND;
+        bits.assign((num_rows + 63) / 64, is_and ? ~uint64_t{0} : 0);
+        std::vector<uint64_t> child_bits;
+        for (const auto& child : children_) {
+            child.evaluate(column, begin, end, child_bits, code_matches);
+            uint64_t any = 0;
+            for (size_t w = 0; w < bits.size(); w++) {
+                bits[w] = is_and ? bits[w] & child_bits[w] : bits[w] | child_bits[w];
+                any |= bits[w];
             }
-            return cols;
-        }() : projection_;
+            // No row left for the remaining children of an AND to reject
+            if (is_and && any == 0) {
+                break;
+            }
+        }
+        break;
+    }
+    }
+    clearTailBits(bits, num_rows);
+}
 
-    Scanner scanner(reader_, scan_columns);
+// Scanner implementation
+Scanner::Scanner(std::shared_ptr<FileReader> reader,
+                 std::vector<std::string> columns,
+                 size_t batch_size)
+    : reader_(std::move(reader))
+    , selected_columns_(std::move(columns))
+    , batch_size_(std::max<size_t>(batch_size, 1))
+    , current_row_group_(0)
+    , current_offset_(0)
+    , rg_cursor_(0)
+    , rg_range_(0)
+    , rg_loaded_(false) {
 
-    for (const auto& filter : filters_) {
-        scanner.addFilter(filter);
+    for (const auto& col : selected_columns_) {
+        column_indices_.push_back(reader_->schema().columnIndex(col));
     }
+    scan_indices_ = column_indices_;
 
-    std::vector<Batch> results;
-    while (scanner.hasNext()) {
-        results.push_back(scanner.next());
+    row_groups_.resize(reader_->metadata().row_groups.size());
+    for (size_t i = 0; i < row_groups_.size(); i++) {
+        row_groups_[i] = i;
     }
-
-    return results;
 }
 
-AggResult QueryExecutor::executeAggregate() {
-    if (!aggregation_.has_value()) {
-        throw std::runtime_error("No aggregation specified");
+void Scanner::setRowGroups(std::vector<size_t> row_groups) {
+    for (size_t rg_idx : row_groups) {
+        if (rg_idx >= reader_->metadata().row_groups.size()) {
+            throw std::runtime_error("Invalid row group index");
+        }
     }
 
-    const auto& [func, col_name] = aggregation_.value();
+    releaseRowGroup();
+    row_groups_ = std::move(row_groups);
+    rg_cursor_ = 0;
+}
 
-    std::vector<std::string> scan_columns;
-    if (func != AggFunc::COUNT) {
-        scan_columns.push_back(col_name);
-    } else {
-        if (!reader_->schema().columns.empty()) {
-            scan_columns.push_back(reader_->schema().columns[0].name);
-        }
+void Scanner::setDictionaryCodes(const std::string& column) {
+    auto it = std::find(selected_columns_.begin(), selected_columns_.end(), column);
+    if (it == selected_columns_.end()) {
+        throw std::runtime_error("Column not selected: " + column);
     }
 
-    Scanner scanner(reader_, scan_columns);
-    for (const auto& filter : filters_) {
-        scanner.addFilter(filter);
+    size_t col_idx = column_indices_[static_cast<size_t>(it - selected_columns_.begin())];
+    if (reader_->schema().columns[col_idx].type != ColumnType::STRING) {
+        throw std::runtime_error("Dictionary codes require a STRING column: " + column);
     }
 
-    AggResult result{};
-    result.count = 0;
-    result.sum = 0;
+    releaseRowGroup();
+    code_columns_.push_back(col_idx);
+}
 
-    while (scanner.hasNext()) {
-        Batch batch = scanner.next();
-        result.count += batch.num_rows;
+void Scanner::addFilter(Predicate pred) {
+    size_t col_idx = reader_->schema().columnIndex(pred.column);
+    bool string_column = reader_->schema().columns[col_idx].type == ColumnType::STRING;
+    if (string_column != pred.onStrings()) {
+        throw std::runtime_error(string_column ? "Numeric predicate on STRING column: " + pred.column
+                                               : "String predicate on integer column: " + pred.column);
+    }
 
-        if (func == AggFunc::COUNT) {
-            continue;
-        }
+    auto it = std::find(scan_indices_.begin(), scan_indices_.end(), col_idx);
+    filter_positions_.push_back(static_cast<size_t>(it - scan_indices_.begin()));
+    if (it == scan_indices_.end()) {
+        scan_indices_.push_back(col_idx);
+    }
 
-        size_t col_idx = batch.columnIndex(col_name);
-        const auto& col = batch.columns[col_idx];
+    filters_.push_back(std::move(pred));
+}
 
-        if (std::holds_alternative<std::vector<int32_t>>(col)) {
-            const auto& vals = std::get<std::vector<int32_t>>(col);
-            for (int32_t val : vals) {
-                result.sum += val;
-                if (!result.min.has_value() || val < result.min.value()) {
-                    result.min = val;
-                }
-                if (!result.max.has_value() || val > result.max.value()) {
-                    result.max = val;
-                }
-            }
-        } else if (std::holds_alternative<std::vector<int64_t>>(col)) {
-            const auto& vals = std::get<std::vector<int64_t>>(col);
-            for (int64_t val : vals) {
-                result.sum += val;
-                if (!result.min.has_value() || val < result.min.value()) {
-                    result.min = val;
-                }
-                if (!result.max.has_value() || val > result.max.value()) {
-                    result.max = val;
-                }
-            }
+void Scanner::addFilter(FilterExpr expr) {
+    if (expr.isPredicate()) {
+        addFilter(expr.predicate());
+        return;
+    }
+    if (expr.isConjunction()) {
+        for (const auto& child : expr.children()) {
+            addFilter(child);
         }
+        return;
     }
 
-    return result;
+    forEachPredicate(expr, [&](const Predicate& pred) {
+        size_t col_idx = reader_->schema().columnIndex(pred.column);
+        bool string_column = reader_->schema().columns[col_idx].type == ColumnType::STRING;
+        if (string_column != pred.onStrings()) {
+            throw std::runtime_error(string_column ? "Numeric predicate on STRING column: " + pred.column
+                                                   : "String predicate on integer column: " + pred.column);
+        }
+        if (std::find(scan_indices_.begin(), scan_indices_.end(), col_idx) == scan_indices_.end()) {
+            scan_indices_.push_back(col_idx);
+        }
+    });
+
+    exprs_.push_back(std::move(expr));
 }
 
-std::vector<std::pair<std::string, AggResult>> QueryExecutor::executeGroupBy() {
-    if (!group_by_column_.has_value()) {
-        throw std::runtime_error("No GROUP BY column specified");
+bool Scanner::canSkipRowGroup(size_t rg_idx) const {
+    const auto& rg = reader_->metadata().row_groups[rg_idx];
+
+    for (size_t i = 0; i < filters_.size(); i++) {
+        const auto& cc = rg.column_chunks[scan_indices_[filter_positions_[i]]];
+        if (!cc.page_headers.empty() && filters_[i].canSkipPage(cc.page_headers[0].stats)) {
+            return true;
+        }
     }
 
-    if (!aggregation_.has_value()) {
-        throw std::runtime_error("No aggregation specified for GROUP BY");
+    auto stats = [&](const std::string& column) -> const PageStats* {
+        const auto& cc = rg.column_chunks[reader_->schema().columnIndex(column)];
+        return cc.page_headers.empty() ? nullptr : &cc.page_headers[0].stats;
+    };
+    for (const auto& expr : exprs_) {
+        if (expr.matchStats(stats) == StatsMatch::NEVER) {
+            return true;
+        }
     }
+    return false;
+}
 
-    const auto& group_col = group_by_column_.value();
-    const auto& [func, agg_col] = aggregation_.value();
+bool Scanner::hasNext() {
+    const auto& row_groups = reader_->metadata().row_groups;
 
-    std::vector<std::string> scan_columns{group_col};
-    if (func != AggFunc::COUNT) {
-        scan_columns.push_back(agg_col);
+    // Loop instead of recursion to avoid stack overflow on many skipped row groups
+    while (rg_cursor_ < row_groups_.size()) {
+        current_row_group_ = row_groups_[rg_cursor_];
+        // Bloom filters, column indexes, dictionaries and sorted chunks are
+        // checked as the row group is loaded, which may skip it
+        bool rows_left = rg_loaded_ ? rg_range_ < rg_ranges_.size()
+                                    : current_offset_ < row_groups[current_row_group_].num_rows;
+        if (rows_left &&
+            (rg_loaded_ || (!canSkipRowGroup(current_row_group_) && (!hasFilters() || loadRowGroup())))) {
+            return true;
+        }
+        releaseRowGroup();
+        rg_cursor_++;
     }
+    return false;
+}
 
-    Scanner scanner(reader_, scan_columns);
-    for (const auto& filter : filters_) {
-        scanner.addFilter(filter);
-    }
+bool Scanner::hasFilters() const {
+    return !filters_.empty() || !exprs_.empty();
+}
 
-    std::unordered_map<std::string, AggResult> groups;
+size_t Scanner::currentRowGroup() const {
+    return current_row_group_;
+}
 
-    while (scanner.hasNext()) {
-        Batch batch = scanner.next();
+size_t Scanner::skipRows(size_t num_rows) {
+    if (hasFilters()) {
+        throw std::runtime_error("skipRows requires an unfiltered scan");
+    }
 
-        size_t group_col_idx = batch.columnIndex(group_col);
-        const auto& group_vals = std::get<std::vector<std::string>>(batch.columns[group_col_idx]);
+    // Whole row groups are skipped from metadata without being decoded
+    size_t skipped = 0;
+    while (skipped < num_rows && hasNext()) {
+        size_t available = reader_->metadata().row_groups[current_row_group_].num_rows - current_offset_;
+        size_t step = std::min(available, num_rows - skipped);
+        current_offset_ += step;
+        skipped += step;
+    }
+    return skipped;
+}
 
-        for (size_t row = 0; row < batch.num_rows; row++) {
-            const std::string& group_key = group_vals[row];
-            auto& agg = groups[group_key];
-            agg.count++;
-
-            if (func != AggFunc::COUNT) {
-                size_t agg_col_idx = batch.columnIndex(agg_col);
-                const auto& agg_vals_col = batch.columns[agg_col_idx];
-
-                int64_t val = 0;
-                if (std::holds_alternative<std::vector<int32_t>>(agg_vals_col)) {
-                    val = std::get<std::vector<int32_t>>(agg_vals_col)[row];
-                } else if (std::holds_alternative<std::vector<int64_t>>(agg_vals_col)) {
-                    val = std::get<std::vector<int64_t>>(agg_vals_col)[row];
-                }
+bool Scanner::bloomSkipsRowGroup() {
+    const auto& rg = reader_->metadata().row_groups[current_row_group_];
 
-                agg.sum += val;
-                if (!agg.min.has_value() || val < agg.min.value()) {
-                    agg.min = val;
-                }
-                if (!agg.max.has_value() || val > agg.max.value()) {
-                    agg.max = val;
-                }
+    for (size_t i = 0; i < filters_.size(); i++) {
+        const auto& pred = filters_[i];
+        size_t col_idx = scan_indices_[filter_positions_[i]];
+        const auto& cc = rg.column_chunks[col_idx];
+        if ((pred.op != CompareOp::EQ && pred.op != CompareOp::IN) || cc.bloom_size == 0) {
+            continue;
+        }
+
+        auto bloom = reader_->readBloomFilter(current_row_group_, col_idx);
+        auto present = [&](uint64_t hash) { return bloom->mayContain(hash); };
+        bool any = false;
+        if (pred.onStrings()) {
+            any = std::any_of(pred.strings->begin(), pred.strings->end(), [&](const std::string& value) {
+                return present(hashBytes(value.data(), value.size()));
+            });
+        } else if (pred.op == CompareOp::EQ) {
+            any = present(hashInt64(static_cast<uint64_t>(pred.value)));
+        } else {
+            // Only keys within the chunk's range can occur in it
+            const auto& keys = pred.keys->keys();
+            auto first = keys.begin();
+            auto last = keys.end();
+            if (!cc.page_headers.empty() && cc.page_headers[0].stats.min_int.has_value() &&
+                cc.page_headers[0].stats.max_int.has_value()) {
+                first = std::lower_bound(keys.begin(), keys.end(), cc.page_headers[0].stats.min_int.value());
+                last = std::upper_bound(first, keys.end(), cc.page_headers[0].stats.max_int.value());
             }
+            any = std::any_of(first, last, [&](int64_t key) {
+                return present(hashInt64(static_cast<uint64_t>(key)));
+            });
         }
+        if (!any) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const ColumnIndex* Scanner::columnIndex(size_t pos) {
+    if (!rg_indexes_read_[pos]) {
+        rg_indexes_[pos] = reader_->readColumnIndex(current_row_group_, scan_indices_[pos]);
+        rg_indexes_read_[pos] = 1;
     }
+    return rg_indexes_[pos] ? &*rg_indexes_[pos] : nullptr;
+}
 
-    std::vector<std::pair<std::string, AggResult>> results(groups.begin(), groups.end());
-    std::sort(results.begin(), results.end(),
-              [](const auto& a, const auto& b) { return a.first < b.first; });
+void Scanner::applyColumnIndexes() {
+    const auto& rg = reader_->metadata().row_groups[current_row_group_];
 
-    return results;
+    // Indexes of the integer filter columns; all chunks of a row group
+    // share a block size
+    std::vector<const ColumnIndex*> indexes(scan_indices_.size(), nullptr);
+    const ColumnIndex* any = nullptr;
+    auto use = [&](size_t pos) {
+        const auto& cc = rg.column_chunks[scan_indices_[pos]];
+        if (cc.index_size != 0 && !indexes[pos]) {
+            indexes[pos] = columnIndex(pos);
+            any = any ? any : indexes[pos];
+        }
+    };
+    for (size_t i = 0; i < filters_.size(); i++) {
+        if (!filters_[i].onStrings()) {
+            use(filter_positions_[i]);
+        }
+    }
+    std::vector<std::string> expr_columns;
+    for (const auto& expr : exprs_) {
+        expr.collectColumns(expr_columns);
+    }
+    auto position = [&](const std::string& column) {
+        auto it = std::find(scan_indices_.begin(), scan_indices_.end(), reader_->schema().columnIndex(column));
+        return static_cast<size_t>(it - scan_indices_.begin());
+    };
+    for (const auto& column : expr_columns) {
+        use(position(column));
+    }
+    if (!any) {
+        return;
+    }
+
+    size_t rows_per_block = any->rows_per_block;
+    std::vector<PageStats> block_stats(scan_indices_.size());
+    size_t block = 0;
+    auto stats = [&](size_t pos) -> const PageStats* {
+        const auto* index = indexes[pos];
+        if (!index || index->rows_per_block != rows_per_block) {
+            const auto& cc = rg.column_chunks[scan_indices_[pos]];
+            return cc.page_headers.empty() ? nullptr : &cc.page_headers[0].stats;
+        }
+        block_stats[pos].min_int = index->min_values[block];
+        block_stats[pos].max_int = index->max_values[block];
+        return &block_stats[pos];
+    };
+
+    // Blocks that may hold matches, adjacent ones merged into one range
+    std::vector<std::pair<size_t, size_t>> ranges;
+    for (block = 0; block < any->numBlocks(); block++) {
+        bool keep = true;
+        for (size_t i = 0; i < filters_.size() && keep; i++) {
+            const PageStats* block_pred_stats = filters_[i].onStrings() ? nullptr : stats(filter_positions_[i]);
+            keep = !block_pred_stats || !filters_[i].canSkipPage(*block_pred_stats);
+        }
+        for (size_t e = 0; e < exprs_.size() && keep; e++) {
+            keep = exprs_[e].matchStats([&](const std::string& column) { return stats(position(column)); }) !=
+                   StatsMatch::NEVER;
+        }
+        if (!keep) {
+            continue;
+        }
+
+        size_t begin = std::max(block * rows_per_block, current_offset_);
+        size_t end = std::min<size_t>((block + 1) * rows_per_block, rg.num_rows);
+        if (begin >= end) {
+            continue;
+        }
+        if (!ranges.empty() && ranges.back().second == begin) {
+            ranges.back().second = end;
+        } else {
+            ranges.emplace_back(begin, end);
+        }
+    }
+    rg_ranges_ = std::move(ranges);
+}
+
+bool Scanner::loadRowGroup() {
+    if (bloomSkipsRowGroup()) {
+        releaseRowGroup();
+        return false;
+    }
+
+    const auto& rg = reader_->metadata().row_groups[current_row_group_];
+
+    rg_columns_.assign(scan_indices_.size(), Batch::ColumnData{});
+    rg_dictionaries_.assign(scan_indices_.size(), nullptr);
+    rg_dict_matches_.assign(filters_.size(), {});
+    rg_expr_matches_.clear();
+    rg_indexes_.assign(scan_indices_.size(), std::nullopt);
+    rg_indexes_read_.assign(scan_indices_.size(), 0);
+    rg_ranges_.assign(1, {current_offset_, rg.num_rows});
+    rg_range_ = 0;
+
+    // Column indexes narrow the rows to blocks before any page is read
+    if (hasFilters()) {
+        applyColumnIndexes();
+        if (rg_ranges_.empty()) {
+            releaseRowGroup();
+            return false;
+        }
+    }
+
+    // Chunks with a seekable column index decode only the blocks of the
+    // ranges; rows outside them are left zero and never returned
+    auto read_ranges = [&](size_t pos, auto read_blocks, auto read_column) -> Batch::ColumnData {
+        bool whole = rg_ranges_.size() == 1 && rg_ranges_[0].first == 0 && rg_ranges_[0].second == rg.num_rows;
+        const ColumnIndex* index = whole || rg.column_chunks[scan_indices_[pos]].index_size == 0 ? nullptr
+                                                                                                 : columnIndex(pos);
+        if (!index || !index->seekable()) {
+            return read_column();
+        }
+
+        decltype(read_column()) values(rg.num_rows);
+        size_t rows_per_block = index->rows_per_block;
+        for (const auto& [begin, end] : rg_ranges_) {
+            size_t first_block = begin / rows_per_block;
+            auto part = read_blocks(*index, first_block, (end + rows_per_block - 1) / rows_per_block);
+            std::copy(part.begin(), part.end(), values.begin() + static_cast<std::ptrdiff_t>(first_block * rows_per_block));
+        }
+        return values;
+    };
+
+    // String leaves of expressions are evaluated on codes as well
+    auto position = [&](const std::string& column) {
+        auto it = std::find(scan_indices_.begin(), scan_indices_.end(), reader_->schema().columnIndex(column));
+        return static_cast<size_t>(it - scan_indices_.begin());
+    };
+    std::vector<uint8_t> expr_strings(scan_indices_.size(), 0);
+    for (const auto& expr : exprs_) {
+        forEachPredicate(expr, [&](const Predicate& pred) {
+            if (pred.onStrings()) {
+                expr_strings[position(pred.column)] = 1;
+            }
+        });
+    }
+
+    auto load = [&](size_t pos) {
+        size_t col_idx = scan_indices_[pos];
+        const auto& cc = rg.column_chunks[col_idx];
+        bool dictionary = !cc.page_headers.empty() && cc.page_headers[0].encoding == EncodingType::DICTIONARY;
+
+        // String filters are evaluated on codes, and the rows that pass are
+        // decoded afterwards
+        bool filtered = expr_strings[pos] != 0;
+        for (size_t i = 0; i < filters_.size(); i++) {
+            filtered = filtered || (filter_positions_[i] == pos && filters_[i].onStrings());
+        }
+        bool as_codes = dictionary &&
+                        (filtered || std::find(code_columns_.begin(), code_columns_.end(), col_idx) != code_columns_.end());
+        if (as_codes) {
+            auto dict_col = reader_->readDictionaryColumn(current_row_group_, col_idx);
+            rg_dictionaries_[pos] = std::make_shared<const std::vector<std::string>>(std::move(dict_col.dictionary));
+            rg_columns_[pos] = std::move(dict_col.codes);
+            return;
+        }
+
+        switch (reader_->schema().columns[col_idx].type) {
+        case ColumnType::INT32:
+            rg_columns_[pos] = read_ranges(
+                pos,
+                [&](const ColumnIndex& index, size_t first, size_t end) {
+                    return reader_->readInt32Blocks(current_row_group_, col_idx, index, first, end);
+                },
+                [&] { return reader_->readInt32Column(current_row_group_, col_idx); });
+            break;
+        case ColumnType::INT64:
+            rg_columns_[pos] = read_ranges(
+                pos,
+                [&](const ColumnIndex& index, size_t first, size_t end) {
+                    return reader_->readInt64Blocks(current_row_group_, col_idx, index, first, end);
+                },
+                [&] { return reader_->readInt64Column(current_row_group_, col_idx); });
+            break;
+        case ColumnType::STRING:
+            rg_columns_[pos] = reader_->readStringColumn(current_row_group_, col_idx);
+            break;
+        }
+    };
+
+    // Columns with string filters come first: when a filter matches no
+    // dictionary entry, the other columns are never read
+    std::vector<bool> loaded(scan_indices_.size(), false);
+    for (size_t i = 0; i < filters_.size(); i++) {
+        size_t pos = filter_positions_[i];
+        if (!filters_[i].onStrings()) {
+            continue;
+        }
+        if (!loaded[pos]) {
+            load(pos);
+            loaded[pos] = true;
+        }
+        if (!rg_dictionaries_[pos]) {
+            continue;
+        }
+
+        const auto& dictionary = *rg_dictionaries_[pos];
+        auto& matches = rg_dict_matches_[i];
+        matches.resize(dictionary.size());
+        bool any = false;
+        for (size_t entry = 0; entry < dictionary.size(); entry++) {
+            matches[entry] = filters_[i].evaluate(dictionary[entry]) ? 1 : 0;
+            any = any || matches[entry] != 0;
+        }
+        if (!any) {
+            releaseRowGroup();
+            return false;
+        }
+    }
+
+    // Then filters on sorted chunks narrow each range by binary search
+    rg_settled_.assign(filters_.size(), 0);
+    for (size_t i = 0; i < filters_.size(); i++) {
+        size_t pos = filter_positions_[i];
+        if (rg.column_chunks[scan_indices_[pos]].sort_order == ChunkOrder::UNSORTED) {
+            continue;
+        }
+        if (!loaded[pos]) {
+            load(pos);
+            loaded[pos] = true;
+        }
+        if (rg_dictionaries_[pos]) {
+            continue;
+        }
+
+        std::vector<std::pair<size_t, size_t>> narrowed;
+        bool settled = true;
+        for (const auto& [begin, end] : rg_ranges_) {
+            auto range = std::visit([&](const auto& vals) {
+                return sortedRange(vals, begin, end, filters_[i], rg.column_chunks[scan_indices_[pos]].sort_order);
+            }, rg_columns_[pos]);
+            if (!range) {
+                settled = false;
+                break;
+            }
+            if (range->first < range->second) {
+                narrowed.push_back(*range);
+            }
+        }
+        if (settled) {
+            rg_ranges_ = std::move(narrowed);
+            rg_settled_[i] = 1;
+        }
+        if (rg_ranges_.empty()) {
+            releaseRowGroup();
+            return false;
+        }
+    }
+
+    for (size_t pos = 0; pos < scan_indices_.size(); pos++) {
+        if (!loaded[pos]) {
+            load(pos);
+        }
+    }
+
+    // Dictionary entries passing each string leaf of an expression
+    for (const auto& expr : exprs_) {
+        forEachPredicate(expr, [&](const Predicate& pred) {
+            size_t pos = position(pred.column);
+            if (!pred.onStrings() || !rg_dictionaries_[pos]) {
+                return;
+            }
+            const auto& dictionary = *rg_dictionaries_[pos];
+            std::vector<uint8_t> matches(dictionary.size());
+            for (size_t entry = 0; entry < dictionary.size(); entry++) {
+                matches[entry] = pred.evaluate(dictionary[entry]) ? 1 : 0;
+            }
+            rg_expr_matches_.emplace_back(&pred, std::move(matches));
+        });
+    }
+
+    rg_loaded_ = true;
+    return true;
+}
+
+void Scanner::releaseRowGroup() {
+    rg_columns_.clear();
+    rg_dictionaries_.clear();
+    rg_dict_matches_.clear();
+    rg_expr_matches_.clear();
+    rg_settled_.clear();
+    rg_ranges_.clear();
+    rg_indexes_.clear();
+    rg_indexes_read_.clear();
+    current_offset_ = 0;
+    rg_loaded_ = false;
+}
+
+Batch Scanner::next() {
+    if (!hasNext()) {
+        throw std::runtime_error("No more batches");
+    }
+
+    if (!rg_loaded_) {
+        loadRowGroup();
+    }
+
+    const auto& range = rg_ranges_[rg_range_];
+    size_t begin = std::max(current_offset_, range.first);
+    size_t end = std::min(begin + batch_size_, range.second);
+    current_offset_ = end;
+    if (end == range.second) {
+        rg_range_++;
+    }
+
+    // Selected columns read as codes only for a string filter are decoded
+    // here, one string per returned row
+    Batch batch;
+    batch.column_names = selected_columns_;
+    std::vector<bool> decode(selected_columns_.size(), false);
+    for (size_t i = 0; i < selected_columns_.size(); i++) {
+        bool as_codes = std::find(code_columns_.begin(), code_columns_.end(), column_indices_[i]) != code_columns_.end();
+        decode[i] = rg_dictionaries_[i] && !as_codes;
+    }
+    if (!code_columns_.empty()) {
+        batch.dictionaries.assign(selected_columns_.size(), nullptr);
+        for (size_t i = 0; i < selected_columns_.size(); i++) {
+            batch.dictionaries[i] = decode[i] ? nullptr : rg_dictionaries_[i];
+        }
+    }
+
+    auto output = [&](const std::vector<uint32_t>* sel) {
+        for (size_t i = 0; i < selected_columns_.size(); i++) {
+            if (decode[i]) {
+                batch.columns.push_back(decodeCodes(std::get<std::vector<int32_t>>(rg_columns_[i]),
+                                                    *rg_dictionaries_[i], begin, end, sel));
+            } else if (sel) {
+                batch.columns.push_back(gatherColumn(rg_columns_[i], *sel));
+            } else {
+                batch.columns.push_back(sliceColumn(rg_columns_[i], begin, end - begin));
+            }
+        }
+    };
+
+    if (!hasFilters()) {
+        batch.num_rows = end - begin;
+        output(nullptr);
+        return batch;
+    }
+
+    std::vector<uint32_t> sel;
+    bool first = true;
+
+    for (size_t i = 0; i < filters_.size(); i++) {
+        if (rg_settled_[i]) {
+            continue;
+        }
+        const auto& col = rg_columns_[filter_positions_[i]];
+        if (rg_dictionaries_[filter_positions_[i]]) {
+            selectCodes(std::get<std::vector<int32_t>>(col), rg_dict_matches_[i], begin, end, first, sel);
+        } else {
+            std::visit([&](const auto& vals) {
+                selectRows(vals, filters_[i], begin, end, first, sel);
+            }, col);
+        }
+        first = false;
+    }
+
+    // Expressions are evaluated over the whole batch, then intersected
+    // with the selection of the plain predicates
+    auto column = [&](const std::string& name) -> const Batch::ColumnData& {
+        size_t col_idx = reader_->schema().columnIndex(name);
+        auto it = std::find(scan_indices_.begin(), scan_indices_.end(), col_idx);
+        return rg_columns_[static_cast<size_t>(it - scan_indices_.begin())];
+    };
+    auto code_matches = [&](const Predicate& pred) -> const std::vector<uint8_t>* {
+        for (const auto& [leaf, matches] : rg_expr_matches_) {
+            if (leaf == &pred) {
+                return &matches;
+            }
+        }
+        return nullptr;
+    };
+    for (const auto& expr : exprs_) {
+        expr.evaluate(column, begin, end, expr_bits_, code_matches);
+        auto passes = [&](uint32_t row) {
+            size_t i = row - begin;
+            return ((expr_bits_[i / 64] >> (i % 64)) & 1) != 0;
+        };
+
+        if (first) {
+            sel.clear();
+            for (size_t w = 0; w < expr_bits_.size(); w++) {
+                for (uint64_t word = expr_bits_[w]; word != 0; word &= word - 1) {
+                    sel.push_back(static_cast<uint32_t>(begin + w * 64 + static_cast<size_t>(std::countr_zero(word))));
+                }
+            }
+            first = false;
+        } else {
+            sel.erase(std::remove_if(sel.begin(), sel.end(), [&](uint32_t row) { return !passes(row); }), sel.end());
+        }
+    }
+
+    // Every row in range passes filters settled by the sorted range
+    if (first) {
+        batch.num_rows = end - begin;
+        output(nullptr);
+        return batch;
+    }
+
+    batch.num_rows = sel.size();
+    output(&sel);
+    return batch;
+}
+
+// Result stream
+ResultStream::ResultStream(std::unique_ptr<Scanner> scanner,
+                           std::optional<size_t> limit,
+                           size_t offset)
+    : scanner_(std::move(scanner))
+    , limit_(limit)
+    , offset_(offset) {
+
+    // Without filters every row counts towards OFFSET, so whole row groups
+    // can be skipped from metadata instead of being decoded and dropped
+    if (scanner_ && offset_ > 0 && !scanner_->hasFilters()) {
+        offset_ -= scanner_->skipRows(offset_);
+    }
+}
+
+ResultStream::ResultStream(std::unique_ptr<BatchSource> source,
+                           std::optional<size_t> limit,
+                           size_t offset)
+    : source_(std::move(source))
+    , limit_(limit)
+    , offset_(offset) {}
+
+namespace {
+
+// Batches computed up front
+class BatchListSource : public BatchSource {
+public:
+    explicit BatchListSource(std::vector<Batch> batches)
+        : batches_(std::move(batches)) {}
+
+    bool hasNext() override { return next_ < batches_.size(); }
+    Batch next() override { return std::move(batches_[next_++]); }
+
+private:
+    std::vector<Batch> batches_;
+    size_t next_ = 0;
+};
+
+} // namespace
+
+ResultStream::ResultStream(std::vector<Batch> batches)
+    : ResultStream(std::unique_ptr<BatchSource>(std::make_unique<BatchListSource>(std::move(batches)))) {}
+
+bool ResultStream::hasNext() {
+    while (!pending_.has_value() && (scanner_ || source_)) {
+        if (limit_.has_value() && limit_.value() == 0) {
+            // Stop issuing row group reads once enough rows were produced
+            scanner_.reset();
+            source_.reset();
+            break;
+        }
+        if (scanner_ ? !scanner_->hasNext() : !source_->hasNext()) {
+            break;
+        }
+
+        Batch batch = scanner_ ? scanner_->next() : source_->next();
+
+        size_t begin = std::min(offset_, batch.num_rows);
+        offset_ -= begin;
+        size_t count = batch.num_rows - begin;
+        if (limit_.has_value()) {
+            count = std::min(count, limit_.value());
+            limit_ = limit_.value() - count;
+        }
+
+        if (count == 0) {
+            continue;
+        }
+        if (count != batch.num_rows) {
+            for (auto& col : batch.columns) {
+                col = sliceColumn(col, begin, count);
+            }
+            batch.num_rows = count;
+        }
+        pending_ = std::move(batch);
+    }
+    return pending_.has_value();
+}
+
+Batch ResultStream::next() {
+    if (!hasNext()) {
+        throw std::runtime_error("No more batches");
+    }
+
+    Batch batch = std::move(pending_.value());
+    pending_.reset();
+    return batch;
+}
+
+void ResultStream::close() {
+    scanner_.reset();
+    source_.reset();
+    pending_.reset();
+}
+
+// Query executor
+QueryExecutor::QueryExecutor(std::shared_ptr<FileReader> reader)
+    : reader_(std::move(reader))
+    , batch_size_(4096)
+    , offset_(0)
+    , order_descending_(false)
+    , pruned_row_groups_(0)
+    , num_threads_(1)
+    , memory_budget_(0)
+    , spilled_rows_(0)
+    , distinct_error_(0.01) {}
+
+void QueryExecutor::setProjection(std::vector<std::string> columns) {
+    projection_ = std::move(columns);
+}
+
+void QueryExecutor::addFilter(Predicate pred) {
+    filters_.push_back(std::move(pred));
+}
+
+void QueryExecutor::addFilter(FilterExpr expr) {
+    filters_.push_back(std::move(expr));
+}
+
+void QueryExecutor::setAggregation(AggFunc func, std::string column) {
+    aggregations_.clear();
+    addAggregation(func, std::move(column));
+}
+
+void QueryExecutor::addAggregation(AggFunc func, std::string column, std::vector<Predicate> filters) {
+    aggregations_.push_back(AggSpec{func, std::move(column), std::move(filters)});
+}
+
+void QueryExecutor::setGroupBy(std::string column) {
+    group_by_columns_ = {std::move(column)};
+}
+
+void QueryExecutor::setGroupByColumns(std::vector<std::string> columns) {
+    group_by_columns_ = std::move(columns);
+}
+
+void QueryExecutor::setBatchSize(size_t batch_size) {
+    batch_size_ = batch_size;
+}
+
+void QueryExecutor::setThreads(size_t num_threads) {
+    num_threads_ = num_threads;
+}
+
+size_t QueryExecutor::workerCount(size_t num_tasks) const {
+    size_t threads = num_threads_;
+    if (threads == 0) {
+        threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    return std::max<size_t>(std::min(threads, num_tasks), 1);
+}
+
+void QueryExecutor::setMemoryBudget(size_t bytes) {
+    memory_budget_ = bytes;
+}
+
+void QueryExecutor::setSpillDirectory(std::string path) {
+    spill_directory_ = std::move(path);
+}
+
+void QueryExecutor::setDistinctError(double relative_error) {
+    HyperLogLog::precisionForError(relative_error);  // Validates the error
+    distinct_error_ = relative_error;
+}
+
+void QueryExecutor::setLimit(size_t limit, size_t offset) {
+    limit_ = limit;
+    offset_ = offset;
+}
+
+void QueryExecutor::setOrderBy(std::string column, bool descending) {
+    order_by_ = std::move(column);
+    order_descending_ = descending;
+}
+
+ResultStream QueryExecutor::executeStream() {
+    std::vector<std::string> scan_columns = projection_.empty() ?
+        [this]() {
+            std::vector<std::string> cols;
+            for (const auto& c : reader_->schema().columns) {
+                cols.push_back(c.name);
+            }
+            return cols;
+        }() : projection_;
+
+    if (!order_by_.empty()) {
+        // Small limits keep a heap; anything else sorts the whole input
+        if (limit_.has_value() && limit_.value() <= TOP_N_MAX_ROWS && offset_ <= TOP_N_MAX_ROWS) {
+            return ResultStream(executeTopN(std::move(scan_columns)));
+        }
+        return ResultStream(executeSort(std::move(scan_columns)), limit_, offset_);
+    }
+
+    // Without filters the scan needs at most offset + limit rows, so a small
+    // LIMIT does not need full-size batches. With filters the matches may be
+    // sparse: the scan keeps full batches and the stream trims them.
+    size_t batch_size = batch_size_;
+    if (limit_.has_value() && filters_.empty()) {
+        size_t needed = std::max<size_t>(limit_.value(), 1);
+        needed = offset_ > std::numeric_limits<size_t>::max() - needed ? std::numeric_limits<size_t>::max()
+                                                                        : needed + offset_;
+        batch_size = std::min(batch_size_, needed);
+    }
+    auto scanner = std::make_unique<Scanner>(reader_, scan_columns, batch_size);
+
+    for (const auto& filter : filters_) {
+        scanner->addFilter(filter);
+    }
+
+    return ResultStream(std::move(scanner), limit_, offset_);
+}
+
+std::vector<Batch> QueryExecutor::executeQuery() {
+    ResultStream stream = executeStream();
+
+    std::vector<Batch> results;
+    while (stream.hasNext()) {
+        results.push_back(stream.next());
+    }
+
+    return results;
+}
+
+std::vector<Batch> QueryExecutor::executeTopN(std::vector<std::string> scan_columns) {
+    const auto& metadata = reader_->metadata();
+    size_t key_col_idx = reader_->schema().columnIndex(order_by_);
+
+    // The key column is scanned even when not projected, then dropped
+    auto key_it = std::find(scan_columns.begin(), scan_columns.end(), order_by_);
+    bool drop_key = key_it == scan_columns.end();
+    size_t key_pos = static_cast<size_t>(key_it - scan_columns.begin());
+    if (drop_key) {
+        scan_columns.push_back(order_by_);
+    }
+
+    pruned_row_groups_ = 0;
+    size_t keep = limit_.value() + offset_;
+
+    auto run = [&](auto key_tag) {
+        using Key = decltype(key_tag);
+        SortOrder<Key> order{order_descending_};
+        TopN<Key> top(keep, order);
+
+        // Bound on the best key a row group can contribute: its max for
+        // descending order, its min for ascending (from page stats; string
+        // bounds may be truncated, which keeps them bounds)
+        struct Candidate {
+            size_t rg_idx;
+            std::optional<Key> best;
+        };
+        std::vector<Candidate> candidates;
+        for (size_t rg_idx = 0; rg_idx < metadata.row_groups.size(); rg_idx++) {
+            if (matchRowGroup(rg_idx, filters_) == StatsMatch::NEVER) {
+                continue;
+            }
+            Candidate candidate{rg_idx, std::nullopt};
+            const auto& cc = metadata.row_groups[rg_idx].column_chunks[key_col_idx];
+            if (cc.page_headers.size() == 1) {
+                const auto& stats = cc.page_headers[0].stats;
+                if constexpr (std::is_same_v<Key, int64_t>) {
+                    candidate.best = order_descending_ ? stats.max_int : stats.min_int;
+                } else {
+                    candidate.best = order_descending_ ? stats.max_string : stats.min_string;
+                }
+            }
+            candidates.push_back(std::move(candidate));
+        }
+
+        // Visit row groups best first (those without stats before all
+        // others), so the heap fills with rows that are hard to beat and
+        // the remaining row groups are skipped from their stats
+        std::stable_sort(candidates.begin(), candidates.end(), [&](const Candidate& a, const Candidate& b) {
+            if (a.best.has_value() != b.best.has_value()) {
+                return !a.best.has_value();
+            }
+            return a.best.has_value() && order.before(a.best.value(), 0, b.best.value(), 0);
+        });
+
+        Scanner scanner(reader_, scan_columns, batch_size_);
+        for (const auto& filter : filters_) {
+            scanner.addFilter(filter);
+        }
+
+        for (size_t i = 0; i < candidates.size(); i++) {
+            const auto& candidate = candidates[i];
+            if (candidate.best.has_value() && !top.admits(candidate.best.value(), rowPosition(candidate.rg_idx, 0))) {
+                // Later row groups cannot do better unless they tie at an
+                // earlier position
+                if (!top.admits(candidate.best.value(), 0)) {
+                    pruned_row_groups_ += candidates.size() - i;
+                    break;
+                }
+                pruned_row_groups_++;
+                continue;
+            }
+
+            scanner.setRowGroups({candidate.rg_idx});
+            size_t row = 0;
+            while (scanner.hasNext()) {
+                Batch batch = scanner.next();
+                top.add(batch, key_pos, rowPosition(candidate.rg_idx, row));
+                row += batch.num_rows;
+            }
+        }
+        return top.finish(offset_, batch_size_);
+    };
+
+    std::vector<Batch> batches = metadata.schema.columns[key_col_idx].type == ColumnType::STRING
+        ? run(std::string{})
+        : run(int64_t{});
+
+    if (drop_key) {
+        for (auto& batch : batches) {
+            batch.columns.pop_back();
+            batch.column_names.pop_back();
+        }
+    }
+    return batches;
+}
+
+StatsMatch QueryExecutor::matchRowGroup(size_t rg_idx, const std::vector<Predicate>& filters) const {
+    const auto& rg = reader_->metadata().row_groups[rg_idx];
+
+    StatsMatch result = StatsMatch::ALWAYS;
+    for (const auto& filter : filters) {
+        const auto& cc = rg.column_chunks[reader_->schema().columnIndex(filter.column)];
+        if (cc.page_headers.empty()) {
+            return StatsMatch::MAYBE;
+        }
+
+        StatsMatch match = filter.matchStats(cc.page_headers[0].stats);
+        if (match == StatsMatch::NEVER) {
+            return StatsMatch::NEVER;
+        }
+        if (match == StatsMatch::MAYBE) {
+            result = StatsMatch::MAYBE;
+        }
+    }
+    return result;
+}
+
+StatsMatch QueryExecutor::matchRowGroup(size_t rg_idx, const std::vector<FilterExpr>& filters) const {
+    const auto& rg = reader_->metadata().row_groups[rg_idx];
+    auto stats = [&](const std::string& column) -> const PageStats* {
+        const auto& cc = rg.column_chunks[reader_->schema().columnIndex(column)];
+        return cc.page_headers.empty() ? nullptr : &cc.page_headers[0].stats;
+    };
+
+    StatsMatch result = StatsMatch::ALWAYS;
+    for (const auto& filter : filters) {
+        StatsMatch match = filter.matchStats(stats);
+        if (match == StatsMatch::NEVER) {
+            return StatsMatch::NEVER;
+        }
+        if (match == StatsMatch::MAYBE) {
+            result = StatsMatch::MAYBE;
+        }
+    }
+    return result;
+}
+
+void runWorkers(size_t num_workers, const std::function<void(size_t)>& task) {
+    if (num_workers <= 1) {
+        task(0);
+        return;
+    }
+
+    std::vector<std::exception_ptr> errors(num_workers);
+    std::vector<std::thread> threads;
+    threads.reserve(num_workers);
+    for (size_t w = 0; w < num_workers; w++) {
+        threads.emplace_back([&task, &errors, w]() {
+            try {
+                task(w);
+            } catch (...) {
+                errors[w] = std::current_exception();
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+// Aggregation helpers
+namespace {
+
+constexpr size_t NO_COLUMN = static_cast<size_t>(-1);
+
+// Position of a column among the scan columns, appending it if missing
+size_t scanColumnPosition(std::vector<std::string>& scan_columns, const std::string& name) {
+    auto it = std::find(scan_columns.begin(), scan_columns.end(), name);
+    if (it != scan_columns.end()) {
+        return static_cast<size_t>(it - scan_columns.begin());
+    }
+    scan_columns.push_back(name);
+    return scan_columns.size() - 1;
+}
+
+// Batch columns read by each aggregate: its values (NO_COLUMN for COUNT)
+// and the columns of its own filters
+struct AggColumns {
+    std::vector<size_t> value_positions;
+    std::vector<std::vector<size_t>> filter_positions;
+};
+
+AggColumns planAggColumns(const std::vector<AggSpec>& specs, std::vector<std::string>& scan_columns) {
+    AggColumns cols;
+    for (const auto& spec : specs) {
+        cols.value_positions.push_back(spec.func != AggFunc::COUNT ?
+            scanColumnPosition(scan_columns, spec.column) : NO_COLUMN);
+
+        std::vector<size_t> positions;
+        for (const auto& filter : spec.filters) {
+            positions.push_back(scanColumnPosition(scan_columns, filter.column));
+        }
+        cols.filter_positions.push_back(std::move(positions));
+    }
+    return cols;
+}
+
+// Rows of a batch passing an aggregate's own filters. Returns false when
+// there are none, meaning every row passes. String filters on dictionary
+// codes are evaluated once per dictionary entry.
+bool selectAggRows(const Batch& batch, const std::vector<Predicate>& filters,
+                   const std::vector<size_t>& positions, std::vector<uint32_t>& sel) {
+    bool first = true;
+    for (size_t i = 0; i < filters.size(); i++) {
+        const auto& col = batch.columns[positions[i]];
+        const auto* dictionary = batch.dictionary(positions[i]);
+        bool string_column = dictionary != nullptr || std::holds_alternative<std::vector<std::string>>(col);
+        if (string_column != filters[i].onStrings()) {
+            throw std::runtime_error(string_column ? "Numeric predicate on STRING column: " + filters[i].column
+                                                   : "String predicate on integer column: " + filters[i].column);
+        }
+
+        if (dictionary != nullptr) {
+            std::vector<uint8_t> matches(dictionary->size());
+            for (size_t entry = 0; entry < matches.size(); entry++) {
+                matches[entry] = filters[i].evaluate((*dictionary)[entry]) ? 1 : 0;
+            }
+            selectCodes(std::get<std::vector<int32_t>>(col), matches, 0, batch.num_rows, first, sel);
+        } else {
+            std::visit([&](const auto& vals) {
+                selectRows(vals, filters[i], 0, batch.num_rows, first, sel);
+            }, col);
+        }
+        first = false;
+    }
+    return !first;
+}
+
+bool countsDistinct(AggFunc func) {
+    return func == AggFunc::COUNT_DISTINCT || func == AggFunc::APPROX_COUNT_DISTINCT;
+}
+
+// COUNT(DISTINCT) state: an exact set of the values (integer or string
+// group table) or, in approximate mode, a HyperLogLog sketch. Dictionary
+// codes are only marked as seen; the seen entries of a dictionary are added
+// once, when the next row group's dictionary arrives or on flush().
+struct DistinctCounter {
+    std::optional<HyperLogLog> sketch;
+    IntGroupTable ints;
+    StringGroupTable strings;
+
+    std::shared_ptr<const std::vector<std::string>> dictionary;
+    std::vector<uint8_t> seen_codes;
+
+    void add(const Batch::ColumnData& col, std::shared_ptr<const std::vector<std::string>> dict) {
+        if (dict != nullptr) {
+            if (dict != dictionary) {
+                flush();
+                dictionary = std::move(dict);
+                seen_codes.assign(dictionary->size(), 0);
+            }
+            for (int32_t code : std::get<std::vector<int32_t>>(col)) {
+                seen_codes[static_cast<size_t>(code)] = 1;
+            }
+            return;
+        }
+
+        std::visit([&](const auto& vals) { addValues(vals); }, col);
+    }
+
+    template<typename Vec>
+    void addValues(const Vec& vals) {
+        if (sketch.has_value()) {
+            hashColumn(vals, hashes_);
+            sketch->add(hashes_);
+        } else if constexpr (std::is_same_v<Vec, std::vector<std::string>>) {
+            strings.findOrInsert(vals, ids_);
+        } else {
+            ints.findOrInsert(vals, ids_);
+        }
+    }
+
+    void flush() {
+        if (dictionary == nullptr) {
+            return;
+        }
+        std::vector<std::string> used;
+        for (size_t code = 0; code < seen_codes.size(); code++) {
+            if (seen_codes[code] != 0) {
+                used.push_back((*dictionary)[code]);
+            }
+        }
+        addValues(used);
+        dictionary.reset();
+    }
+
+    // other must be flushed
+    void merge(const DistinctCounter& other) {
+        if (sketch.has_value()) {
+            // At the coarser precision of the two
+            const auto& theirs = other.sketch.value();
+            if (theirs.precision() < sketch->precision()) {
+                sketch = sketch->reduce(theirs.precision());
+            }
+            sketch->merge(theirs.precision() == sketch->precision() ? theirs : theirs.reduce(sketch->precision()));
+            return;
+        }
+
+        std::vector<int64_t> int_keys;
+        for (uint32_t g = 0; g < other.ints.size(); g++) {
+            int_keys.push_back(other.ints.key(g));
+        }
+        addValues(int_keys);
+
+        std::vector<std::string> string_keys;
+        for (uint32_t g = 0; g < other.strings.size(); g++) {
+            string_keys.emplace_back(other.strings.key(g));
+        }
+        addValues(string_keys);
+    }
+
+    int64_t count() const {
+        if (sketch.has_value()) {
+            return static_cast<int64_t>(std::llround(sketch->estimate()));
+        }
+        return static_cast<int64_t>(ints.size() + strings.size());
+    }
+
+private:
+    std::vector<uint32_t> ids_;
+    std::vector<uint64_t> hashes_;
+};
+
+// Running state of one ungrouped aggregate. Batches are summed in int64
+// with wrap counting (see addWrapping) and folded into the exact sum once
+// per batch. Variance states take each batch's mean and M2 in a second pass
+// over the cache-resident batch and merge them in.
+struct AggAccumulator {
+    int64_t count = 0;
+    Int128 sum;
+    std::optional<int64_t> min;
+    std::optional<int64_t> max;
+
+    bool moments = false;
+    int64_t moment_count = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+
+    std::optional<DistinctCounter> distinct;
+
+    void mergeMinMax(int64_t min_val, int64_t max_val) {
+        if (!min.has_value() || min_val < min.value()) {
+            min = min_val;
+        }
+        if (!max.has_value() || max_val > max.value()) {
+            max = max_val;
+        }
+    }
+
+    template<typename T>
+    void addValues(const std::vector<T>& vals) {
+        int64_t batch_sum = 0;
+        int64_t batch_wraps = 0;
+        int64_t min_val = vals[0];
+        int64_t max_val = vals[0];
+        for (T val : vals) {
+            addWrapping(batch_sum, batch_wraps, val);
+            min_val = std::min<int64_t>(min_val, val);
+            max_val = std::max<int64_t>(max_val, val);
+        }
+        Int128 exact = wrappedSum(batch_sum, batch_wraps);
+        sum += exact;
+        mergeMinMax(min_val, max_val);
+
+        if (moments) {
+            double batch_mean = exact.toDouble() / static_cast<double>(vals.size());
+            double batch_m2 = 0.0;
+            for (T val : vals) {
+                double delta = static_cast<double>(val) - batch_mean;
+                batch_m2 += delta * delta;
+            }
+            mergeMoments(moment_count, mean, m2, static_cast<int64_t>(vals.size()), batch_mean, batch_m2);
+        }
+    }
+
+    // dict is set when col holds dictionary codes, which only distinct
+    // counts read
+    void addColumn(const Batch::ColumnData& col, std::shared_ptr<const std::vector<std::string>> dict) {
+        if (distinct.has_value()) {
+            distinct->add(col, std::move(dict));
+        } else if (dict != nullptr) {
+            return;
+        } else if (std::holds_alternative<std::vector<int32_t>>(col)) {
+            const auto& vals = std::get<std::vector<int32_t>>(col);
+            if (!vals.empty()) {
+                addValues(vals);
+            }
+        } else if (std::holds_alternative<std::vector<int64_t>>(col)) {
+            const auto& vals = std::get<std::vector<int64_t>>(col);
+            if (!vals.empty()) {
+                addValues(vals);
+            }
+        }
+    }
+
+    void merge(const AggAccumulator& other) {
+        count += other.count;
+        sum += other.sum;
+        if (other.min.has_value()) {
+            mergeMinMax(other.min.value(), other.max.value());
+        }
+        mergeMoments(moment_count, mean, m2, other.moment_count, other.mean, other.m2);
+        if (distinct.has_value()) {
+            distinct->merge(other.distinct.value());
+        }
+    }
+
+    AggResult result(const AggSpec& spec) const {
+        if (spec.func == AggFunc::SUM && !sum.fitsInt64()) {
+            throw std::runtime_error("SUM(" + spec.column + ") overflows int64");
+        }
+        AggResult r{};
+        r.count = count;
+        r.sum = sum.toInt64();
+        r.min = min;
+        r.max = max;
+        r.value = aggregateValue(spec.func, moments ? moment_count : count, sum, m2);
+        if (distinct.has_value()) {
+            r.distinct = distinct->count();
+            if (distinct->sketch.has_value()) {
+                r.sketch = std::make_shared<const HyperLogLog>(distinct->sketch.value());
+            }
+        }
+        return r;
+    }
+};
+
+std::vector<AggAccumulator> makeAccumulators(const std::vector<AggSpec>& specs, double distinct_error) {
+    std::vector<AggAccumulator> accs(specs.size());
+    for (size_t a = 0; a < specs.size(); a++) {
+        accs[a].moments = needsMoments(specs[a].func);
+        if (countsDistinct(specs[a].func)) {
+            accs[a].distinct.emplace();
+            if (specs[a].func == AggFunc::APPROX_COUNT_DISTINCT) {
+                accs[a].distinct->sketch.emplace(HyperLogLog::precisionForError(distinct_error));
+            }
+        }
+    }
+    return accs;
+}
+
+} // namespace
+
+AggResult QueryExecutor::executeAggregate() {
+    return executeAggregates().front();
+}
+
+std::vector<AggResult> QueryExecutor::executeAggregates() {
+    if (aggregations_.empty()) {
+        throw std::runtime_error("No aggregation specified");
+    }
+
+    const auto& metadata = reader_->metadata();
+    size_t num_aggs = aggregations_.size();
+    std::vector<AggAccumulator> accs = makeAccumulators(aggregations_, distinct_error_);
+
+    // Plan each aggregate per row group: row groups its filters (query and
+    // its own) fully contain are answered from metadata (COUNT from
+    // num_rows, SUM/MIN/MAX/AVG from page stats, APPROX_COUNT_DISTINCT from
+    // chunk sketches, at their precision when coarser than requested); row
+    // groups any aggregate still needs, and every row group of a variance or
+    // exact distinct count, are decoded once, in a single scan shared by all
+    // aggregates
+    std::vector<std::vector<bool>> needs_scan(metadata.row_groups.size(), std::vector<bool>(num_aggs, false));
+    std::vector<size_t> scan_row_groups;
+
+    for (size_t rg_idx = 0; rg_idx < metadata.row_groups.size(); rg_idx++) {
+        const auto& rg = metadata.row_groups[rg_idx];
+        StatsMatch query_match = matchRowGroup(rg_idx, filters_);
+
+        if (query_match == StatsMatch::NEVER || rg.num_rows == 0) {
+            continue;
+        }
+
+        bool scan = false;
+        for (size_t a = 0; a < num_aggs; a++) {
+            const auto& spec = aggregations_[a];
+            StatsMatch agg_match = matchRowGroup(rg_idx, spec.filters);
+            if (agg_match == StatsMatch::NEVER) {
+                continue;
+            }
+
+            if (query_match == StatsMatch::ALWAYS && agg_match == StatsMatch::ALWAYS &&
+                spec.func == AggFunc::APPROX_COUNT_DISTINCT) {
+                auto& sketch = accs[a].distinct->sketch.value();
+                auto chunk = reader_->distinctSketch(rg_idx, reader_->schema().columnIndex(spec.column));
+                if (chunk.has_value()) {
+                    // A coarser chunk sketch is cheaper at its larger error
+                    // than decoding the row group
+                    if (chunk->precision() < sketch.precision()) {
+                        sketch = sketch.reduce(chunk->precision());
+                    }
+                    accs[a].count += rg.num_rows;
+                    sketch.merge(chunk->reduce(sketch.precision()));
+                    continue;
+                }
+            }
+
+            if (query_match == StatsMatch::ALWAYS && agg_match == StatsMatch::ALWAYS &&
+                !needsMoments(spec.func) && !countsDistinct(spec.func)) {
+                if (spec.func == AggFunc::COUNT) {
+                    accs[a].count += rg.num_rows;
+                    continue;
+                }
+
+                const auto& cc = rg.column_chunks[reader_->schema().columnIndex(spec.column)];
+                if (!cc.page_headers.empty()) {
+                    const auto& stats = cc.page_headers[0].stats;
+                    bool has_min_max = stats.min_int.has_value() && stats.max_int.has_value();
+                    bool needs_sum = spec.func == AggFunc::SUM || spec.func == AggFunc::AVG;
+                    if (has_min_max && (!needs_sum || stats.sum.has_value())) {
+                        accs[a].count += rg.num_rows;
+                        accs[a].mergeMinMax(stats.min_int.value(), stats.max_int.value());
+                        if (stats.sum.has_value()) {
+                            accs[a].sum += stats.sum.value();
+                        }
+                        continue;
+                    }
+                }
+            }
+
+            needs_scan[rg_idx][a] = true;
+            scan = true;
+        }
+
+        if (scan) {
+            scan_row_groups.push_back(rg_idx);
+        }
+    }
+
+    if (!scan_row_groups.empty()) {
+        // A COUNT without own filters needs no columns beyond the query
+        // filter columns, which the scanner reads itself
+        std::vector<std::string> scan_columns;
+        AggColumns cols = planAggColumns(aggregations_, scan_columns);
+
+        // Workers claim row groups one at a time and accumulate into their
+        // own states, which are merged once at the end
+        size_t num_workers = workerCount(scan_row_groups.size());
+        std::vector<std::vector<AggAccumulator>> worker_accs(num_workers,
+                                                            makeAccumulators(aggregations_, distinct_error_));
+        std::atomic<size_t> next_rg{0};
+
+        runWorkers(num_workers, [&](size_t w) {
+            auto& local = worker_accs[w];
+            std::vector<uint32_t> sel;
+
+            Scanner scanner(reader_, scan_columns, batch_size_);
+            for (const auto& filter : filters_) {
+                scanner.addFilter(filter);
+            }
+            // Distinct counts of strings only need each row group's
+            // dictionary entries that occur
+            for (const auto& spec : aggregations_) {
+                if (countsDistinct(spec.func) &&
+                    reader_->schema().columns[reader_->schema().columnIndex(spec.column)].type == ColumnType::STRING) {
+                    scanner.setDictionaryCodes(spec.column);
+                }
+            }
+
+            for (size_t i = next_rg++; i < scan_row_groups.size(); i = next_rg++) {
+                const auto& rg_needs = needs_scan[scan_row_groups[i]];
+                scanner.setRowGroups({scan_row_groups[i]});
+
+                while (scanner.hasNext()) {
+                    Batch batch = scanner.next();
+                    if (batch.num_rows == 0) {
+                        continue;
+                    }
+
+                    for (size_t a = 0; a < num_aggs; a++) {
+                        if (!rg_needs[a]) {
+                            continue;
+                        }
+
+                        size_t value_pos = cols.value_positions[a];
+                        std::shared_ptr<const std::vector<std::string>> dict;
+                        if (value_pos != NO_COLUMN && batch.dictionary(value_pos) != nullptr) {
+                            dict = batch.dictionaries[value_pos];
+                        }
+
+                        if (!selectAggRows(batch, aggregations_[a].filters, cols.filter_positions[a], sel)) {
+                            local[a].count += batch.num_rows;
+                            if (value_pos != NO_COLUMN) {
+                                local[a].addColumn(batch.columns[value_pos], dict);
+                            }
+                            continue;
+                        }
+
+                        local[a].count += sel.size();
+                        if (value_pos != NO_COLUMN && !sel.empty()) {
+                            local[a].addColumn(gatherColumn(batch.columns[value_pos], sel), dict);
+                        }
+                    }
+                }
+            }
+
+            for (auto& acc : local) {
+                if (acc.distinct.has_value()) {
+                    acc.distinct->flush();
+                }
+            }
+        });
+
+        for (const auto& local : worker_accs) {
+            for (size_t a = 0; a < num_aggs; a++) {
+                accs[a].merge(local[a]);
+            }
+        }
+    }
+
+    std::vector<AggResult> results;
+    results.reserve(num_aggs);
+    for (size_t a = 0; a < num_aggs; a++) {
+        results.push_back(accs[a].result(aggregations_[a]));
+    }
+    return results;
+}
+
+// Group-by helpers
+namespace {
+
+// Integer key ranges up to this size are aggregated by direct array indexing
+constexpr uint64_t DIRECT_GROUP_MAX_RANGE = 1 << 16;
+
+// Min and max of an integer column across all row groups, when every row
+// group carries page stats
+std::optional<std::pair<int64_t, int64_t>> columnRange(const FileMetadata& metadata, size_t col_idx) {
+    std::optional<int64_t> min_key;
+    std::optional<int64_t> max_key;
+
+    for (const auto& rg : metadata.row_groups) {
+        if (rg.num_rows == 0) {
+            continue;
+        }
+        const auto& cc = rg.column_chunks[col_idx];
+        if (cc.page_headers.empty() ||
+            !cc.page_headers[0].stats.min_int.has_value() ||
+            !cc.page_headers[0].stats.max_int.has_value()) {
+            return std::nullopt;
+        }
+        int64_t rg_min = cc.page_headers[0].stats.min_int.value();
+        int64_t rg_max = cc.page_headers[0].stats.max_int.value();
+        min_key = min_key.has_value() ? std::min(min_key.value(), rg_min) : rg_min;
+        max_key = max_key.has_value() ? std::max(max_key.value(), rg_max) : rg_max;
+    }
+
+    if (!min_key.has_value()) {
+        return std::nullopt;
+    }
+    return std::make_pair(min_key.value(), max_key.value());
+}
+
+// Key range [min, min + range) of an integer column, when the range is
+// known and small enough for direct indexing
+std::optional<std::pair<int64_t, size_t>> smallKeyRange(const FileMetadata& metadata, size_t col_idx) {
+    auto range = columnRange(metadata, col_idx);
+    if (!range.has_value()) {
+        return std::nullopt;
+    }
+
+    uint64_t span = static_cast<uint64_t>(range->second) - static_cast<uint64_t>(range->first);
+    if (span >= DIRECT_GROUP_MAX_RANGE) {
+        return std::nullopt;
+    }
+    return std::make_pair(range->first, static_cast<size_t>(span + 1));
+}
+
+// Map a key column through a group table: strings through StringGroupTable,
+// integers (either width) through the integer tables
+template<typename Table, typename Vec>
+void mapGroupKeys(Table& table, const Vec& keys, std::vector<uint32_t>& group_ids) {
+    if constexpr (std::is_same_v<Table, StringGroupTable> != std::is_same_v<Vec, std::vector<std::string>>) {
+        throw std::runtime_error("Group key column type mismatch");
+    } else {
+        table.findOrInsert(keys, group_ids);
+    }
+}
+
+// Look integer or string keys up without inserting; absent keys map to NO_GROUP
+template<typename Table, typename Vec>
+void findGroupKeys(Table& table, const Vec& keys, std::vector<uint32_t>& group_ids) {
+    if constexpr (std::is_same_v<Table, StringGroupTable> != std::is_same_v<Vec, std::vector<std::string>>) {
+        throw std::runtime_error("Group key column type mismatch");
+    } else {
+        table.find(keys, group_ids);
+    }
+}
+
+// Per-group states of every aggregate of a query. rows counts the rows of
+// each group passing the query filters: a group exists when it has any,
+// even if the aggregates' own filters reject all of them.
+struct GroupAggregator {
+    const std::vector<AggSpec>* specs;
+    const AggColumns* cols;
+    std::vector<int64_t> rows;
+    std::vector<GroupAggStates> states;
+
+    GroupAggregator(const std::vector<AggSpec>& agg_specs, const AggColumns& agg_cols)
+        : specs(&agg_specs)
+        , cols(&agg_cols)
+        , states(agg_specs.size()) {
+        for (size_t a = 0; a < states.size(); a++) {
+            if (countsDistinct(agg_specs[a].func)) {
+                throw std::runtime_error("COUNT DISTINCT is not supported with GROUP BY");
+            }
+            states[a].moments = needsMoments(agg_specs[a].func);
+        }
+    }
+
+    void resize(size_t num_groups) {
+        rows.resize(num_groups, 0);
+        for (auto& s : states) {
+            s.resize(num_groups);
+        }
+    }
+
+    size_t memoryUsage() const {
+        size_t bytes = rows.capacity() * sizeof(int64_t);
+        for (const auto& s : states) {
+            bytes += s.memoryUsage();
+        }
+        return bytes;
+    }
+
+    // Group ids of one batch (dense table ids or dictionary codes)
+    template<typename Id>
+    void update(const Batch& batch, const std::vector<Id>& group_ids) {
+        for (Id g : group_ids) {
+            rows[static_cast<size_t>(g)]++;
+        }
+
+        for (size_t a = 0; a < specs->size(); a++) {
+            const std::vector<Id>* ids = &group_ids;
+            std::vector<Id> filtered_ids;
+            std::optional<Batch::ColumnData> gathered;
+
+            size_t value_pos = cols->value_positions[a];
+            bool has_values = (*specs)[a].func != AggFunc::COUNT &&
+                              batch.dictionary(value_pos) == nullptr;
+
+            if (selectAggRows(batch, (*specs)[a].filters, cols->filter_positions[a], sel_)) {
+                filtered_ids.reserve(sel_.size());
+                for (uint32_t row : sel_) {
+                    filtered_ids.push_back(group_ids[row]);
+                }
+                ids = &filtered_ids;
+                if (has_values) {
+                    gathered = gatherColumn(batch.columns[value_pos], sel_);
+                }
+            }
+
+            const Batch::ColumnData* values = nullptr;
+            if (has_values) {
+                values = gathered.has_value() ? &gathered.value() : &batch.columns[value_pos];
+            }
+
+            if (values != nullptr && !std::holds_alternative<std::vector<std::string>>(*values)) {
+                std::visit([&](const auto& vals) {
+                    using T = typename std::decay_t<decltype(vals)>::value_type;
+                    if constexpr (!std::is_same_v<T, std::string>) {
+                        if (states[a].moments) {
+                            states[a].updateMoments(*ids, vals);
+                        } else {
+                            states[a].update(*ids, vals);
+                        }
+                    }
+                }, *values);
+            } else {
+                states[a].updateCount(*ids);
+            }
+        }
+    }
+
+    // Fold each non-empty group g of partial into group remap[g]
+    void merge(const GroupAggregator& partial, const std::vector<uint32_t>& remap) {
+        for (size_t g = 0; g < partial.rows.size(); g++) {
+            if (partial.rows[g] > 0) {
+                rows[remap[g]] += partial.rows[g];
+            }
+        }
+        for (size_t a = 0; a < states.size(); a++) {
+            states[a].merge(partial.states[a], remap);
+        }
+    }
+
+    // Fold group src of partial into group dst
+    void mergeGroup(const GroupAggregator& partial, uint32_t src, uint32_t dst) {
+        rows[dst] += partial.rows[src];
+        for (size_t a = 0; a < states.size(); a++) {
+            states[a].mergeGroup(partial.states[a], src, dst);
+        }
+    }
+
+    std::vector<AggResult> results(uint32_t group_id) const {
+        std::vector<AggResult> out;
+        out.reserve(states.size());
+        for (size_t a = 0; a < states.size(); a++) {
+            const auto& spec = (*specs)[a];
+            if (spec.func == AggFunc::SUM && !states[a].sumFitsInt64(group_id)) {
+                throw std::runtime_error("SUM(" + spec.column + ") overflows int64");
+            }
+            out.push_back(states[a].result(group_id, spec.func));
+        }
+        return out;
+    }
+
+private:
+    std::vector<uint32_t> sel_;
+};
+
+// Keys (first batch column) are mapped to dense group ids a batch at a time
+template<typename Table>
+void aggregateGroups(Scanner& scanner, Table& table, GroupAggregator& aggregator) {
+    std::vector<uint32_t> group_ids;
+
+    while (scanner.hasNext()) {
+        Batch batch = scanner.next();
+        if (batch.num_rows == 0) {
+            continue;
+        }
+
+        std::visit([&](const auto& keys) { mapGroupKeys(table, keys, group_ids); }, batch.columns[0]);
+        aggregator.resize(table.size());
+        aggregator.update(batch, group_ids);
+    }
+}
+
+// String keys arriving as dictionary codes are aggregated into a dense
+// partial indexed by code, one per row group. When the row group ends, only
+// the codes that occurred are looked up in the global table, once each, and
+// the partial is merged through that remapping.
+void aggregateStringGroups(Scanner& scanner, StringGroupTable& table, GroupAggregator& aggregator) {
+    std::vector<uint32_t> group_ids;
+    const std::vector<std::string>* dictionary = nullptr;
+    GroupAggregator partial(*aggregator.specs, *aggregator.cols);
+
+    auto flushPartial = [&]() {
+        if (dictionary == nullptr) {
+            return;
+        }
+
+        std::vector<std::string> used_keys;
+        std::vector<uint32_t> used_codes;
+        for (uint32_t code = 0; code < partial.rows.size(); code++) {
+            if (partial.rows[code] > 0) {
+                used_keys.push_back((*dictionary)[code]);
+                used_codes.push_back(code);
+            }
+        }
+
+        table.findOrInsert(used_keys, group_ids);
+        aggregator.resize(table.size());
+
+        std::vector<uint32_t> remap(partial.rows.size(), 0);
+        for (size_t i = 0; i < used_codes.size(); i++) {
+            remap[used_codes[i]] = group_ids[i];
+        }
+        aggregator.merge(partial, remap);
+
+        dictionary = nullptr;
+    };
+
+    // Dictionaries are shared by every batch of a row group, so a new
+    // dictionary pointer marks the start of the next row group
+    std::shared_ptr<const std::vector<std::string>> current;
+
+    while (scanner.hasNext()) {
+        Batch batch = scanner.next();
+        if (batch.num_rows == 0) {
+            continue;
+        }
+
+        const std::vector<std::string>* batch_dict = batch.dictionary(0);
+        if (batch_dict == nullptr) {
+            flushPartial();
+            table.findOrInsert(batch.getColumn<std::string>(0), group_ids);
+            aggregator.resize(table.size());
+            aggregator.update(batch, group_ids);
+            continue;
+        }
+
+        if (batch_dict != dictionary) {
+            flushPartial();
+            current = batch.dictionaries[0];
+            dictionary = batch_dict;
+            partial = GroupAggregator(*aggregator.specs, *aggregator.cols);
+            partial.resize(dictionary->size());
+        }
+        partial.update(batch, batch.getColumn<int32_t>(0));
+    }
+
+    flushPartial();
+}
+
+// Non-empty integer groups (direct tables pre-allocate the whole key range)
+template<typename Table>
+void collectIntGroups(const Table& table, const GroupAggregator& aggregator,
+                      std::vector<std::pair<int64_t, std::vector<AggResult>>>& out) {
+    for (uint32_t g = 0; g < aggregator.rows.size(); g++) {
+        if (aggregator.rows[g] > 0) {
+            out.emplace_back(table.key(g), aggregator.results(g));
+        }
+    }
+}
+
+// Budgeted GROUP BY spills partitions of rows, chosen by SPILL_PARTITION_BITS
+// bits of the key hash (different bits at every recursion level)
+constexpr unsigned SPILL_PARTITION_BITS = 4;
+constexpr size_t SPILL_PARTITIONS = size_t{1} << SPILL_PARTITION_BITS;
+
+// Temporary directory of one budgeted GROUP BY or ORDER BY, created on
+// first use and removed with everything in it when the query ends
+class SpillDirectory {
+public:
+    explicit SpillDirectory(std::string parent)
+        : parent_(std::move(parent)) {}
+
+    ~SpillDirectory() {
+        if (!path_.empty()) {
+            std::error_code ec;
+            std::filesystem::remove_all(path_, ec);
+        }
+    }
+
+    SpillDirectory(const SpillDirectory&) = delete;
+    SpillDirectory& operator=(const SpillDirectory&) = delete;
+
+    std::string nextFile() {
+        if (path_.empty()) {
+            std::filesystem::path parent = parent_.empty() ? std::filesystem::temp_directory_path()
+                                                           : std::filesystem::path(parent_);
+            std::random_device random;
+            for (int attempt = 0; path_.empty(); attempt++) {
+                auto candidate = parent / ("columnar_spill_" + std::to_string(random()));
+                if (std::filesystem::create_directory(candidate)) {
+                    path_ = candidate;
+                } else if (attempt == 100) {
+                    throw std::runtime_error("Cannot create spill directory in " + parent.string());
+                }
+            }
+        }
+        return (path_ / ("partition_" + std::to_string(next_file_++) + ".col")).string();
+    }
+
+private:
+    std::string parent_;
+    std::filesystem::path path_;
+    size_t next_file_ = 0;
+};
+
+// Spilled rows of one partition, buffered and written a row group at a time
+// with the scan's columns, so the file is scanned back like the input
+struct SpillPartition {
+    std::string path;
+    std::unique_ptr<FileWriter> writer;
+    std::vector<Batch::ColumnData> buffered;
+    size_t buffered_rows = 0;
+
+    void append(const Batch& batch, const std::vector<uint32_t>& sel, SpillDirectory& dir) {
+        if (!writer) {
+            Schema schema;
+            for (size_t i = 0; i < batch.columns.size(); i++) {
+                ColumnType type = std::visit([](const auto& vals) {
+                    using T = typename std::decay_t<decltype(vals)>::value_type;
+                    if constexpr (std::is_same_v<T, int32_t>) {
+                        return ColumnType::INT32;
+                    } else if constexpr (std::is_same_v<T, int64_t>) {
+                        return ColumnType::INT64;
+                    } else {
+                        return ColumnType::STRING;
+                    }
+                }, batch.columns[i]);
+                schema.columns.push_back({batch.column_names[i], type, EncodingType::PLAIN});
+            }
+            path = dir.nextFile();
+            writer = std::make_unique<FileWriter>(path, schema);
+            writer->setSketchPrecision(0);  // Spill files are only scanned back
+            for (const auto& col : batch.columns) {
+                buffered.push_back(std::visit([](const auto& vals) -> Batch::ColumnData {
+                    return std::decay_t<decltype(vals)>{};
+                }, col));
+            }
+        }
+
+        for (size_t i = 0; i < batch.columns.size(); i++) {
+            std::visit([&](auto& out) {
+                const auto& vals = std::get<std::decay_t<decltype(out)>>(batch.columns[i]);
+                for (uint32_t row : sel) {
+                    out.push_back(vals[row]);
+                }
+            }, buffered[i]);
+        }
+        buffered_rows += sel.size();
+    }
+
+    void flush() {
+        if (buffered_rows == 0) {
+            return;
+        }
+        for (size_t i = 0; i < buffered.size(); i++) {
+            std::visit([&](auto& vals) {
+                using T = typename std::decay_t<decltype(vals)>::value_type;
+                if constexpr (std::is_same_v<T, int32_t>) {
+                    writer->writeInt32Column(i, vals);
+                } else if constexpr (std::is_same_v<T, int64_t>) {
+                    writer->writeInt64Column(i, vals);
+                } else {
+                    writer->writeStringColumn(i, vals);
+                }
+                vals.clear();
+            }, buffered[i]);
+        }
+        writer->flushRowGroup();
+        buffered_rows = 0;
+    }
+};
+
+// Single-column group table as aggregated under a memory budget: keys of
+// the batch's first column are inserted, looked up or hashed a batch at a
+// time
+template<typename Table>
+struct SingleKeyTable {
+    Table table;
+
+    void findOrInsert(const Batch& batch, std::vector<uint32_t>& group_ids) {
+        std::visit([&](const auto& keys) { mapGroupKeys(table, keys, group_ids); }, batch.columns[0]);
+    }
+
+    void find(const Batch& batch, std::vector<uint32_t>& group_ids) {
+        std::visit([&](const auto& keys) { findGroupKeys(table, keys, group_ids); }, batch.columns[0]);
+    }
+
+    void hash(const Batch& batch, std::vector<uint64_t>& hashes) {
+        std::visit([&](const auto& keys) { hashColumn(keys, hashes); }, batch.columns[0]);
+    }
+
+    auto key(uint32_t group_id) const { return table.key(group_id); }
+    size_t size() const { return table.size(); }
+    size_t memoryUsage() const { return table.memoryUsage(); }
+};
+
+// State shared by every level of a budgeted GROUP BY
+struct SpillContext {
+    const std::vector<AggSpec>& specs;
+    const AggColumns& cols;
+    const std::vector<std::string>& scan_columns;
+    size_t batch_size;
+    size_t budget;
+    SpillDirectory dir;
+    size_t spilled_rows = 0;
+};
+
+// Grace hash aggregation under a memory budget. Keys are inserted until the
+// table and aggregate states outgrow the budget; from then on rows of keys
+// already in the table are still aggregated in memory, while rows of new
+// keys are spilled, partitioned by key hash. Each spill file is then
+// aggregated the same way, one at a time, partitioning on the next hash bits
+// if it does not fit either. Every key is aggregated in exactly one table,
+// so results match an in-memory aggregation. Each level keeps at least the
+// keys of its first batch, so the recursion always terminates. Every level
+// starts from a copy of the empty table.
+template<typename Table, typename Key>
+void aggregateWithBudget(Scanner& scanner, SpillContext& ctx, unsigned depth, const Table& empty,
+                         std::vector<std::pair<Key, std::vector<AggResult>>>& out) {
+    auto table = std::make_unique<Table>(empty);
+    auto aggregator = std::make_unique<GroupAggregator>(ctx.specs, ctx.cols);
+
+    std::vector<SpillPartition> partitions(SPILL_PARTITIONS);
+    unsigned shift = 64 - SPILL_PARTITION_BITS * (depth % (64 / SPILL_PARTITION_BITS) + 1);
+
+    std::vector<uint32_t> group_ids;
+    std::vector<uint64_t> hashes;
+    std::vector<uint32_t> resident;
+    std::vector<uint32_t> resident_ids;
+    std::vector<std::vector<uint32_t>> spilled(SPILL_PARTITIONS);
+
+    while (scanner.hasNext()) {
+        Batch batch = scanner.next();
+        if (batch.num_rows == 0) {
+            continue;
+        }
+
+        bool over_budget = table->size() > 0 &&
+                           table->memoryUsage() + aggregator->memoryUsage() > ctx.budget;
+        if (!over_budget) {
+            table->findOrInsert(batch, group_ids);
+            aggregator->resize(table->size());
+            aggregator->update(batch, group_ids);
+            continue;
+        }
+
+        table->find(batch, group_ids);
+        table->hash(batch, hashes);
+
+        resident.clear();
+        resident_ids.clear();
+        for (auto& rows : spilled) {
+            rows.clear();
+        }
+        for (uint32_t row = 0; row < batch.num_rows; row++) {
+            if (group_ids[row] != NO_GROUP) {
+                resident.push_back(row);
+                resident_ids.push_back(group_ids[row]);
+            } else {
+                spilled[(hashes[row] >> shift) & (SPILL_PARTITIONS - 1)].push_back(row);
+            }
+        }
+
+        if (!resident.empty()) {
+            Batch kept;
+            kept.column_names = batch.column_names;
+            kept.num_rows = resident.size();
+            for (const auto& col : batch.columns) {
+                kept.columns.push_back(gatherColumn(col, resident));
+            }
+            aggregator->update(kept, resident_ids);
+        }
+
+        for (size_t p = 0; p < SPILL_PARTITIONS; p++) {
+            if (spilled[p].empty()) {
+                continue;
+            }
+            partitions[p].append(batch, spilled[p], ctx.dir);
+            ctx.spilled_rows += spilled[p].size();
+            if (partitions[p].buffered_rows >= ctx.batch_size) {
+                partitions[p].flush();
+            }
+        }
+    }
+
+    // Every group in the table is final: emit it and free the table before
+    // the spilled partitions are aggregated
+    for (uint32_t g = 0; g < table->size(); g++) {
+        out.emplace_back(Key(table->key(g)), aggregator->results(g));
+    }
+    table.reset();
+    aggregator.reset();
+
+    for (auto& partition : partitions) {
+        if (!partition.writer) {
+            continue;
+        }
+        partition.flush();
+        partition.writer->close();
+        partition.writer.reset();
+
+        {
+            auto reader = std::make_shared<FileReader>(partition.path);
+            Scanner spill_scanner(reader, ctx.scan_columns, ctx.batch_size);
+            aggregateWithBudget(spill_scanner, ctx, depth + 1, empty, out);
+        }
+        std::filesystem::remove(partition.path);
+    }
+}
+
+// Thread-local GROUP BY state of one worker
+template<typename Table>
+struct GroupPartial {
+    Table table;
+    GroupAggregator aggregator;
+};
+
+// Groups merged in parallel are radix-partitioned on the top bits of their
+// key hash; below the group count threshold partials are merged on one
+// thread without partitioning
+constexpr unsigned MERGE_PARTITION_BITS = 5;
+constexpr size_t PARTITIONED_MERGE_MIN_GROUPS = 1 << 14;
+
+inline uint64_t groupKeyHash(std::string_view key) {
+    return hashBytes(key.data(), key.size());
+}
+
+inline uint64_t groupKeyHash(int64_t key) {
+    return hashInt64(static_cast<uint64_t>(key));
+}
+
+// Merge the workers' partial tables (StringGroupTable or IntGroupTable):
+// each worker's groups are split into partitions by key hash, then every
+// partition is merged independently, so no two threads share a table
+template<typename Table, typename Key>
+std::vector<std::pair<Key, std::vector<AggResult>>> mergeGroupPartials(std::vector<GroupPartial<Table>>& partials,
+                                                                       size_t num_threads) {
+    std::vector<std::pair<Key, std::vector<AggResult>>> out;
+
+    if (partials.size() == 1) {
+        const auto& only = partials.front();
+        out.reserve(only.table.size());
+        for (uint32_t g = 0; g < only.table.size(); g++) {
+            out.emplace_back(Key(only.table.key(g)), only.aggregator.results(g));
+        }
+        return out;
+    }
+
+    size_t total_groups = 0;
+    for (const auto& partial : partials) {
+        total_groups += partial.table.size();
+    }
+    size_t num_partitions = total_groups >= PARTITIONED_MERGE_MIN_GROUPS ? size_t{1} << MERGE_PARTITION_BITS : 1;
+
+    // parts[w][p]: groups of worker w falling in partition p
+    std::vector<std::vector<std::vector<uint32_t>>> parts(
+        partials.size(), std::vector<std::vector<uint32_t>>(num_partitions));
+
+    auto partitionWorker = [&](size_t w) {
+        const auto& table = partials[w].table;
+        for (uint32_t g = 0; g < table.size(); g++) {
+            size_t p = num_partitions > 1 ? groupKeyHash(table.key(g)) >> (64 - MERGE_PARTITION_BITS) : 0;
+            parts[w][p].push_back(g);
+        }
+    };
+
+    if (num_partitions > 1) {
+        runWorkers(partials.size(), partitionWorker);
+    } else {
+        for (size_t w = 0; w < partials.size(); w++) {
+            partitionWorker(w);
+        }
+    }
+
+    std::vector<std::vector<std::pair<Key, std::vector<AggResult>>>> merged(num_partitions);
+    std::atomic<size_t> next_partition{0};
+
+    runWorkers(std::min(num_threads, num_partitions), [&](size_t) {
+        std::vector<Key> keys;
+        std::vector<uint32_t> ids;
+
+        for (size_t p = next_partition++; p < num_partitions; p = next_partition++) {
+            Table table;
+            GroupAggregator aggregator(*partials.front().aggregator.specs, *partials.front().aggregator.cols);
+
+            for (size_t w = 0; w < partials.size(); w++) {
+                const auto& groups = parts[w][p];
+                keys.clear();
+                for (uint32_t g : groups) {
+                    keys.emplace_back(partials[w].table.key(g));
+                }
+
+                table.findOrInsert(keys, ids);
+                aggregator.resize(table.size());
+                for (size_t i = 0; i < groups.size(); i++) {
+                    aggregator.mergeGroup(partials[w].aggregator, groups[i], ids[i]);
+                }
+            }
+
+            merged[p].reserve(table.size());
+            for (uint32_t g = 0; g < table.size(); g++) {
+                merged[p].emplace_back(Key(table.key(g)), aggregator.results(g));
+            }
+        }
+    });
+
+    out.reserve(total_groups);
+    for (auto& partition : merged) {
+        std::move(partition.begin(), partition.end(), std::back_inserter(out));
+    }
+    return out;
+}
+
+// Composite keys are bit-packed into at most this many words; keys needing
+// more fall back to one word per column
+constexpr size_t MAX_PACKED_KEY_WORDS = 2;
+
+using KeyValue = std::variant<int64_t, std::string>;
+
+// Normalizes one column of a composite key to an unsigned integer of at most
+// bits bits: integers as offsets from the column minimum, strings as ids in
+// a per-column string table. Each row group's dictionary is remapped to ids
+// once, so dictionary-coded rows cost an array lookup.
+struct KeyColumnEncoder {
+    bool is_string = false;
+    int64_t min_key = std::numeric_limits<int64_t>::min();
+    unsigned bits = 64;
+    size_t word = 0;   // Position within the packed key
+    unsigned shift = 0;
+
+    StringGroupTable strings;
+    std::shared_ptr<const std::vector<std::string>> dictionary;
+    std::vector<uint32_t> remap;
+    std::vector<uint32_t> ids;
+
+    void encode(const Batch& batch, size_t pos, std::vector<uint64_t>& out) {
+        out.resize(batch.num_rows);
+        const auto& col = batch.columns[pos];
+
+        if (batch.dictionary(pos) != nullptr) {
+            if (batch.dictionaries[pos] != dictionary) {
+                dictionary = batch.dictionaries[pos];
+                strings.findOrInsert(*dictionary, remap);
+            }
+            const auto& codes = std::get<std::vector<int32_t>>(col);
+            for (size_t row = 0; row < codes.size(); row++) {
+                out[row] = remap[static_cast<size_t>(codes[row])];
+            }
+        } else if (std::holds_alternative<std::vector<std::string>>(col)) {
+            strings.findOrInsert(std::get<std::vector<std::string>>(col), ids);
+            std::copy(ids.begin(), ids.end(), out.begin());
+        } else {
+            std::visit([&](const auto& vals) {
+                using T = typename std::decay_t<decltype(vals)>::value_type;
+                if constexpr (!std::is_same_v<T, std::string>) {
+                    for (size_t row = 0; row < vals.size(); row++) {
+                        out[row] = static_cast<uint64_t>(static_cast<int64_t>(vals[row])) -
+                                   static_cast<uint64_t>(min_key);
+                    }
+                }
+            }, col);
+        }
+
+        uint64_t all_bits = 0;
+        for (uint64_t v : out) {
+            all_bits |= v;
+        }
+        if (bits < 64 && (all_bits >> bits) != 0) {
+            throw std::runtime_error("Group key outside its page statistics range");
+        }
+    }
+
+    // As encode, but strings not yet in the string table are not added:
+    // their rows are flagged in missing instead
+    void lookup(const Batch& batch, size_t pos, std::vector<uint64_t>& out, std::vector<uint8_t>& missing) {
+        const auto& col = batch.columns[pos];
+        if (batch.dictionary(pos) != nullptr || !std::holds_alternative<std::vector<std::string>>(col)) {
+            encode(batch, pos, out);
+            return;
+        }
+
+        strings.find(std::get<std::vector<std::string>>(col), ids);
+        out.resize(batch.num_rows);
+        for (size_t row = 0; row < ids.size(); row++) {
+            bool absent = ids[row] == NO_GROUP;
+            missing[row] |= absent ? 1 : 0;
+            out[row] = absent ? 0 : ids[row];
+        }
+    }
+
+    uint64_t extract(const uint64_t* key_words) const {
+        if (bits == 0) {
+            return 0;
+        }
+        uint64_t mask = bits == 64 ? ~uint64_t{0} : (uint64_t{1} << bits) - 1;
+        return (key_words[word] >> shift) & mask;
+    }
+
+    KeyValue decode(uint64_t normalized) const {
+        if (is_string) {
+            return std::string(strings.key(static_cast<uint32_t>(normalized)));
+        }
+        return static_cast<int64_t>(static_cast<uint64_t>(min_key) + normalized);
+    }
+};
+
+// Assign every key column its bit width and position. Returns the number of
+// words per key.
+size_t layoutCompositeKey(std::vector<KeyColumnEncoder>& encoders) {
+    size_t word = 0;
+    unsigned used = 0;
+    for (auto& enc : encoders) {
+        if (enc.bits == 0) {
+            continue;
+        }
+        if (used + enc.bits > 64) {
+            word++;
+            used = 0;
+        }
+        enc.word = word;
+        enc.shift = used;
+        used += enc.bits;
+    }
+
+    if (word + 1 <= MAX_PACKED_KEY_WORDS) {
+        return word + 1;
+    }
+
+    for (size_t i = 0; i < encoders.size(); i++) {
+        encoders[i].word = i;
+        encoders[i].shift = 0;
+    }
+    return encoders.size();
+}
+
+// Group table over composite keys: every key column is normalized by its
+// encoder and packed into the table's key words
+class CompositeKeyTable {
+public:
+    CompositeKeyTable(std::vector<KeyColumnEncoder> encoders, size_t words)
+        : encoders_(std::move(encoders))
+        , table_(words) {}
+
+    void findOrInsert(const Batch& batch, std::vector<uint32_t>& group_ids) {
+        pack(batch, true);
+        table_.findOrInsert(packed_, batch.num_rows, group_ids);
+    }
+
+    // Rows holding a string the table has never seen have a new key, and
+    // map to NO_GROUP without the string being added
+    void find(const Batch& batch, std::vector<uint32_t>& group_ids) {
+        pack(batch, false);
+        table_.find(packed_, batch.num_rows, group_ids);
+        for (size_t row = 0; row < batch.num_rows; row++) {
+            if (missing_[row] != 0) {
+                group_ids[row] = NO_GROUP;
+            }
+        }
+    }
+
+    // Hash of the key column values, which unlike the key words does not
+    // depend on the string ids this table happened to assign
+    void hash(const Batch& batch, std::vector<uint64_t>& hashes) {
+        hashes.assign(batch.num_rows, 0);
+        for (size_t k = 0; k < encoders_.size(); k++) {
+            std::visit([&](const auto& vals) { hashColumn(vals, column_hashes_); }, batch.columns[k]);
+            for (size_t row = 0; row < batch.num_rows; row++) {
+                hashes[row] = hashInt64(hashes[row] ^ column_hashes_[row]);
+            }
+        }
+    }
+
+    std::vector<KeyValue> key(uint32_t group_id) const {
+        std::vector<KeyValue> key;
+        key.reserve(encoders_.size());
+        for (const auto& enc : encoders_) {
+            key.push_back(enc.decode(enc.extract(table_.key(group_id))));
+        }
+        return key;
+    }
+
+    size_t size() const { return table_.size(); }
+
+    size_t memoryUsage() const {
+        size_t bytes = table_.memoryUsage();
+        for (const auto& enc : encoders_) {
+            bytes += enc.strings.memoryUsage();
+        }
+        return bytes;
+    }
+
+private:
+    // Key words of every row of the batch; without insert, unseen strings
+    // flag their rows in missing_
+    void pack(const Batch& batch, bool insert) {
+        size_t words = table_.wordsPerKey();
+        packed_.assign(batch.num_rows * words, 0);
+        missing_.assign(batch.num_rows, 0);
+        for (size_t k = 0; k < encoders_.size(); k++) {
+            auto& enc = encoders_[k];
+            if (insert) {
+                enc.encode(batch, k, normalized_);
+            } else {
+                enc.lookup(batch, k, normalized_, missing_);
+            }
+            if (enc.bits == 0) {
+                continue;
+            }
+            for (size_t row = 0; row < batch.num_rows; row++) {
+                packed_[row * words + enc.word] |= normalized_[row] << enc.shift;
+            }
+        }
+    }
+
+    std::vector<KeyColumnEncoder> encoders_;
+    PackedGroupTable table_;
+    std::vector<uint64_t> packed_;
+    std::vector<uint64_t> normalized_;
+    std::vector<uint8_t> missing_;
+    std::vector<uint64_t> column_hashes_;
+};
+
+} // namespace
+
+std::vector<std::pair<std::string, AggResult>> QueryExecutor::executeGroupBy() {
+    std::vector<std::pair<std::string, AggResult>> results;
+    for (auto& group : executeGroupByAggregates()) {
+        std::string key;
+        for (size_t i = 0; i < group.keys.size(); i++) {
+            key += (i > 0 ? "|" : "") + group.keys[i];
+        }
+        results.emplace_back(std::move(key), group.aggs.front());
+    }
+    return results;
+}
+
+std::vector<GroupResult> QueryExecutor::executeGroupByAggregates() {
+    if (group_by_columns_.empty()) {
+        throw std::runtime_error("No GROUP BY column specified");
+    }
+
+    if (aggregations_.empty()) {
+        throw std::runtime_error("No aggregation specified for GROUP BY");
+    }
+
+    spilled_rows_ = 0;
+    if (group_by_columns_.size() > 1) {
+        return executeCompositeGroupBy();
+    }
+
+    const auto& group_col = group_by_columns_.front();
+    size_t key_col_idx = reader_->schema().columnIndex(group_col);
+    bool string_keys = reader_->schema().columns[key_col_idx].type == ColumnType::STRING;
+
+    // Group column first, then every aggregate's value and filter columns:
+    // one scan and one key lookup per row serve all aggregates
+    std::vector<std::string> scan_columns{group_col};
+    AggColumns cols = planAggColumns(aggregations_, scan_columns);
+
+    // Workers claim row groups one at a time and aggregate them into their
+    // own partial table; partials are merged at the end
+    size_t num_row_groups = reader_->metadata().row_groups.size();
+    size_t num_workers = workerCount(num_row_groups);
+
+    auto scanPartials = [&](auto& partials, auto&& aggregate) {
+        std::atomic<size_t> next_rg{0};
+        runWorkers(partials.size(), [&](size_t w) {
+            Scanner scanner(reader_, scan_columns, batch_size_);
+            for (const auto& filter : filters_) {
+                scanner.addFilter(filter);
+            }
+            if (string_keys) {
+                scanner.setDictionaryCodes(group_col);
+            }
+
+            for (size_t rg = next_rg++; rg < num_row_groups; rg = next_rg++) {
+                scanner.setRowGroups({rg});
+                aggregate(scanner, partials[w]);
+            }
+        });
+    };
+
+    std::vector<std::pair<std::string, std::vector<AggResult>>> string_results;
+    std::vector<std::pair<int64_t, std::vector<AggResult>>> int_results;
+    std::optional<std::pair<int64_t, size_t>> key_range;
+    if (!string_keys) {
+        key_range = smallKeyRange(reader_->metadata(), key_col_idx);
+    }
+
+    if (memory_budget_ > 0 && !key_range.has_value()) {
+        // Hashed keys under a memory budget: one thread, spilling to disk
+        // once the table outgrows the budget. Keys are read as values rather
+        // than dictionary codes, so spilled rows need no dictionary.
+        Scanner scanner(reader_, scan_columns, batch_size_);
+        for (const auto& filter : filters_) {
+            scanner.addFilter(filter);
+        }
+        SpillContext ctx{aggregations_, cols, scan_columns, batch_size_, memory_budget_,
+                         SpillDirectory(spill_directory_)};
+
+        if (string_keys) {
+            aggregateWithBudget(scanner, ctx, 0, SingleKeyTable<StringGroupTable>{}, string_results);
+        } else {
+            aggregateWithBudget(scanner, ctx, 0, SingleKeyTable<IntGroupTable>{}, int_results);
+        }
+        spilled_rows_ = ctx.spilled_rows;
+    } else if (string_keys) {
+        std::vector<GroupPartial<StringGroupTable>> partials;
+        for (size_t w = 0; w < num_workers; w++) {
+            partials.push_back({StringGroupTable{}, GroupAggregator(aggregations_, cols)});
+        }
+        scanPartials(partials, [](Scanner& scanner, auto& partial) {
+            aggregateStringGroups(scanner, partial.table, partial.aggregator);
+        });
+        string_results = mergeGroupPartials<StringGroupTable, std::string>(partials, num_workers);
+    } else if (key_range.has_value()) {
+        // Integer keys with a small range (from page stats) index the state
+        // arrays directly. Partials share one key layout and are merged
+        // array against array.
+        std::vector<GroupPartial<DirectGroupTable>> partials;
+        for (size_t w = 0; w < num_workers; w++) {
+            partials.push_back({DirectGroupTable(key_range->first, key_range->second),
+                                GroupAggregator(aggregations_, cols)});
+            partials.back().aggregator.resize(key_range->second);
+        }
+        scanPartials(partials, [](Scanner& scanner, auto& partial) {
+            aggregateGroups(scanner, partial.table, partial.aggregator);
+        });
+
+        std::vector<uint32_t> identity(key_range->second);
+        for (size_t g = 0; g < identity.size(); g++) {
+            identity[g] = static_cast<uint32_t>(g);
+        }
+        for (size_t w = 1; w < partials.size(); w++) {
+            partials[0].aggregator.merge(partials[w].aggregator, identity);
+        }
+        collectIntGroups(partials[0].table, partials[0].aggregator, int_results);
+    } else {
+        // Wider integer key ranges go through the integer hash table
+        std::vector<GroupPartial<IntGroupTable>> partials;
+        for (size_t w = 0; w < num_workers; w++) {
+            partials.push_back({IntGroupTable{}, GroupAggregator(aggregations_, cols)});
+        }
+        scanPartials(partials, [](Scanner& scanner, auto& partial) {
+            aggregateGroups(scanner, partial.table, partial.aggregator);
+        });
+        int_results = mergeGroupPartials<IntGroupTable, int64_t>(partials, num_workers);
+    }
+
+    std::vector<GroupResult> results;
+    if (string_keys) {
+        std::sort(string_results.begin(), string_results.end(),
+                  [](const auto& a, const auto& b) { return a.first < b.first; });
+        results.reserve(string_results.size());
+        for (auto& [key, aggs] : string_results) {
+            results.push_back(GroupResult{{std::move(key)}, std::move(aggs)});
+        }
+        return results;
+    }
+
+    std::sort(int_results.begin(), int_results.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    results.reserve(int_results.size());
+    for (auto& [key, aggs] : int_results) {
+        results.push_back(GroupResult{{std::to_string(key)}, std::move(aggs)});
+    }
+    return results;
+}
+
+std::vector<GroupResult> QueryExecutor::executeCompositeGroupBy() {
+    const auto& schema = reader_->schema();
+    const auto& metadata = reader_->metadata();
+    size_t num_keys = group_by_columns_.size();
+
+    std::vector<std::string> scan_columns;
+    for (const auto& col : group_by_columns_) {
+        if (std::find(scan_columns.begin(), scan_columns.end(), col) != scan_columns.end()) {
+            throw std::runtime_error("Duplicate GROUP BY column: " + col);
+        }
+        scan_columns.push_back(col);
+    }
+    AggColumns cols = planAggColumns(aggregations_, scan_columns);
+
+    Scanner scanner(reader_, scan_columns, batch_size_);
+    for (const auto& filter : filters_) {
+        scanner.addFilter(filter);
+    }
+
+    // Integer columns take the bits their stats range needs (64 without
+    // stats). String ids are bounded by the row count, so they take that
+    // many bits.
+    unsigned string_bits = static_cast<unsigned>(std::bit_width(std::max<uint32_t>(metadata.total_rows, 1)));
+    std::vector<KeyColumnEncoder> encoders(num_keys);
+
+    for (size_t k = 0; k < num_keys; k++) {
+        size_t col_idx = schema.columnIndex(group_by_columns_[k]);
+        auto& enc = encoders[k];
+
+        if (schema.columns[col_idx].type == ColumnType::STRING) {
+            if (memory_budget_ == 0) {
+                scanner.setDictionaryCodes(group_by_columns_[k]);
+            }
+            enc.is_string = true;
+            enc.bits = string_bits;
+            continue;
+        }
+
+        auto range = columnRange(metadata, col_idx);
+        if (range.has_value()) {
+            enc.min_key = range->first;
+            enc.bits = static_cast<unsigned>(std::bit_width(
+                static_cast<uint64_t>(range->second) - static_cast<uint64_t>(range->first)));
+        }
+    }
+
+    size_t words = layoutCompositeKey(encoders);
+    std::vector<std::pair<std::vector<KeyValue>, std::vector<AggResult>>> groups;
+
+    if (memory_budget_ > 0) {
+        // Under a memory budget, spill like single-column keys. String keys
+        // are read as values rather than dictionary codes, so spilled rows
+        // need no dictionary.
+        SpillContext ctx{aggregations_, cols, scan_columns, batch_size_, memory_budget_,
+                         SpillDirectory(spill_directory_)};
+        aggregateWithBudget(scanner, ctx, 0, CompositeKeyTable(encoders, words), groups);
+        spilled_rows_ = ctx.spilled_rows;
+    } else {
+        CompositeKeyTable table(encoders, words);
+        GroupAggregator aggregator(aggregations_, cols);
+        std::vector<uint32_t> group_ids;
+
+        while (scanner.hasNext()) {
+            Batch batch = scanner.next();
+            if (batch.num_rows == 0) {
+                continue;
+            }
+            table.findOrInsert(batch, group_ids);
+            aggregator.resize(table.size());
+            aggregator.update(batch, group_ids);
+        }
+
+        groups.reserve(table.size());
+        for (uint32_t g = 0; g < table.size(); g++) {
+            groups.emplace_back(table.key(g), aggregator.results(g));
+        }
+    }
+
+    // Order groups by their typed key values
+    std::sort(groups.begin(), groups.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    std::vector<GroupResult> results;
+    results.reserve(groups.size());
+    for (auto& [key, aggs] : groups) {
+        GroupResult group;
+        for (const auto& value : key) {
+            group.keys.push_back(std::holds_alternative<int64_t>(value) ?
+                std::to_string(std::get<int64_t>(value)) : std::get<std::string>(value));
+        }
+        group.aggs = std::move(aggs);
+        results.push_back(std::move(group));
+    }
+    return results;
+}
+
+// External sort
+namespace {
+
+// Rows per row group of a spilled sorted run, the unit it is read back in
+constexpr size_t SORT_RUN_ROW_GROUP_ROWS = 65536;
+
+size_t columnMemory(const Batch::ColumnData& col) {
+    return std::visit([](const auto& vals) {
+        using T = typename std::decay_t<decltype(vals)>::value_type;
+        size_t bytes = vals.size() * sizeof(T);
+        if constexpr (std::is_same_v<T, std::string>) {
+            for (const auto& val : vals) {
+                bytes += val.size();
+            }
+        }
+        return bytes;
+    }, col);
+}
+
+// Rows of one run, gathered from scan batches in file order
+struct SortRun {
+    std::vector<Batch::ColumnData> columns;
+    std::vector<std::string> column_names;
+    size_t num_rows = 0;
+    size_t memory = 0;
+
+    void append(Batch&& batch) {
+        for (const auto& col : batch.columns) {
+            memory += columnMemory(col);
+        }
+        // Per row, sortRun adds a normalized key, an order index and radix scratch
+        memory += batch.num_rows * (sizeof(uint64_t) + 2 * sizeof(uint32_t));
+        if (columns.empty()) {
+            columns = std::move(batch.columns);
+            column_names = std::move(batch.column_names);
+        } else {
+            for (size_t i = 0; i < columns.size(); i++) {
+                std::visit([&](auto& out) {
+                    auto& vals = std::get<std::decay_t<decltype(out)>>(batch.columns[i]);
+                    std::move(vals.begin(), vals.end(), std::back_inserter(out));
+                }, columns[i]);
+            }
+        }
+        num_rows += batch.num_rows;
+    }
+};
+
+void normalizeKeys(const Batch::ColumnData& col, bool descending, std::vector<uint64_t>& keys) {
+    std::visit([&](const auto& vals) {
+        using T = typename std::decay_t<decltype(vals)>::value_type;
+        keys.resize(vals.size());
+        for (size_t i = 0; i < vals.size(); i++) {
+            if constexpr (std::is_same_v<T, std::string>) {
+                keys[i] = normalizeKey(std::string_view(vals[i]), descending);
+            } else {
+                keys[i] = normalizeKey(static_cast<int64_t>(vals[i]), descending);
+            }
+        }
+    }, col);
+}
+
+// Sort a run by its key column: radix sort on the normalized keys, then,
+// for string keys, a stable sort of each range of equal 8-byte prefixes
+// whose strings differ. Both sorts are stable, so ties keep file order.
+Batch sortRun(SortRun& run, size_t key_pos, bool descending) {
+    std::vector<uint64_t> keys;
+    normalizeKeys(run.columns[key_pos], descending, keys);
+    std::vector<uint32_t> order;
+    radixSortRows(keys, order);
+
+    if (const auto* strings = std::get_if<std::vector<std::string>>(&run.columns[key_pos])) {
+        const auto& vals = *strings;
+        for (size_t begin = 0; begin < order.size();) {
+            size_t end = begin + 1;
+            bool differ = false;
+            while (end < order.size() && keys[order[end]] == keys[order[begin]]) {
+                differ = differ || vals[order[end]] != vals[order[begin]];
+                end++;
+            }
+            if (differ) {
+                std::stable_sort(order.begin() + begin, order.begin() + end, [&](uint32_t a, uint32_t b) {
+                    return descending ? vals[b] < vals[a] : vals[a] < vals[b];
+                });
+            }
+            begin = end;
+        }
+    }
+
+    Batch sorted;
+    sorted.column_names = std::move(run.column_names);
+    sorted.num_rows = run.num_rows;
+    for (const auto& col : run.columns) {
+        sorted.columns.push_back(gatherColumn(col, order));
+    }
+    run = SortRun{};
+    return sorted;
+}
+
+// Read position in one sorted run: the last run stays in memory, earlier
+// ones are scanned back from their spill file a row group at a time
+struct RunCursor {
+    std::unique_ptr<Scanner> scanner;  // Null for the in-memory run
+    Batch batch{};
+    std::vector<uint64_t> keys;
+    size_t row = 0;
+    bool done = false;
+
+    void load(Batch next, size_t key_pos, bool descending) {
+        batch = std::move(next);
+        normalizeKeys(batch.columns[key_pos], descending, keys);
+        row = 0;
+        done = batch.num_rows == 0;
+    }
+
+    void advance(size_t key_pos, bool descending) {
+        if (++row < batch.num_rows) {
+            return;
+        }
+        done = true;
+        while (scanner && scanner->hasNext()) {
+            Batch next = scanner->next();
+            if (next.num_rows > 0) {
+                load(std::move(next), key_pos, descending);
+                return;
+            }
+        }
+    }
+};
+
+// Merge order of the runs' current rows; equal keys go to the earlier run,
+// which holds the rows earlier in the file
+struct RunBefore {
+    const std::vector<RunCursor>* cursors;
+    size_t key_pos;
+    bool string_key;
+    bool descending;
+
+    bool operator()(size_t a, size_t b) const {
+        const auto& ca = (*cursors)[a];
+        const auto& cb = (*cursors)[b];
+        if (ca.done || cb.done) {
+            return !ca.done;
+        }
+        uint64_t ka = ca.keys[ca.row];
+        uint64_t kb = cb.keys[cb.row];
+        if (ka != kb) {
+            return ka < kb;
+        }
+        if (string_key) {
+            const auto& sa = ca.batch.getColumn<std::string>(key_pos)[ca.row];
+            const auto& sb = cb.batch.getColumn<std::string>(key_pos)[cb.row];
+            if (sa != sb) {
+                return descending ? sb < sa : sa < sb;
+            }
+        }
+        return a < b;
+    }
+};
+
+// Merge phase of the external sort: rows are pulled from the runs through
+// a loser tree into batches of batch_size rows. Only the first
+// num_output_columns columns are returned (the key may be scan-only).
+class ExternalSortSource : public BatchSource {
+public:
+    ExternalSortSource(std::unique_ptr<SpillDirectory> dir, std::vector<RunCursor> cursors,
+                       RunBefore before, size_t batch_size, size_t num_output_columns)
+        : dir_(std::move(dir))
+        , cursors_(std::move(cursors))
+        , before_(before)
+        , batch_size_(std::max<size_t>(batch_size, 1))
+        , num_output_columns_(num_output_columns) {
+        before_.cursors = &cursors_;
+        tree_.emplace(cursors_.size(), before_);
+    }
+
+    bool hasNext() override {
+        return !cursors_.empty() && !cursors_[tree_->winner()].done;
+    }
+
+    Batch next() override {
+        if (!hasNext()) {
+            throw std::runtime_error("No more batches");
+        }
+
+        const Batch& first = cursors_[tree_->winner()].batch;
+        Batch out;
+        out.column_names.assign(first.column_names.begin(), first.column_names.begin() + num_output_columns_);
+        for (size_t i = 0; i < num_output_columns_; i++) {
+            out.columns.push_back(std::visit([](const auto& vals) -> Batch::ColumnData {
+                return std::decay_t<decltype(vals)>{};
+            }, first.columns[i]));
+        }
+
+        size_t rows = 0;
+        while (rows < batch_size_ && hasNext()) {
+            auto& cursor = cursors_[tree_->winner()];
+            for (size_t i = 0; i < num_output_columns_; i++) {
+                std::visit([&](auto& dst) {
+                    dst.push_back(std::get<std::decay_t<decltype(dst)>>(cursor.batch.columns[i])[cursor.row]);
+                }, out.columns[i]);
+            }
+            rows++;
+            cursor.advance(before_.key_pos, before_.descending);
+            tree_->replay();
+        }
+        out.num_rows = rows;
+        return out;
+    }
+
+private:
+    std::unique_ptr<SpillDirectory> dir_;  // Declared first: outlives the run readers
+    std::vector<RunCursor> cursors_;
+    RunBefore before_;
+    std::optional<LoserTree<RunBefore>> tree_;
+    size_t batch_size_;
+    size_t num_output_columns_;
+};
+
+} // namespace
+
+std::unique_ptr<BatchSource> QueryExecutor::executeSort(std::vector<std::string> scan_columns) {
+    size_t key_col_idx = reader_->schema().columnIndex(order_by_);
+    size_t num_output_columns = scan_columns.size();
+
+    // The key column is scanned even when not projected, then dropped
+    auto key_it = std::find(scan_columns.begin(), scan_columns.end(), order_by_);
+    size_t key_pos = static_cast<size_t>(key_it - scan_columns.begin());
+    if (key_it == scan_columns.end()) {
+        scan_columns.push_back(order_by_);
+    }
+
+    RunBefore before{nullptr, key_pos, reader_->schema().columns[key_col_idx].type == ColumnType::STRING,
+                     order_descending_};
+    auto dir = std::make_unique<SpillDirectory>(spill_directory_);
+    std::vector<RunCursor> cursors;
+    spilled_rows_ = 0;
+
+    // A run is sorted into a copy of itself, so runs are cut at half the
+    // budget; every run but the last is written out in sorted order
+    auto finishRun = [&](SortRun& run, bool last) {
+        if (run.num_rows == 0) {
+            return;
+        }
+        Batch sorted = sortRun(run, key_pos, order_descending_);
+
+        RunCursor cursor;
+        if (!last) {
+            SpillPartition file;
+            std::vector<uint32_t> sel;
+            for (size_t begin = 0; begin < sorted.num_rows; begin += SORT_RUN_ROW_GROUP_ROWS) {
+                size_t end = std::min(begin + SORT_RUN_ROW_GROUP_ROWS, sorted.num_rows);
+                sel.resize(end - begin);
+                for (size_t i = 0; i < sel.size(); i++) {
+                    sel[i] = static_cast<uint32_t>(begin + i);
+                }
+                file.append(sorted, sel, *dir);
+                file.flush();
+            }
+            file.writer->close();
+            spilled_rows_ += sorted.num_rows;
+
+            sorted = Batch{};
+            cursor.scanner = std::make_unique<Scanner>(std::make_shared<FileReader>(file.path),
+                                                       scan_columns, batch_size_);
+            cursor.done = true;
+            cursor.advance(key_pos, order_descending_);
+        } else {
+            cursor.load(std::move(sorted), key_pos, order_descending_);
+        }
+        cursors.push_back(std::move(cursor));
+    };
+
+    Scanner scanner(reader_, scan_columns, batch_size_);
+    for (const auto& filter : filters_) {
+        scanner.addFilter(filter);
+    }
+
+    SortRun run;
+    while (scanner.hasNext()) {
+        Batch batch = scanner.next();
+        if (batch.num_rows == 0) {
+            continue;
+        }
+        run.append(std::move(batch));
+
+        bool over_budget = memory_budget_ > 0 && run.memory > memory_budget_ / 2;
+        if (over_budget || run.num_rows >= std::numeric_limits<uint32_t>::max() - batch_size_) {
+            finishRun(run, false);
+        }
+    }
+    finishRun(run, true);
+
+    return std::make_unique<ExternalSortSource>(std::move(dir), std::move(cursors), before, batch_size_,
+                                                num_output_columns);
 }
 
 } // namespace columnar
@@ -4,12 +4,16 @@
 
 #include "format.h"
 #include "encoding.h"
+#include "aggregation.h"
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <stdexcept>
 #include <cstring>
 #include <algorithm>
+#include <cmath>
 #include <limits>
+#include <mutex>
 
 namespace columnar {
 
@@ -126,6 +130,79 @@ static uint8_t readUInt8(std::ifstream& in) {
     return value;
 }
 
+// Page header layout helpers shared by writer and reader
+static bool hasStats(const PageStats& stats) {
+    return stats.min_int.has_value() || stats.max_int.has_value() || stats.sum.has_value() ||
+           stats.distinct_count_estimate != 0 || !stats.distinct_sketch.empty() ||
+           stats.min_string.has_value() || stats.max_string.has_value();
+}
+
+static size_t pageHeaderSize(const PageHeader& header, uint16_t format_minor) {
+    size_t size = 14;
+    if (hasStats(header.stats)) {
+        size += 1 + (header.stats.min_int.has_value() ? 8 : 0);
+        size += 1 + (header.stats.max_int.has_value() ? 8 : 0);
+        size += 4;
+        if (format_minor >= 1) {
+            size += 1 + (header.stats.sum.has_value() ? 16 : 0);
+        }
+        if (format_minor >= 2) {
+            size += 8 + header.stats.distinct_sketch.size();
+        }
+        if (format_minor >= 3) {
+            size += 1 + (header.stats.min_string.has_value() ? 4 + header.stats.min_string->size() : 0);
+            size += 1 + (header.stats.max_string.has_value() ? 4 + header.stats.max_string->size() : 0);
+        }
+    }
+    return size;
+}
+
+// Upper bound of value kept to at most length bytes: value itself when it
+// fits, else its prefix with the last byte below 0xFF incremented and the
+// bytes after it dropped, which sorts after every string with that prefix.
+// None when the prefix is all 0xFF bytes.
+static std::optional<std::string> truncateUpperBound(const std::string& value, size_t length) {
+    if (value.size() <= length) {
+        return value;
+    }
+    std::string bound = value.substr(0, length);
+    while (!bound.empty() && static_cast<unsigned char>(bound.back()) == 0xFF) {
+        bound.pop_back();
+    }
+    if (bound.empty()) {
+        return std::nullopt;
+    }
+    bound.back() = static_cast<char>(static_cast<unsigned char>(bound.back()) + 1);
+    return bound;
+}
+
+static void writeOptionalString(std::ofstream& out, const std::optional<std::string>& value) {
+    writeUInt8(out, value.has_value() ? 1 : 0);
+    if (value.has_value()) {
+        writeUInt32(out, static_cast<uint32_t>(value->size()));
+        out.write(value->data(), static_cast<std::streamsize>(value->size()));
+        if (!out) {
+            throw std::runtime_error("Failed to write string statistic");
+        }
+    }
+}
+
+static std::optional<std::string> readOptionalString(std::ifstream& in) {
+    if (readUInt8(in) == 0) {
+        return std::nullopt;
+    }
+    uint32_t size = readUInt32(in);
+    if (size > MAX_STRING_STATS_LENGTH) {
+        throw std::runtime_error("Invalid metadata: string statistic too long");
+    }
+    std::string value(size, '\0');
+    in.read(value.data(), size);
+    if (!in) {
+        throw std::runtime_error("Failed to read string statistic");
+    }
+    return value;
+}
+
 // FileWriter implementation
 struct FileWriter::Impl {
     std::ofstream file;
@@ -135,6 +212,22 @@ struct FileWriter::Impl {
     std::vector<PageStats> pending_stats;
     uint32_t pending_rows = 0;
     uint32_t total_rows = 0;
+    unsigned sketch_precision = DEFAULT_CHUNK_SKETCH_PRECISION;
+    size_t string_stats_length = DEFAULT_STRING_STATS_LENGTH;
+    std::vector<double> bloom_rates;  // Per column, 0 for none
+    std::vector<std::vector<uint8_t>> pending_blooms;
+    std::vector<ChunkOrder> pending_orders;
+    std::vector<uint64_t> hashes;
+    uint32_t index_block_rows = 0;  // 0 for no column indexes
+    std::vector<std::optional<ColumnIndex>> pending_indexes;
+
+    // Column indexes, written after the last row group
+    struct StoredIndex {
+        size_t row_group;
+        size_t column;
+        ColumnIndex index;
+    };
+    std::vector<StoredIndex> indexes;
 
     Impl(const std::string& path, Schema s) : schema(std::move(s)) {
         file.open(path, std::ios::binary | std::ios::trunc);
@@ -148,18 +241,149 @@ struct FileWriter::Impl {
 
         pending_columns.resize(schema.columns.size());
         pending_stats.resize(schema.columns.size());
+        bloom_rates.assign(schema.columns.size(), 0.0);
+        pending_blooms.resize(schema.columns.size());
+        pending_orders.resize(schema.columns.size());
+        pending_indexes.resize(schema.columns.size());
+    }
+
+    // Column index of an integer chunk: block min/max and, for PLAIN and
+    // DELTA, the position of each block's second row in the encoded data
+    template<typename T>
+    void indexValues(size_t col_idx, const std::vector<T>& values, EncodingType encoding,
+                     const std::vector<uint8_t>& encoded) {
+        pending_indexes[col_idx].reset();
+        if (index_block_rows == 0 || values.empty()) {
+            return;
+        }
+
+        ColumnIndex index;
+        index.rows_per_block = index_block_rows;
+        bool seekable = encoding == EncodingType::PLAIN || encoding == EncodingType::DELTA;
+
+        // Encoded position of each row's value: DELTA stores the first value
+        // and the number of deltas, then one varint delta per later row
+        size_t pos = encoding == EncodingType::DELTA ? sizeof(T) : 0;
+        if (encoding == EncodingType::DELTA) {
+            while (encoded[pos++] & 0x80) {
+            }
+        }
+
+        for (size_t start = 0; start < values.size(); start += index_block_rows) {
+            size_t end = std::min(values.size(), start + index_block_rows);
+            auto [min_it, max_it] = std::minmax_element(values.begin() + static_cast<std::ptrdiff_t>(start),
+                                                        values.begin() + static_cast<std::ptrdiff_t>(end));
+            index.min_values.push_back(*min_it);
+            index.max_values.push_back(*max_it);
+            if (!seekable) {
+                continue;
+            }
+
+            index.first_values.push_back(values[start]);
+            if (encoding == EncodingType::PLAIN) {
+                index.offsets.push_back((start + 1) * sizeof(T));
+                continue;
+            }
+            index.offsets.push_back(pos);
+            // Skip the block's deltas up to the next block's second row
+            for (size_t row = start + 1; row < std::min(values.size(), end + 1); row++) {
+                while (encoded[pos++] & 0x80) {
+                }
+            }
+        }
+        pending_indexes[col_idx] = std::move(index);
+    }
+
+    void writeColumnIndex(const ColumnIndex& index) {
+        writeUInt32(file, index.rows_per_block);
+        writeUInt32(file, static_cast<uint32_t>(index.numBlocks()));
+        writeUInt8(file, index.seekable() ? 1 : 0);
+        for (size_t block = 0; block < index.numBlocks(); block++) {
+            writeInt64(file, index.min_values[block]);
+            writeInt64(file, index.max_values[block]);
+            if (index.seekable()) {
+                writeInt64(file, index.first_values[block]);
+                writeUInt64(file, index.offsets[block]);
+            }
+        }
+    }
+
+    template<typename T>
+    static ChunkOrder sortOrder(const std::vector<T>& values) {
+        if (std::is_sorted(values.begin(), values.end())) {
+            return ChunkOrder::ASCENDING;
+        }
+        if (std::is_sorted(values.begin(), values.end(), std::greater<T>())) {
+            return ChunkOrder::DESCENDING;
+        }
+        return ChunkOrder::UNSORTED;
+    }
+
+    // Bloom filter of a chunk's values (hashed as the query engine hashes
+    // keys), sized by the distinct count estimate when there is one
+    template<typename T>
+    void bloomValues(size_t col_idx, const std::vector<T>& values, const PageStats& stats) {
+        pending_blooms[col_idx].clear();
+        if (bloom_rates[col_idx] == 0.0 || values.empty()) {
+            return;
+        }
+
+        size_t num_keys = stats.distinct_count_estimate != 0 ? stats.distinct_count_estimate : values.size();
+        BloomFilter filter(num_keys, BloomFilter::bitsPerKey(bloom_rates[col_idx]));
+        hashColumn(values, hashes);
+        for (uint64_t hash : hashes) {
+            filter.add(hash);
+        }
+        pending_blooms[col_idx] = filter.serialize();
+    }
+
+    // Sketch the chunk's values into stats (hashed as the query engine
+    // hashes them, so chunk sketches merge with query-time sketches)
+    template<typename T>
+    void sketchValues(const std::vector<T>& values, PageStats& stats) {
+        if (sketch_precision == 0 || values.empty()) {
+            return;
+        }
+        HyperLogLog sketch(sketch_precision);
+        hashColumn(values, hashes);
+        sketch.add(hashes);
+
+        double estimate = std::min(sketch.estimate(), static_cast<double>(values.size()));
+        stats.distinct_count_estimate = std::max<uint32_t>(1, static_cast<uint32_t>(std::llround(estimate)));
+        stats.distinct_sketch = sketch.serialize();
+    }
+
+    PageStats computeStatsString(const std::vector<std::string>& values) {
+        PageStats stats;
+        stats.null_count = 0;
+        stats.distinct_count_estimate = 0;
+        sketchValues(values, stats);
+
+        if (string_stats_length > 0 && !values.empty()) {
+            auto [min_it, max_it] = std::minmax_element(values.begin(), values.end());
+            stats.min_string = min_it->substr(0, string_stats_length);
+            stats.max_string = truncateUpperBound(*max_it, string_stats_length);
+        }
+        return stats;
     }
 
     PageStats computeStatsInt32(const std::vector<int32_t>& values) {
         PageStats stats;
         stats.null_count = 0;
         stats.distinct_count_estimate = 0;
+        sketchValues(values, stats);
 
         if (!values.empty()) {
             int32_t min_val = *std::min_element(values.begin(), values.end());
             int32_t max_val = *std::max_element(values.begin(), values.end());
             stats.min_int = min_val;
             stats.max_int = max_val;
+
+            Int128 sum;
+            for (int64_t val : values) {
+                sum += val;
+            }
+            stats.sum = sum;
         }
 
         return stats;
@@ -169,12 +393,19 @@ struct FileWriter::Impl {
         PageStats stats;
         stats.null_count = 0;
         stats.distinct_count_estimate = 0;
+        sketchValues(values, stats);
 
         if (!values.empty()) {
             int64_t min_val = *std::min_element(values.begin(), values.end());
             int64_t max_val = *std::max_element(values.begin(), values.end());
             stats.min_int = min_val;
             stats.max_int = max_val;
+
+            Int128 sum;
+            for (int64_t val : values) {
+                sum += val;
+            }
+            stats.sum = sum;
         }
 
         return stats;
@@ -186,7 +417,7 @@ struct FileWriter::Impl {
         writeUInt32(file, header.num_values);
         writeUInt8(file, static_cast<uint8_t>(header.encoding));
 
-        bool has_stats = header.stats.min_int.has_value() || header.stats.max_int.has_value();
+        bool has_stats = hasStats(header.stats);
         writeUInt8(file, has_stats ? 1 : 0);
 
         if (has_stats) {
@@ -201,6 +432,23 @@ struct FileWriter::Impl {
             }
 
             writeUInt32(file, header.stats.null_count);
+
+            writeUInt8(file, header.stats.sum.has_value() ? 1 : 0);
+            if (header.stats.sum.has_value()) {
+                writeUInt64(file, header.stats.sum->lo);
+                writeInt64(file, header.stats.sum->hi);
+            }
+
+            writeUInt32(file, header.stats.distinct_count_estimate);
+            writeUInt32(file, static_cast<uint32_t>(header.stats.distinct_sketch.size()));
+            file.write(reinterpret_cast<const char*>(header.stats.distinct_sketch.data()),
+                       header.stats.distinct_sketch.size());
+            if (!file) {
+                throw std::runtime_error("Failed to write distinct sketch");
+            }
+
+            writeOptionalString(file, header.stats.min_string);
+            writeOptionalString(file, header.stats.max_string);
         }
     }
 
@@ -228,6 +476,12 @@ struct FileWriter::Impl {
                 for (const auto& ph : cc.page_headers) {
                     writePageHeader(ph);
                 }
+
+                writeUInt64(file, cc.bloom_offset);
+                writeUInt32(file, cc.bloom_size);
+                writeUInt8(file, static_cast<uint8_t>(cc.sort_order));
+                writeUInt64(file, cc.index_offset);
+                writeUInt32(file, cc.index_size);
             }
         }
 
@@ -285,6 +539,9 @@ void FileWriter::writeInt32Column(size_t col_idx, const std::vector<int32_t>& va
 
     impl_->pending_columns[col_idx] = std::move(encoded);
     impl_->pending_stats[col_idx] = impl_->computeStatsInt32(values);
+    impl_->bloomValues(col_idx, values, impl_->pending_stats[col_idx]);
+    impl_->pending_orders[col_idx] = Impl::sortOrder(values);
+    impl_->indexValues(col_idx, values, enc, impl_->pending_columns[col_idx]);
 }
 
 void FileWriter::writeInt64Column(size_t col_idx, const std::vector<int64_t>& values) {
@@ -322,6 +579,9 @@ void FileWriter::writeInt64Column(size_t col_idx, const std::vector<int64_t>& va
 
     impl_->pending_columns[col_idx] = std::move(encoded);
     impl_->pending_stats[col_idx] = impl_->computeStatsInt64(values);
+    impl_->bloomValues(col_idx, values, impl_->pending_stats[col_idx]);
+    impl_->pending_orders[col_idx] = Impl::sortOrder(values);
+    impl_->indexValues(col_idx, values, enc, impl_->pending_columns[col_idx]);
 }
 
 void FileWriter::writeStringColumn(size_t col_idx, const std::vector<std::string>& values) {
@@ -374,7 +634,40 @@ void FileWriter::writeStringColumn(size_t col_idx, const std::vector<std::string
     }
 
     impl_->pending_columns[col_idx] = std::move(encoded);
-    impl_->pending_stats[col_idx] = PageStats{};
+    impl_->pending_stats[col_idx] = impl_->computeStatsString(values);
+    impl_->bloomValues(col_idx, values, impl_->pending_stats[col_idx]);
+    impl_->pending_orders[col_idx] = Impl::sortOrder(values);
+}
+
+void FileWriter::setSketchPrecision(unsigned precision) {
+    if (precision != 0 && (precision < HyperLogLog::MIN_PRECISION || precision > HyperLogLog::MAX_PRECISION)) {
+        throw std::runtime_error("Sketch precision out of range: " + std::to_string(precision));
+    }
+    impl_->sketch_precision = precision;
+}
+
+void FileWriter::setStringStatsLength(size_t length) {
+    if (length > MAX_STRING_STATS_LENGTH) {
+        throw std::runtime_error("String statistics length out of range: " + std::to_string(length));
+    }
+    impl_->string_stats_length = length;
+}
+
+void FileWriter::setBloomFilter(size_t col_idx, double false_positive_rate) {
+    if (col_idx >= impl_->schema.columns.size()) {
+        throw std::runtime_error("Invalid column index");
+    }
+    if (false_positive_rate != 0.0) {
+        BloomFilter::bitsPerKey(false_positive_rate);  // Validates the rate
+    }
+    impl_->bloom_rates[col_idx] = false_positive_rate;
+}
+
+void FileWriter::setColumnIndex(uint32_t rows_per_block) {
+    if (impl_->pending_rows > 0) {
+        throw std::runtime_error("Column index block size can only change between row groups");
+    }
+    impl_->index_block_rows = rows_per_block;
 }
 
 void FileWriter::flushRowGroup() {
@@ -405,17 +698,43 @@ void FileWriter::flushRowGroup() {
 
         cc_meta.total_size = static_cast<uint64_t>(impl_->file.tellp()) - cc_meta.file_offset;
         cc_meta.page_headers.push_back(ph);
+        cc_meta.sort_order = impl_->pending_orders[col_idx];
 
         rg_meta.column_chunks[col_idx] = cc_meta;
     }
 
+    // The row group's Bloom filters follow its column chunks
+    for (size_t col_idx = 0; col_idx < impl_->schema.columns.size(); col_idx++) {
+        const auto& bloom = impl_->pending_blooms[col_idx];
+        if (bloom.empty()) {
+            continue;
+        }
+        auto& cc_meta = rg_meta.column_chunks[col_idx];
+        cc_meta.bloom_offset = static_cast<uint64_t>(impl_->file.tellp());
+        cc_meta.bloom_size = static_cast<uint32_t>(bloom.size());
+        impl_->file.write(reinterpret_cast<const char*>(bloom.data()), static_cast<std::streamsize>(bloom.size()));
+        if (!impl_->file) {
+            throw std::runtime_error("Failed to write Bloom filter");
+        }
+    }
+
     impl_->row_groups.push_back(rg_meta);
     impl_->total_rows += impl_->pending_rows;
+    for (size_t col_idx = 0; col_idx < impl_->schema.columns.size(); col_idx++) {
+        auto& index = impl_->pending_indexes[col_idx];
+        if (index.has_value()) {
+            impl_->indexes.push_back({impl_->row_groups.size() - 1, col_idx, std::move(*index)});
+            index.reset();
+        }
+    }
 
     impl_->pending_columns.clear();
     impl_->pending_columns.resize(impl_->schema.columns.size());
     impl_->pending_stats.clear();
     impl_->pending_stats.resize(impl_->schema.columns.size());
+    impl_->pending_blooms.clear();
+    impl_->pending_blooms.resize(impl_->schema.columns.size());
+    impl_->pending_orders.assign(impl_->schema.columns.size(), ChunkOrder::UNSORTED);
     impl_->pending_rows = 0;
 }
 
@@ -426,6 +745,15 @@ void FileWriter::close() {
 
     flushRowGroup();
 
+    // Column indexes follow the last row group
+    for (const auto& stored : impl_->indexes) {
+        auto& cc_meta = impl_->row_groups[stored.row_group].column_chunks[stored.column];
+        cc_meta.index_offset = static_cast<uint64_t>(impl_->file.tellp());
+        impl_->writeColumnIndex(stored.index);
+        cc_meta.index_size = static_cast<uint32_t>(static_cast<uint64_t>(impl_->file.tellp()) - cc_meta.index_offset);
+    }
+    impl_->indexes.clear();
+
     FileMetadata metadata;
     metadata.schema = impl_->schema;
     metadata.row_groups = impl_->row_groups;
@@ -443,7 +771,11 @@ void FileWriter::close() {
 // FileReader implementation
 struct FileReader::Impl {
     std::ifstream file;
+    std::mutex file_mutex;  // Serializes seek + read; decoding runs unlocked
     FileMetadata metadata;
+    uint16_t format_minor = 0;
+    uint64_t metadata_offset = 0;
+    uint64_t page_bytes_read = 0;  // Guarded by file_mutex
 
     explicit Impl(const std::string& path) {
         file.open(path, std::ios::binary);
@@ -464,7 +796,7 @@ struct FileReader::Impl {
             throw std::runtime_error("Invalid footer magic");
         }
 
-        uint64_t metadata_offset = readUInt64(file);
+        metadata_offset = readUInt64(file);
 
         // C4/H2 fix: Validate metadata offset is within file bounds
         if (metadata_offset >= file_size) {
@@ -478,7 +810,7 @@ struct FileReader::Impl {
         }
 
         uint16_t major = readUInt16(file);
-        uint16_t minor = readUInt16(file);
+        format_minor = readUInt16(file);
 
         if (major != FORMAT_VERSION_MAJOR) {
             throw std::runtime_error("Unsupported file version");
@@ -511,11 +843,40 @@ struct FileReader::Impl {
             }
 
             ph.stats.null_count = readUInt32(file);
+
+            if (format_minor >= 1) {
+                uint8_t has_sum = readUInt8(file);
+                if (has_sum) {
+                    Int128 sum;
+                    sum.lo = readUInt64(file);
+                    sum.hi = readInt64(file);
+                    ph.stats.sum = sum;
+                }
+            }
+
+            ph.stats.distinct_count_estimate = 0;
+            if (format_minor >= 2) {
+                ph.stats.distinct_count_estimate = readUInt32(file);
+                uint32_t sketch_size = readUInt32(file);
+                if (sketch_size > 1 + (size_t{1} << HyperLogLog::MAX_PRECISION)) {
+                    throw std::runtime_error("Invalid metadata: distinct sketch too large");
+                }
+                ph.stats.distinct_sketch.resize(sketch_size);
+                file.read(reinterpret_cast<char*>(ph.stats.distinct_sketch.data()), sketch_size);
+                if (!file) {
+                    throw std::runtime_error("Failed to read distinct sketch");
+                }
+            }
+
+            if (format_minor >= 3) {
+                ph.stats.min_string = readOptionalString(file);
+                ph.stats.max_string = readOptionalString(file);
+            }
         } else {
             ph.stats.null_count = 0;
+            ph.stats.distinct_count_estimate = 0;
         }
 
-        ph.stats.distinct_count_estimate = 0;
         return ph;
     }
 
@@ -566,6 +927,32 @@ struct FileReader::Impl {
                 for (size_t k = 0; k < num_pages; k++) {
                     cc.page_headers[k] = readPageHeader();
                 }
+
+                if (format_minor >= 4) {
+                    cc.bloom_offset = readUInt64(file);
+                    cc.bloom_size = readUInt32(file);
+                    if (cc.bloom_size > 0 && (cc.bloom_offset > metadata_offset ||
+                                              cc.bloom_size > metadata_offset - cc.bloom_offset)) {
+                        throw std::runtime_error("Invalid metadata: Bloom filter out of bounds");
+                    }
+                }
+
+                if (format_minor >= 5) {
+                    uint8_t order = readUInt8(file);
+                    if (order > static_cast<uint8_t>(ChunkOrder::DESCENDING)) {
+                        throw std::runtime_error("Invalid metadata: unknown sort order");
+                    }
+                    cc.sort_order = static_cast<ChunkOrder>(order);
+                }
+
+                if (format_minor >= 6) {
+                    cc.index_offset = readUInt64(file);
+                    cc.index_size = readUInt32(file);
+                    if (cc.index_size > 0 && (cc.index_offset > metadata_offset ||
+                                              cc.index_size > metadata_offset - cc.index_offset)) {
+                        throw std::runtime_error("Invalid metadata: column index out of bounds");
+                    }
+                }
             }
         }
 
@@ -576,30 +963,88 @@ struct FileReader::Impl {
         if (page_idx >= cc_meta.page_headers.size()) {
             throw std::runtime_error("Invalid page index");
         }
+        return readPageBytes(cc_meta, page_idx, 0, cc_meta.page_headers[page_idx].compressed_size);
+    }
 
+    // Bytes [begin, end) of a page's data
+    std::vector<uint8_t> readPageBytes(const ColumnChunkMeta& cc_meta, size_t page_idx, uint64_t begin, uint64_t end) {
         uint64_t page_offset = cc_meta.file_offset;
         for (size_t i = 0; i < page_idx; i++) {
-            size_t header_size = 14;
-            if (cc_meta.page_headers[i].stats.min_int.has_value() ||
-                cc_meta.page_headers[i].stats.max_int.has_value()) {
-                header_size += 22;
-            }
-            page_offset += header_size + cc_meta.page_headers[i].compressed_size;
+            page_offset += pageHeaderSize(cc_meta.page_headers[i], format_minor) +
+                           cc_meta.page_headers[i].compressed_size;
         }
+        page_offset += pageHeaderSize(cc_meta.page_headers[page_idx], format_minor);
 
-        size_t header_size = 14;
-        if (cc_meta.page_headers[page_idx].stats.min_int.has_value() ||
-            cc_meta.page_headers[page_idx].stats.max_int.has_value()) {
-            header_size += 22;
-        }
-        page_offset += header_size;
+        std::vector<uint8_t> data(end - begin);
 
-        file.seekg(page_offset);
-        std::vector<uint8_t> data(cc_meta.page_headers[page_idx].compressed_size);
-        file.read(reinterpret_cast<char*>(data.data()), data.size());
+        std::lock_guard<std::mutex> lock(file_mutex);
+        file.seekg(static_cast<std::streamoff>(page_offset + begin));
+        file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        page_bytes_read += data.size();
 
         return data;
     }
+
+    // Rows of blocks [first_block, end_block) of an integer chunk, from
+    // the bytes between the blocks' offsets
+    template<typename T>
+    std::vector<T> readBlocks(size_t row_group_idx, size_t col_idx, const ColumnIndex& index,
+                              size_t first_block, size_t end_block) {
+        if (row_group_idx >= metadata.row_groups.size()) {
+            throw std::runtime_error("Invalid row group index");
+        }
+        const auto& rg = metadata.row_groups[row_group_idx];
+        if (col_idx >= rg.column_chunks.size()) {
+            throw std::runtime_error("Invalid column index");
+        }
+        const auto& cc = rg.column_chunks[col_idx];
+        if (!index.seekable() || cc.page_headers.empty() || first_block >= end_block ||
+            end_block > index.numBlocks()) {
+            throw std::runtime_error("Invalid column index block range");
+        }
+
+        const auto& ph = cc.page_headers[0];
+        size_t row_begin = first_block * index.rows_per_block;
+        size_t row_end = std::min<size_t>(ph.num_values, end_block * index.rows_per_block);
+        uint64_t byte_end = end_block < index.numBlocks() ? index.offsets[end_block] : ph.compressed_size;
+        if (index.offsets[first_block] > byte_end || byte_end > ph.compressed_size) {
+            throw std::runtime_error("Column index offsets past the page data");
+        }
+        auto data = readPageBytes(cc, 0, index.offsets[first_block], byte_end);
+
+        std::vector<T> result(row_end - row_begin);
+        result[0] = static_cast<T>(index.first_values[first_block]);
+        switch (ph.encoding) {
+        case EncodingType::PLAIN:
+            if (data.size() < (result.size() - 1) * sizeof(T)) {
+                throw std::runtime_error("Column index offsets past the page data");
+            }
+            if (result.size() > 1) {
+                std::memcpy(result.data() + 1, data.data(), (result.size() - 1) * sizeof(T));
+            }
+            break;
+        case EncodingType::DELTA: {
+            size_t pos = 0;
+            size_t bytes_read = 0;
+            // Wrapping sums, as in DeltaEncoder
+            using U = std::make_unsigned_t<T>;
+            for (size_t i = 1; i < result.size(); i++) {
+                T delta;
+                if constexpr (std::is_same_v<T, int32_t>) {
+                    delta = VarintCodec::decodeInt32Safe(data.data() + pos, data.size() - pos, &bytes_read);
+                } else {
+                    delta = VarintCodec::decodeInt64Safe(data.data() + pos, data.size() - pos, &bytes_read);
+                }
+                result[i] = static_cast<T>(static_cast<U>(result[i - 1]) + static_cast<U>(delta));
+                pos += bytes_read;
+            }
+            break;
+        }
+        default:
+            throw std::runtime_error("Column index offsets on an encoding that cannot seek");
+        }
+        return result;
+    }
 };
 
 FileReader::FileReader(const std::string& path)
@@ -615,6 +1060,11 @@ const FileMetadata& FileReader::metadata() const {
     return impl_->metadata;
 }
 
+uint64_t FileReader::pageBytesRead() const {
+    std::lock_guard<std::mutex> lock(impl_->file_mutex);
+    return impl_->page_bytes_read;
+}
+
 std::vector<int32_t> FileReader::readInt32Column(size_t row_group_idx, size_t col_idx) {
     if (row_group_idx >= impl_->metadata.row_groups.size()) {
         throw std::runtime_error("Invalid row group index");
@@ -717,4 +1167,182 @@ std::vector<std::string> FileReader::readStringColumn(size_t row_group_idx, size
     }
 }
 
+DictionaryColumn FileReader::readDictionaryColumn(size_t row_group_idx, size_t col_idx) {
+    if (row_group_idx >= impl_->metadata.row_groups.size()) {
+        throw std::runtime_error("Invalid row group index");
+    }
+
+    const auto& rg = impl_->metadata.row_groups[row_group_idx];
+    if (col_idx >= rg.column_chunks.size()) {
+        throw std::runtime_error("Invalid column index");
+    }
+
+    const auto& cc = rg.column_chunks[col_idx];
+    auto data = impl_->readPageData(cc, 0);
+
+    const auto& ph = cc.page_headers[0];
+    if (ph.encoding != EncodingType::DICTIONARY) {
+        throw std::runtime_error("Column chunk is not dictionary encoded");
+    }
+
+    DictionaryColumn result;
+    result.codes = DictionaryEncoder::decodeCodes(data.data(), data.size(), ph.num_values, result.dictionary);
+    return result;
+}
+
+std::optional<BloomFilter> FileReader::readBloomFilter(size_t row_group_idx, size_t col_idx) {
+    if (row_group_idx >= impl_->metadata.row_groups.size()) {
+        throw std::runtime_error("Invalid row group index");
+    }
+
+    const auto& rg = impl_->metadata.row_groups[row_group_idx];
+    if (col_idx >= rg.column_chunks.size()) {
+        throw std::runtime_error("Invalid column index");
+    }
+
+    const auto& cc = rg.column_chunks[col_idx];
+    if (cc.bloom_size == 0) {
+        return std::nullopt;
+    }
+
+    std::vector<uint8_t> data(cc.bloom_size);
+    {
+        std::lock_guard<std::mutex> lock(impl_->file_mutex);
+        impl_->file.seekg(static_cast<std::streamoff>(cc.bloom_offset));
+        impl_->file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!impl_->file) {
+            impl_->file.clear();
+            throw std::runtime_error("Failed to read Bloom filter");
+        }
+    }
+    return BloomFilter::deserialize(data.data(), data.size());
+}
+
+std::optional<ColumnIndex> FileReader::readColumnIndex(size_t row_group_idx, size_t col_idx) {
+    if (row_group_idx >= impl_->metadata.row_groups.size()) {
+        throw std::runtime_error("Invalid row group index");
+    }
+
+    const auto& rg = impl_->metadata.row_groups[row_group_idx];
+    if (col_idx >= rg.column_chunks.size()) {
+        throw std::runtime_error("Invalid column index");
+    }
+
+    const auto& cc = rg.column_chunks[col_idx];
+    if (cc.index_size == 0 || cc.page_headers.empty()) {
+        return std::nullopt;
+    }
+
+    std::vector<uint8_t> data(cc.index_size);
+    {
+        std::lock_guard<std::mutex> lock(impl_->file_mutex);
+        impl_->file.seekg(static_cast<std::streamoff>(cc.index_offset));
+        impl_->file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!impl_->file) {
+            impl_->file.clear();
+            throw std::runtime_error("Failed to read column index");
+        }
+    }
+
+    size_t pos = 0;
+    auto read = [&](auto& value) {
+        if (data.size() - pos < sizeof(value)) {
+            throw std::runtime_error("Truncated column index");
+        }
+        std::memcpy(&value, data.data() + pos, sizeof(value));
+        pos += sizeof(value);
+    };
+
+    ColumnIndex index;
+    uint32_t num_blocks = 0;
+    uint8_t seekable = 0;
+    read(index.rows_per_block);
+    read(num_blocks);
+    read(seekable);
+    const auto& ph = cc.page_headers[0];
+    if (index.rows_per_block == 0 ||
+        num_blocks != (static_cast<uint64_t>(ph.num_values) + index.rows_per_block - 1) / index.rows_per_block ||
+        data.size() != 9 + static_cast<size_t>(num_blocks) * (seekable ? 32 : 16)) {
+        throw std::runtime_error("Invalid column index");
+    }
+
+    index.min_values.resize(num_blocks);
+    index.max_values.resize(num_blocks);
+    if (seekable) {
+        index.first_values.resize(num_blocks);
+        index.offsets.resize(num_blocks);
+    }
+    for (size_t block = 0; block < num_blocks; block++) {
+        read(index.min_values[block]);
+        read(index.max_values[block]);
+        if (seekable) {
+            read(index.first_values[block]);
+            read(index.offsets[block]);
+            if (index.offsets[block] > ph.compressed_size || (block > 0 && index.offsets[block] < index.offsets[block - 1])) {
+                throw std::runtime_error("Invalid column index: offset out of order");
+            }
+        }
+    }
+    return index;
+}
+
+std::vector<int32_t> FileReader::readInt32Blocks(size_t row_group_idx, size_t col_idx, const ColumnIndex& index,
+                                                 size_t first_block, size_t end_block) {
+    return impl_->readBlocks<int32_t>(row_group_idx, col_idx, index, first_block, end_block);
+}
+
+std::vector<int64_t> FileReader::readInt64Blocks(size_t row_group_idx, size_t col_idx, const ColumnIndex& index,
+                                                 size_t first_block, size_t end_block) {
+    return impl_->readBlocks<int64_t>(row_group_idx, col_idx, index, first_block, end_block);
+}
+
+// Union of sketches at the coarsest precision among them
+static void mergeSketch(std::optional<HyperLogLog>& into, HyperLogLog sketch) {
+    if (!into.has_value()) {
+        into = std::move(sketch);
+    } else if (sketch.precision() < into->precision()) {
+        sketch.merge(into->reduce(sketch.precision()));
+        into = std::move(sketch);
+    } else {
+        into->merge(sketch.reduce(into->precision()));
+    }
+}
+
+std::optional<HyperLogLog> FileReader::distinctSketch(size_t row_group_idx, size_t col_idx) const {
+    if (row_group_idx >= impl_->metadata.row_groups.size()) {
+        throw std::runtime_error("Invalid row group index");
+    }
+
+    const auto& rg = impl_->metadata.row_groups[row_group_idx];
+    if (col_idx >= rg.column_chunks.size()) {
+        throw std::runtime_error("Invalid column index");
+    }
+
+    std::optional<HyperLogLog> sketch;
+    for (const auto& ph : rg.column_chunks[col_idx].page_headers) {
+        if (ph.stats.distinct_sketch.empty()) {
+            return std::nullopt;
+        }
+        mergeSketch(sketch, HyperLogLog::deserialize(ph.stats.distinct_sketch.data(),
+                                                     ph.stats.distinct_sketch.size()));
+    }
+    return sketch;
+}
+
+std::optional<HyperLogLog> FileReader::distinctSketch(size_t col_idx) const {
+    if (col_idx >= impl_->metadata.schema.columns.size()) {
+        throw std::runtime_error("Invalid column index");
+    }
+
+    std::optional<HyperLogLog> sketch;
+    for (size_t rg = 0; rg < impl_->metadata.row_groups.size(); rg++) {
+        auto chunk = distinctSketch(rg, col_idx);
+        if (!chunk.has_value()) {
+            return std::nullopt;
+        }
+        mergeSketch(sketch, std::move(chunk.value()));
+    }
+    return sketch;
+}
+
 } // namespace columnar
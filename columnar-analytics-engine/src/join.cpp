@@ -0,0 +1,511 @@
+// Columnar Analytics Engine
+// Author: RIAL Fares
+// Hash join implementation
+
+#include "join.h"
+#include "aggregation.h"
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace columnar {
+
+namespace {
+
+// With several threads, build rows are split by the top bits of their key
+// hash into this many partitions, each with its own table
+constexpr unsigned JOIN_PARTITION_BITS = 6;
+
+// Build row paired with a probe row that has no match (left joins)
+constexpr uint32_t NO_ROW = UINT32_MAX;
+
+bool isIntegerColumn(const Schema& schema, const std::string& name) {
+    ColumnType type = schema.columns[schema.columnIndex(name)].type;
+    return type == ColumnType::INT32 || type == ColumnType::INT64;
+}
+
+// Columns one side scans: its result columns, then its key if the key is
+// not one of them
+struct SidePlan {
+    std::vector<std::string> scan_columns;
+    size_t num_output;
+    size_t key_pos;
+};
+
+SidePlan planSide(const Schema& schema, std::vector<std::string> columns, const std::string& key) {
+    if (columns.empty()) {
+        for (const auto& col : schema.columns) {
+            columns.push_back(col.name);
+        }
+    }
+    for (const auto& name : columns) {
+        schema.columnIndex(name);  // Throws for unknown columns
+    }
+
+    SidePlan plan;
+    plan.num_output = columns.size();
+    auto it = std::find(columns.begin(), columns.end(), key);
+    plan.key_pos = static_cast<size_t>(it - columns.begin());
+    if (it == columns.end()) {
+        columns.push_back(key);
+    }
+    plan.scan_columns = std::move(columns);
+    return plan;
+}
+
+Batch::ColumnData emptyColumn(ColumnType type) {
+    switch (type) {
+    case ColumnType::INT32:
+        return std::vector<int32_t>{};
+    case ColumnType::INT64:
+        return std::vector<int64_t>{};
+    case ColumnType::STRING:
+        return std::vector<std::string>{};
+    }
+    throw std::runtime_error("Unknown column type");
+}
+
+void appendColumn(Batch::ColumnData& dst, Batch::ColumnData& src) {
+    std::visit([&src](auto& out) {
+        auto& in = std::get<std::decay_t<decltype(out)>>(src);
+        out.insert(out.end(), std::make_move_iterator(in.begin()), std::make_move_iterator(in.end()));
+    }, dst);
+}
+
+// Values of the given rows; NO_ROW gives 0 or the empty string
+Batch::ColumnData gatherRows(const Batch::ColumnData& col, const std::vector<uint32_t>& rows) {
+    return std::visit([&rows](const auto& vals) -> Batch::ColumnData {
+        std::decay_t<decltype(vals)> out(rows.size());
+        for (size_t i = 0; i < rows.size(); i++) {
+            if (rows[i] != NO_ROW) {
+                out[i] = vals[rows[i]];
+            }
+        }
+        return out;
+    }, col);
+}
+
+void hashKeys(const Batch::ColumnData& col, std::vector<uint64_t>& hashes) {
+    std::visit([&hashes](const auto& vals) { hashColumn(vals, hashes); }, col);
+}
+
+// Smallest and largest integer key, if the column holds integers
+std::optional<std::pair<int64_t, int64_t>> integerKeyRange(const Batch::ColumnData& col) {
+    return std::visit([](const auto& vals) -> std::optional<std::pair<int64_t, int64_t>> {
+        using T = typename std::decay_t<decltype(vals)>::value_type;
+        if constexpr (std::is_same_v<T, std::string>) {
+            return std::nullopt;
+        } else {
+            if (vals.empty()) {
+                return std::nullopt;
+            }
+            auto [lo, hi] = std::minmax_element(vals.begin(), vals.end());
+            return std::make_pair(static_cast<int64_t>(*lo), static_cast<int64_t>(*hi));
+        }
+    }, col);
+}
+
+// Build side rows, in file order
+struct BuildSide {
+    std::vector<Batch::ColumnData> columns;  // The build side's scan columns
+    size_t num_rows = 0;
+};
+
+BuildSide loadBuildSide(const std::shared_ptr<FileReader>& reader, const SidePlan& plan,
+                        const std::vector<Predicate>& filters, size_t batch_size, size_t num_threads) {
+    // Workers load row groups one at a time, concatenated afterwards in
+    // row group order
+    size_t num_row_groups = reader->metadata().row_groups.size();
+    std::vector<std::vector<Batch>> chunks(num_row_groups);
+    std::atomic<size_t> next_rg{0};
+
+    runWorkers(std::max<size_t>(std::min(num_threads, num_row_groups), 1), [&](size_t) {
+        Scanner scanner(reader, plan.scan_columns, batch_size);
+        for (const auto& filter : filters) {
+            scanner.addFilter(filter);
+        }
+        for (size_t rg = next_rg++; rg < num_row_groups; rg = next_rg++) {
+            scanner.setRowGroups({rg});
+            while (scanner.hasNext()) {
+                Batch batch = scanner.next();
+                if (batch.num_rows > 0) {
+                    chunks[rg].push_back(std::move(batch));
+                }
+            }
+        }
+    });
+
+    BuildSide build;
+    const Schema& schema = reader->schema();
+    for (const auto& name : plan.scan_columns) {
+        build.columns.push_back(emptyColumn(schema.columns[schema.columnIndex(name)].type));
+    }
+    for (auto& chunk : chunks) {
+        for (auto& batch : chunk) {
+            for (size_t c = 0; c < build.columns.size(); c++) {
+                appendColumn(build.columns[c], batch.columns[c]);
+            }
+            build.num_rows += batch.num_rows;
+        }
+        std::vector<Batch>().swap(chunk);
+    }
+
+    if (build.num_rows >= NO_ROW) {
+        throw std::runtime_error("Join build side has too many rows");
+    }
+    return build;
+}
+
+template<typename Table>
+using JoinKey = std::conditional_t<std::is_same_v<Table, StringGroupTable>, std::string, int64_t>;
+
+// Hash tables over the build keys, one per partition. The build rows of
+// group g of partition p are rows[p][offsets[p][g] .. offsets[p][g + 1]),
+// in file order.
+template<typename Table>
+struct JoinTable {
+    unsigned partition_bits = 0;
+    std::vector<Table> tables;
+    std::vector<std::vector<uint32_t>> offsets;
+    std::vector<std::vector<uint32_t>> rows;
+
+    size_t partition(uint64_t hash) const {
+        return partition_bits == 0 ? 0 : static_cast<size_t>(hash >> (64 - partition_bits));
+    }
+};
+
+template<typename Table>
+void gatherKeys(const Batch::ColumnData& col, const uint32_t* rows, size_t num_rows,
+                std::vector<JoinKey<Table>>& keys) {
+    keys.clear();
+    keys.reserve(num_rows);
+    std::visit([&](const auto& vals) {
+        using T = typename std::decay_t<decltype(vals)>::value_type;
+        if constexpr (std::is_same_v<T, std::string> == std::is_same_v<JoinKey<Table>, std::string>) {
+            for (size_t i = 0; i < num_rows; i++) {
+                keys.push_back(JoinKey<Table>(vals[rows[i]]));
+            }
+        }
+    }, col);
+}
+
+template<typename Table>
+JoinTable<Table> buildJoinTable(const Batch::ColumnData& key_col, size_t num_rows, size_t num_threads) {
+    JoinTable<Table> table;
+    table.partition_bits = num_threads > 1 ? JOIN_PARTITION_BITS : 0;
+    size_t num_partitions = size_t{1} << table.partition_bits;
+
+    std::vector<uint64_t> hashes;
+    hashKeys(key_col, hashes);
+
+    // Counting sort of the build rows by partition, keeping file order
+    std::vector<size_t> starts(num_partitions + 1, 0);
+    for (uint64_t hash : hashes) {
+        starts[table.partition(hash) + 1]++;
+    }
+    for (size_t p = 0; p < num_partitions; p++) {
+        starts[p + 1] += starts[p];
+    }
+    std::vector<uint32_t> partitioned(num_rows);
+    std::vector<size_t> fill(starts.begin(), starts.end() - 1);
+    for (size_t row = 0; row < num_rows; row++) {
+        partitioned[fill[table.partition(hashes[row])]++] = static_cast<uint32_t>(row);
+    }
+
+    table.tables.resize(num_partitions);
+    table.offsets.resize(num_partitions);
+    table.rows.resize(num_partitions);
+
+    std::atomic<size_t> next_partition{0};
+    runWorkers(std::min(num_threads, num_partitions), [&](size_t) {
+        std::vector<JoinKey<Table>> keys;
+        std::vector<uint32_t> group_ids;
+        for (size_t p = next_partition++; p < num_partitions; p = next_partition++) {
+            const uint32_t* part_rows = partitioned.data() + starts[p];
+            size_t part_size = starts[p + 1] - starts[p];
+            gatherKeys<Table>(key_col, part_rows, part_size, keys);
+            table.tables[p].findOrInsert(keys, group_ids);
+
+            // Counting sort of the partition's rows by group, keeping file order
+            auto& offsets = table.offsets[p];
+            offsets.assign(table.tables[p].size() + 1, 0);
+            for (uint32_t g : group_ids) {
+                offsets[g + 1]++;
+            }
+            for (size_t g = 1; g < offsets.size(); g++) {
+                offsets[g] += offsets[g - 1];
+            }
+            std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+            auto& rows = table.rows[p];
+            rows.resize(part_size);
+            for (size_t i = 0; i < part_size; i++) {
+                rows[cursor[group_ids[i]]++] = part_rows[i];
+            }
+        }
+    });
+    return table;
+}
+
+// Where a result column comes from: position among the build or probe
+// side's scan columns
+struct OutputColumn {
+    bool from_build;
+    size_t pos;
+};
+
+// Everything the probe needs besides the build side
+struct ProbePlan {
+    std::shared_ptr<FileReader> reader;
+    SidePlan side;
+    std::vector<Predicate> filters;
+    std::vector<size_t> row_groups;
+    std::vector<OutputColumn> outputs;
+    std::vector<std::string> names;
+    bool left_join;
+    size_t batch_size;
+    size_t num_threads;
+};
+
+template<typename Table>
+class HashJoinSource : public BatchSource {
+public:
+    HashJoinSource(ProbePlan plan, BuildSide build, JoinTable<Table> table)
+        : plan_(std::move(plan)), build_(std::move(build)), table_(std::move(table)) {
+        size_t num_workers = std::max<size_t>(std::min(plan_.num_threads, plan_.row_groups.size()), 1);
+        for (size_t w = 0; w < num_workers; w++) {
+            scanners_.push_back(std::make_unique<Scanner>(plan_.reader, plan_.side.scan_columns, plan_.batch_size));
+            for (const auto& filter : plan_.filters) {
+                scanners_.back()->addFilter(filter);
+            }
+        }
+        hashes_.resize(num_workers);
+    }
+
+    bool hasNext() override {
+        while (ready_.empty() && next_rg_ < plan_.row_groups.size()) {
+            probeWave();
+        }
+        return !ready_.empty();
+    }
+
+    Batch next() override {
+        if (!hasNext()) {
+            throw std::runtime_error("No more batches");
+        }
+        Batch batch = std::move(ready_.front());
+        ready_.pop_front();
+        return batch;
+    }
+
+private:
+    // Probe the next row group on each worker, queueing results in row group order
+    void probeWave() {
+        size_t wave = std::min(scanners_.size(), plan_.row_groups.size() - next_rg_);
+        std::vector<std::vector<Batch>> results(wave);
+
+        runWorkers(wave, [&](size_t w) {
+            Scanner& scanner = *scanners_[w];
+            scanner.setRowGroups({plan_.row_groups[next_rg_ + w]});
+            while (scanner.hasNext()) {
+                Batch batch = scanner.next();
+                if (batch.num_rows == 0) {
+                    continue;
+                }
+                Batch out = probeBatch(batch, hashes_[w]);
+                if (out.num_rows > 0) {
+                    results[w].push_back(std::move(out));
+                }
+            }
+        });
+
+        next_rg_ += wave;
+        for (auto& batches : results) {
+            for (auto& batch : batches) {
+                ready_.push_back(std::move(batch));
+            }
+        }
+    }
+
+    Batch probeBatch(const Batch& batch, std::vector<uint64_t>& hashes) const {
+        const auto& key_col = batch.columns[plan_.side.key_pos];
+        hashKeys(key_col, hashes);
+
+        std::vector<uint32_t> probe_rows;
+        std::vector<uint32_t> build_rows;
+        probe_rows.reserve(batch.num_rows);
+        build_rows.reserve(batch.num_rows);
+
+        std::visit([&](const auto& keys) {
+            using T = typename std::decay_t<decltype(keys)>::value_type;
+            if constexpr (std::is_same_v<T, std::string> == std::is_same_v<JoinKey<Table>, std::string>) {
+                for (size_t i = 0; i < keys.size(); i++) {
+                    size_t p = table_.partition(hashes[i]);
+                    uint32_t g;
+                    if constexpr (std::is_same_v<T, std::string>) {
+                        g = table_.tables[p].find(std::string_view(keys[i]), hashes[i]);
+                    } else {
+                        g = table_.tables[p].find(static_cast<int64_t>(keys[i]), hashes[i]);
+                    }
+
+                    if (g != NO_GROUP) {
+                        const auto& offsets = table_.offsets[p];
+                        for (uint32_t k = offsets[g]; k < offsets[g + 1]; k++) {
+                            probe_rows.push_back(static_cast<uint32_t>(i));
+                            build_rows.push_back(table_.rows[p][k]);
+                        }
+                    } else if (plan_.left_join) {
+                        probe_rows.push_back(static_cast<uint32_t>(i));
+                        build_rows.push_back(NO_ROW);
+                    }
+                }
+            }
+        }, key_col);
+
+        Batch out;
+        out.num_rows = probe_rows.size();
+        out.column_names = plan_.names;
+        for (const auto& output : plan_.outputs) {
+            out.columns.push_back(output.from_build ? gatherRows(build_.columns[output.pos], build_rows)
+                                                    : gatherRows(batch.columns[output.pos], probe_rows));
+        }
+        if (plan_.left_join) {
+            std::vector<int32_t> matched(build_rows.size());
+            for (size_t i = 0; i < build_rows.size(); i++) {
+                matched[i] = build_rows[i] != NO_ROW ? 1 : 0;
+            }
+            out.columns.push_back(std::move(matched));
+        }
+        return out;
+    }
+
+    ProbePlan plan_;
+    BuildSide build_;
+    JoinTable<Table> table_;
+    std::vector<std::unique_ptr<Scanner>> scanners_;
+    std::vector<std::vector<uint64_t>> hashes_;  // Per worker
+    std::deque<Batch> ready_;
+    size_t next_rg_ = 0;
+};
+
+template<typename Table>
+std::unique_ptr<BatchSource> makeJoinSource(ProbePlan plan, BuildSide build, size_t build_key_pos) {
+    JoinTable<Table> table = buildJoinTable<Table>(build.columns[build_key_pos], build.num_rows, plan.num_threads);
+    return std::make_unique<HashJoinSource<Table>>(std::move(plan), std::move(build), std::move(table));
+}
+
+} // namespace
+
+HashJoin::HashJoin(std::shared_ptr<FileReader> left, std::string left_key,
+                   std::shared_ptr<FileReader> right, std::string right_key,
+                   JoinType type)
+    : left_{std::move(left), std::move(left_key), {}, {}}
+    , right_{std::move(right), std::move(right_key), {}, {}}
+    , type_(type)
+    , batch_size_(4096)
+    , num_threads_(1)
+    , build_rows_(0) {
+    if (isIntegerColumn(left_.reader->schema(), left_.key) != isIntegerColumn(right_.reader->schema(), right_.key)) {
+        throw std::runtime_error("Join keys must both be integers or both be strings");
+    }
+}
+
+void HashJoin::setLeftColumns(std::vector<std::string> columns) {
+    left_.columns = std::move(columns);
+}
+
+void HashJoin::setRightColumns(std::vector<std::string> columns) {
+    right_.columns = std::move(columns);
+}
+
+void HashJoin::addLeftFilter(Predicate pred) {
+    left_.filters.push_back(std::move(pred));
+}
+
+void HashJoin::addRightFilter(Predicate pred) {
+    right_.filters.push_back(std::move(pred));
+}
+
+void HashJoin::setBatchSize(size_t batch_size) {
+    batch_size_ = batch_size;
+}
+
+void HashJoin::setThreads(size_t num_threads) {
+    num_threads_ = num_threads;
+}
+
+bool HashJoin::buildsOnLeft() const {
+    return type_ == JoinType::INNER &&
+           left_.reader->metadata().total_rows < right_.reader->metadata().total_rows;
+}
+
+ResultStream HashJoin::execute() {
+    bool build_left = buildsOnLeft();
+    const Side& build = build_left ? left_ : right_;
+    const Side& probe = build_left ? right_ : left_;
+
+    SidePlan build_plan = planSide(build.reader->schema(), build.columns, build.key);
+    ProbePlan plan;
+    plan.reader = probe.reader;
+    plan.side = planSide(probe.reader->schema(), probe.columns, probe.key);
+    plan.filters = probe.filters;
+    plan.left_join = type_ == JoinType::LEFT;
+    plan.batch_size = batch_size_;
+    plan.num_threads = num_threads_ != 0 ? num_threads_ : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+    BuildSide build_side = loadBuildSide(build.reader, build_plan, build.filters, batch_size_, plan.num_threads);
+    build_rows_ = build_side.num_rows;
+
+    // Result columns: the left ones, then the right ones
+    const SidePlan& left_plan = build_left ? build_plan : plan.side;
+    const SidePlan& right_plan = build_left ? plan.side : build_plan;
+    for (size_t c = 0; c < left_plan.num_output; c++) {
+        plan.outputs.push_back({build_left, c});
+        plan.names.push_back(left_plan.scan_columns[c]);
+    }
+    for (size_t c = 0; c < right_plan.num_output; c++) {
+        const std::string& name = right_plan.scan_columns[c];
+        auto left_names_end = plan.names.begin() + static_cast<std::ptrdiff_t>(left_plan.num_output);
+        bool clash = std::find(plan.names.begin(), left_names_end, name) != left_names_end;
+        plan.outputs.push_back({!build_left, c});
+        plan.names.push_back(clash ? "right." + name : name);
+    }
+    if (plan.left_join) {
+        plan.names.push_back("matched");
+    }
+
+    // An inner join only probes row groups whose key stats overlap the
+    // build keys
+    std::optional<std::pair<int64_t, int64_t>> key_range;
+    if (!plan.left_join) {
+        key_range = integerKeyRange(build_side.columns[build_plan.key_pos]);
+    }
+    size_t probe_key_idx = probe.reader->schema().columnIndex(probe.key);
+    for (size_t rg = 0; rg < probe.reader->metadata().row_groups.size(); rg++) {
+        if (!plan.left_join && build_side.num_rows == 0) {
+            break;
+        }
+        const auto& cc = probe.reader->metadata().row_groups[rg].column_chunks[probe_key_idx];
+        if (key_range.has_value() && !cc.page_headers.empty()) {
+            const PageStats& stats = cc.page_headers[0].stats;
+            if (Predicate{probe.key, CompareOp::GE, key_range->first}.matchStats(stats) == StatsMatch::NEVER ||
+                Predicate{probe.key, CompareOp::LE, key_range->second}.matchStats(stats) == StatsMatch::NEVER) {
+                continue;
+            }
+        }
+        plan.row_groups.push_back(rg);
+    }
+
+    if (isIntegerColumn(build.reader->schema(), build.key)) {
+        return ResultStream(makeJoinSource<IntGroupTable>(std::move(plan), std::move(build_side), build_plan.key_pos));
+    }
+    return ResultStream(makeJoinSource<StringGroupTable>(std::move(plan), std::move(build_side), build_plan.key_pos));
+}
+
+} // namespace columnar
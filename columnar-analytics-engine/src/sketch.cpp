@@ -0,0 +1,176 @@
+// Columnar Analytics Engine
+// Author: RIAL Fares
+// Probabilistic sketch implementation
+
+#include "sketch.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace columnar {
+
+// HyperLogLog
+HyperLogLog::HyperLogLog(unsigned precision)
+    : precision_(precision) {
+    if (precision < MIN_PRECISION || precision > MAX_PRECISION) {
+        throw std::runtime_error("HyperLogLog precision out of range: " + std::to_string(precision));
+    }
+    registers_.assign(size_t{1} << precision_, 0);
+}
+
+unsigned HyperLogLog::precisionForError(double relative_error) {
+    if (!(relative_error > 0.0)) {
+        throw std::runtime_error("HyperLogLog error must be positive");
+    }
+    double registers = (1.04 / relative_error) * (1.04 / relative_error);
+    unsigned precision = static_cast<unsigned>(std::ceil(std::log2(registers)));
+    return std::clamp(precision, MIN_PRECISION, MAX_PRECISION);
+}
+
+void HyperLogLog::add(const std::vector<uint64_t>& hashes) {
+    for (uint64_t hash : hashes) {
+        add(hash);
+    }
+}
+
+void HyperLogLog::merge(const HyperLogLog& other) {
+    if (other.precision_ != precision_) {
+        throw std::runtime_error("Cannot merge HyperLogLog sketches of different precision");
+    }
+    for (size_t i = 0; i < registers_.size(); i++) {
+        registers_[i] = std::max(registers_[i], other.registers_[i]);
+    }
+}
+
+double HyperLogLog::relativeError() const {
+    return 1.04 / std::sqrt(static_cast<double>(registers_.size()));
+}
+
+HyperLogLog HyperLogLog::reduce(unsigned precision) const {
+    if (precision > precision_) {
+        throw std::runtime_error("Cannot raise HyperLogLog precision");
+    }
+    HyperLogLog reduced(precision);
+    unsigned shift = precision_ - precision;
+
+    // The low index bits dropped by the coarser sketch become the leading
+    // bits of the hash rest it ranks: a non-zero prefix sets the rank on
+    // its own, an all-zero one extends the old rank
+    for (size_t i = 0; i < registers_.size(); i++) {
+        if (registers_[i] == 0) {
+            continue;
+        }
+        uint64_t dropped = i & ((uint64_t{1} << shift) - 1);
+        uint8_t rank = dropped != 0
+            ? static_cast<uint8_t>(std::countl_zero(dropped) - (64 - static_cast<int>(shift)) + 1)
+            : static_cast<uint8_t>(shift + registers_[i]);
+        uint8_t& reg = reduced.registers_[i >> shift];
+        reg = std::max(reg, rank);
+    }
+    return reduced;
+}
+
+double HyperLogLog::estimate() const {
+    double m = static_cast<double>(registers_.size());
+    double alpha;
+    switch (precision_) {
+    case 4: alpha = 0.673; break;
+    case 5: alpha = 0.697; break;
+    case 6: alpha = 0.709; break;
+    default: alpha = 0.7213 / (1.0 + 1.079 / m); break;
+    }
+
+    double inverse_sum = 0.0;
+    size_t zeros = 0;
+    for (uint8_t reg : registers_) {
+        inverse_sum += std::ldexp(1.0, -static_cast<int>(reg));
+        zeros += reg == 0 ? 1 : 0;
+    }
+
+    // Small cardinalities: linear counting over the empty registers is
+    // more accurate than the raw estimate. 64-bit hashes need no
+    // large-range correction.
+    double raw = alpha * m * m / inverse_sum;
+    if (raw <= 2.5 * m && zeros > 0) {
+        return m * std::log(m / static_cast<double>(zeros));
+    }
+    return raw;
+}
+
+std::vector<uint8_t> HyperLogLog::serialize() const {
+    std::vector<uint8_t> out;
+    out.reserve(1 + registers_.size());
+    out.push_back(static_cast<uint8_t>(precision_));
+    out.insert(out.end(), registers_.begin(), registers_.end());
+    return out;
+}
+
+HyperLogLog HyperLogLog::deserialize(const uint8_t* data, size_t size) {
+    if (size < 1) {
+        throw std::runtime_error("Truncated HyperLogLog sketch");
+    }
+    HyperLogLog sketch(data[0]);
+    if (size != 1 + sketch.registers_.size()) {
+        throw std::runtime_error("HyperLogLog sketch size does not match its precision");
+    }
+    std::copy(data + 1, data + size, sketch.registers_.begin());
+
+    uint8_t max_rank = static_cast<uint8_t>(64 - sketch.precision_ + 1);
+    for (uint8_t reg : sketch.registers_) {
+        if (reg > max_rank) {
+            throw std::runtime_error("Corrupted HyperLogLog register");
+        }
+    }
+    return sketch;
+}
+
+// BloomFilter
+BloomFilter::BloomFilter(size_t num_keys, double bits_per_key) {
+    double bits = std::max(static_cast<double>(num_keys) * bits_per_key, 1.0);
+    size_t num_blocks = static_cast<size_t>(std::ceil(bits / (32.0 * WORDS_PER_BLOCK)));
+    if (num_blocks > UINT32_MAX) {
+        throw std::runtime_error("Bloom filter too large");
+    }
+    words_.assign(num_blocks * WORDS_PER_BLOCK, 0);
+}
+
+double BloomFilter::bitsPerKey(double false_positive_rate) {
+    if (!(false_positive_rate > 0.0 && false_positive_rate < 1.0)) {
+        throw std::runtime_error("Bloom filter false positive rate must be in (0, 1)");
+    }
+    // A key is a false positive when all eight of its bits are set, each
+    // word being about as full as a standard filter with one hash
+    return -static_cast<double>(WORDS_PER_BLOCK) / std::log(1.0 - std::pow(false_positive_rate, 1.0 / WORDS_PER_BLOCK));
+}
+
+std::vector<uint8_t> BloomFilter::serialize() const {
+    std::vector<uint8_t> out;
+    out.reserve(words_.size() * sizeof(uint32_t));
+    for (uint32_t word : words_) {
+        for (size_t byte = 0; byte < sizeof(uint32_t); byte++) {
+            out.push_back(static_cast<uint8_t>(word >> (8 * byte)));
+        }
+    }
+    return out;
+}
+
+BloomFilter BloomFilter::deserialize(const uint8_t* data, size_t size) {
+    constexpr size_t BLOCK_BYTES = WORDS_PER_BLOCK * sizeof(uint32_t);
+    if (size == 0 || size % BLOCK_BYTES != 0 || size / BLOCK_BYTES > UINT32_MAX) {
+        throw std::runtime_error("Bloom filter size is not a whole number of blocks");
+    }
+
+    BloomFilter filter;
+    filter.words_.resize(size / sizeof(uint32_t));
+    for (size_t i = 0; i < filter.words_.size(); i++) {
+        uint32_t word = 0;
+        for (size_t byte = 0; byte < sizeof(uint32_t); byte++) {
+            word |= static_cast<uint32_t>(data[i * sizeof(uint32_t) + byte]) << (8 * byte);
+        }
+        filter.words_[i] = word;
+    }
+    return filter;
+}
+
+} // namespace columnar
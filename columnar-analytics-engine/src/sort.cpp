@@ -0,0 +1,198 @@
+// Columnar Analytics Engine
+// Author: RIAL Fares
+// Sorting primitives implementation
+
+#include "sort.h"
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+namespace columnar {
+
+namespace {
+
+// The row store is compacted once it holds at least this many rows, most
+// of them evicted
+constexpr size_t COMPACT_MIN_ROWS = 4096;
+
+void appendRows(Batch::ColumnData& out, const Batch::ColumnData& in, const std::vector<uint32_t>& rows) {
+    std::visit([&](auto& dst) {
+        const auto& src = std::get<std::decay_t<decltype(dst)>>(in);
+        for (uint32_t row : rows) {
+            dst.push_back(src[row]);
+        }
+    }, out);
+}
+
+Batch::ColumnData emptyLike(const Batch::ColumnData& col) {
+    return std::visit([](const auto& vals) -> Batch::ColumnData {
+        return std::decay_t<decltype(vals)>{};
+    }, col);
+}
+
+} // namespace
+
+void radixSortRows(const std::vector<uint64_t>& keys, std::vector<uint32_t>& rows) {
+    size_t n = keys.size();
+    rows.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        rows[i] = static_cast<uint32_t>(i);
+    }
+    if (n < 2) {
+        return;
+    }
+
+    // All eight byte histograms in one pass over the keys
+    std::vector<size_t> counts(8 * 256, 0);
+    for (uint64_t key : keys) {
+        for (unsigned b = 0; b < 8; b++) {
+            counts[b * 256 + ((key >> (8 * b)) & 0xFF)]++;
+        }
+    }
+
+    std::vector<uint32_t> scratch(n);
+    for (unsigned b = 0; b < 8; b++) {
+        size_t* count = counts.data() + b * 256;
+        if (count[(keys[0] >> (8 * b)) & 0xFF] == n) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (size_t digit = 0; digit < 256; digit++) {
+            size_t c = count[digit];
+            count[digit] = offset;
+            offset += c;
+        }
+        for (uint32_t row : rows) {
+            scratch[count[(keys[row] >> (8 * b)) & 0xFF]++] = row;
+        }
+        rows.swap(scratch);
+    }
+}
+
+template<typename Key>
+TopN<Key>::TopN(size_t n, SortOrder<Key> order)
+    : n_(n), order_(order) {
+    heap_.reserve(std::min(n_, COMPACT_MIN_ROWS));
+}
+
+template<typename Key>
+bool TopN<Key>::admits(const Key& key, uint64_t position) const {
+    if (n_ == 0) {
+        return false;
+    }
+    if (!full()) {
+        return true;
+    }
+    return order_.before(key, position, heap_.front().key, heap_.front().position);
+}
+
+template<typename Key>
+void TopN<Key>::offer(Key key, uint64_t position, std::vector<uint32_t>& sel, uint32_t batch_row) {
+    auto cmp = [this](const Entry& a, const Entry& b) { return entryBefore(a, b); };
+    Entry entry{std::move(key), position, static_cast<uint32_t>(store_rows_ + sel.size())};
+    sel.push_back(batch_row);
+
+    if (!full()) {
+        heap_.push_back(std::move(entry));
+        std::push_heap(heap_.begin(), heap_.end(), cmp);
+        return;
+    }
+    std::pop_heap(heap_.begin(), heap_.end(), cmp);
+    heap_.back() = std::move(entry);
+    std::push_heap(heap_.begin(), heap_.end(), cmp);
+}
+
+template<typename Key>
+void TopN<Key>::add(const Batch& batch, size_t key_column, uint64_t first_position) {
+    if (n_ == 0 || batch.num_rows == 0) {
+        return;
+    }
+    if (store_.empty()) {
+        for (const auto& col : batch.columns) {
+            store_.push_back(emptyLike(col));
+        }
+        column_names_ = batch.column_names;
+    }
+
+    // Rows are tested against the last row kept before anything is copied:
+    // once the heap is full, most rows of most batches are rejected here
+    std::vector<uint32_t> sel;
+    std::visit([&](const auto& vals) {
+        using T = typename std::decay_t<decltype(vals)>::value_type;
+        if constexpr (std::is_same_v<T, std::string> != std::is_same_v<Key, std::string>) {
+            throw std::runtime_error("ORDER BY key column type mismatch");
+        } else {
+            for (size_t i = 0; i < vals.size(); i++) {
+                uint64_t position = first_position + i;
+                if (!full() || order_.before(vals[i], position, heap_.front().key, heap_.front().position)) {
+                    offer(Key(vals[i]), position, sel, static_cast<uint32_t>(i));
+                }
+            }
+        }
+    }, batch.columns[key_column]);
+
+    if (sel.empty()) {
+        return;
+    }
+    for (size_t c = 0; c < store_.size(); c++) {
+        appendRows(store_[c], batch.columns[c], sel);
+    }
+    store_rows_ += sel.size();
+
+    if (store_rows_ >= COMPACT_MIN_ROWS && store_rows_ - heap_.size() > heap_.size()) {
+        compact();
+    }
+}
+
+template<typename Key>
+void TopN<Key>::compact() {
+    std::vector<uint32_t> live;
+    live.reserve(heap_.size());
+    for (auto& entry : heap_) {
+        live.push_back(entry.row);
+        entry.row = static_cast<uint32_t>(live.size() - 1);
+    }
+
+    for (auto& col : store_) {
+        Batch::ColumnData kept = emptyLike(col);
+        appendRows(kept, col, live);
+        col = std::move(kept);
+    }
+    store_rows_ = live.size();
+}
+
+template<typename Key>
+std::vector<Batch> TopN<Key>::finish(size_t offset, size_t batch_size) {
+    std::sort(heap_.begin(), heap_.end(), [this](const Entry& a, const Entry& b) { return entryBefore(a, b); });
+
+    std::vector<Batch> out;
+    batch_size = std::max<size_t>(batch_size, 1);
+    for (size_t begin = offset; begin < heap_.size(); begin += batch_size) {
+        size_t end = std::min(begin + batch_size, heap_.size());
+        std::vector<uint32_t> rows;
+        rows.reserve(end - begin);
+        for (size_t i = begin; i < end; i++) {
+            rows.push_back(heap_[i].row);
+        }
+
+        Batch batch;
+        batch.column_names = column_names_;
+        batch.num_rows = rows.size();
+        for (const auto& col : store_) {
+            batch.columns.push_back(emptyLike(col));
+            appendRows(batch.columns.back(), col, rows);
+        }
+        out.push_back(std::move(batch));
+    }
+
+    heap_.clear();
+    store_.clear();
+    store_rows_ = 0;
+    return out;
+}
+
+template class TopN<int64_t>;
+template class TopN<std::string>;
+
+} // namespace columnar
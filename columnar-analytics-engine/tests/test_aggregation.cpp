@@ -0,0 +1,298 @@
+// Columnar Analytics Engine
+// Author: RIAL Fares
+// Tests for hash aggregation primitives
+
+#include "aggregation.h"
+#include <cassert>
+#include <climits>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+using namespace columnar;
+
+void test_hash_bytes() {
+    std::string a = "region_north";
+    std::string b = "region_north";
+    std::string c = "region_south";
+
+    assert(hashBytes(a.data(), a.size()) == hashBytes(b.data(), b.size()));
+    assert(hashBytes(a.data(), a.size()) != hashBytes(c.data(), c.size()));
+    assert(hashBytes("", 0) != hashBytes("\0", 1));
+
+    std::cout << "test_hash_bytes: PASS\n";
+}
+
+void test_string_group_table() {
+    StringGroupTable table;
+    std::vector<uint32_t> group_ids;
+
+    std::vector<std::string> keys = {"b", "a", "b", "", "a", ""};
+    table.findOrInsert(keys, group_ids);
+
+    assert(table.size() == 3);
+    assert((group_ids == std::vector<uint32_t>{0, 1, 0, 2, 1, 2}));
+    assert(table.key(0) == "b");
+    assert(table.key(1) == "a");
+    assert(table.key(2).empty());
+
+    std::cout << "test_string_group_table: PASS\n";
+}
+
+void test_string_group_table_growth() {
+    StringGroupTable table;
+    std::vector<uint32_t> group_ids;
+    std::unordered_map<std::string, uint32_t> expected;
+
+    // Many distinct keys force repeated rehashing across batches
+    for (int batch = 0; batch < 10; batch++) {
+        std::vector<std::string> keys;
+        for (int i = 0; i < 10000; i++) {
+            keys.push_back("key_" + std::to_string((i * 7919 + batch * 104729) % 50000));
+        }
+
+        table.findOrInsert(keys, group_ids);
+        for (size_t i = 0; i < keys.size(); i++) {
+            auto it = expected.find(keys[i]);
+            if (it == expected.end()) {
+                expected.emplace(keys[i], group_ids[i]);
+            } else {
+                assert(it->second == group_ids[i]);
+            }
+            assert(table.key(group_ids[i]) == keys[i]);
+        }
+    }
+
+    assert(table.size() == expected.size());
+
+    std::cout << "test_string_group_table_growth: PASS\n";
+}
+
+void test_int_group_table() {
+    IntGroupTable table;
+    std::vector<uint32_t> group_ids;
+
+    std::vector<int64_t> keys = {42, -7, 42, 0, -7, INT64_MIN};
+    table.findOrInsert(keys, group_ids);
+
+    assert(table.size() == 4);
+    assert((group_ids == std::vector<uint32_t>{0, 1, 0, 2, 1, 3}));
+    assert(table.key(1) == -7);
+    assert(table.key(3) == INT64_MIN);
+
+    // INT32 keys share the table with INT64 keys of the same value
+    std::vector<int32_t> narrow = {0, 42, 5};
+    table.findOrInsert(narrow, group_ids);
+    assert((group_ids == std::vector<uint32_t>{2, 0, 4}));
+
+    std::cout << "test_int_group_table: PASS\n";
+}
+
+void test_key_set() {
+    KeySet keys({30, 10, 20, 10, -5, INT64_MAX});
+    assert(keys.size() == 5);
+    assert(keys.contains(10) && keys.contains(-5) && keys.contains(INT64_MAX));
+    assert(!keys.contains(0) && !keys.contains(15));
+
+    // Selection from a range, then narrowing an existing selection
+    std::vector<int32_t> vals = {5, 10, 20, 25, 30, 10, -5};
+    std::vector<uint32_t> sel;
+    keys.select(vals, 1, 7, true, sel);
+    assert((sel == std::vector<uint32_t>{1, 2, 4, 5, 6}));
+
+    std::vector<int64_t> wide = {0, 10, 0, 0, 30, 0, 0};
+    keys.select(wide, 0, 0, false, sel);
+    assert((sel == std::vector<uint32_t>{1, 4}));
+
+    assert(keys.intersects(11, 20));
+    assert(!keys.intersects(11, 19));
+    assert(keys.intersects(INT64_MAX, INT64_MAX));
+    assert(keys.covers(10, 10));
+    assert(!keys.covers(10, 20));
+    assert(KeySet({1, 2, 3, 4}).covers(1, 4));
+    assert(!KeySet({}).intersects(INT64_MIN, INT64_MAX));
+
+    std::cout << "test_key_set: PASS\n";
+}
+
+void test_direct_group_table() {
+    DirectGroupTable table(-3, 8);
+    std::vector<uint32_t> group_ids;
+
+    std::vector<int32_t> keys = {-3, 4, 0, -3};
+    table.findOrInsert(keys, group_ids);
+
+    assert(table.size() == 8);
+    assert((group_ids == std::vector<uint32_t>{0, 7, 3, 0}));
+    assert(table.key(7) == 4);
+
+    bool threw = false;
+    try {
+        std::vector<int32_t> outside = {5};
+        table.findOrInsert(outside, group_ids);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    (void)threw;
+
+    std::cout << "test_direct_group_table: PASS\n";
+}
+
+void test_packed_group_table() {
+    PackedGroupTable table(2);
+    std::vector<uint32_t> group_ids;
+
+    // Keys differing only in their second word are distinct groups
+    std::vector<uint64_t> keys = {1, 7, 1, 8, 1, 7, 0, 0};
+    table.findOrInsert(keys, 4, group_ids);
+
+    assert(table.size() == 3);
+    assert((group_ids == std::vector<uint32_t>{0, 1, 0, 2}));
+    assert(table.key(1)[0] == 1 && table.key(1)[1] == 8);
+
+    // Growth keeps ids stable
+    std::vector<uint64_t> many;
+    for (uint64_t i = 0; i < 5000; i++) {
+        many.push_back(i % 3);
+        many.push_back(i);
+    }
+    table.findOrInsert(many, 5000, group_ids);
+    assert(group_ids[0] == 2 && group_ids[7] == 0);
+    assert(table.size() == 3 + 4998);
+
+    std::cout << "test_packed_group_table: PASS\n";
+}
+
+void test_group_agg_states() {
+    GroupAggStates states;
+    states.resize(2);
+
+    std::vector<uint32_t> group_ids = {0, 1, 0, 0};
+    std::vector<int32_t> values = {5, -2, 7, 1};
+    states.update(group_ids, values);
+
+    AggResult g0 = states.result(0, AggFunc::SUM);
+    assert(g0.count == 3 && g0.sum == 13);
+    assert(g0.min.value() == 1 && g0.max.value() == 7);
+    (void)g0;
+
+    AggResult g1 = states.result(1, AggFunc::COUNT);
+    assert(g1.count == 1 && !g1.min.has_value());
+    (void)g1;
+
+    std::cout << "test_group_agg_states: PASS\n";
+}
+
+void test_sum_overflow_tracking() {
+    int64_t sum = 0;
+    int64_t wraps = 0;
+    addWrapping(sum, wraps, INT64_MAX);
+    addWrapping(sum, wraps, 10);
+    assert(wraps == 1);
+    assert(!wrappedSum(sum, wraps).fitsInt64());
+
+    // Back into range: the wrapped sum is exact again
+    addWrapping(sum, wraps, -20);
+    assert(wraps == 0 && sum == INT64_MAX - 10);
+
+    addWrapping(sum, wraps, INT64_MIN);
+    addWrapping(sum, wraps, INT64_MIN);
+    assert(wraps == -1);
+
+    GroupAggStates states;
+    states.resize(1);
+    std::vector<uint32_t> group_ids = {0, 0};
+    std::vector<int64_t> values = {INT64_MAX, 1};
+    states.update(group_ids, values);
+    assert(!states.sumFitsInt64(0));
+
+    // AVG stays exact past the int64 range
+    AggResult avg = states.result(0, AggFunc::AVG);
+    assert(avg.value.value() == 4611686018427387904.0);
+    (void)avg;
+
+    std::cout << "test_sum_overflow_tracking: PASS\n";
+}
+
+void test_moments_merge() {
+    // Values far from zero, on either side: naive sum-of-squares loses all
+    // precision here
+    for (int64_t sign : {1, -1}) {
+        std::vector<int64_t> values;
+        for (int64_t i = 0; i < 1000; i++) {
+            values.push_back(sign * (1000000000000LL + (i % 10)));
+        }
+
+        GroupAggStates whole;
+        whole.moments = true;
+        whole.resize(1);
+        whole.updateMoments(std::vector<uint32_t>(values.size(), 0), values);
+
+        // Same values split over two partials, merged
+        GroupAggStates left;
+        GroupAggStates right;
+        left.moments = right.moments = true;
+        left.resize(1);
+        right.resize(1);
+        std::vector<int64_t> first(values.begin(), values.begin() + 300);
+        std::vector<int64_t> second(values.begin() + 300, values.end());
+        left.updateMoments(std::vector<uint32_t>(first.size(), 0), first);
+        right.updateMoments(std::vector<uint32_t>(second.size(), 0), second);
+        left.mergeGroup(right, 0, 0);
+
+        // Population variance of 0..9 repeated is 8.25
+        double var_whole = whole.result(0, AggFunc::VAR_POP).value.value();
+        double var_merged = left.result(0, AggFunc::VAR_POP).value.value();
+        assert(std::abs(var_whole - 8.25) < 1e-4);
+        assert(std::abs(var_merged - 8.25) < 1e-4);
+        assert(left.result(0, AggFunc::VAR_POP).count == 1000);
+
+        double stddev = left.result(0, AggFunc::STDDEV).value.value();
+        assert(std::abs(stddev - std::sqrt(8.25 * 1000 / 999)) < 1e-4);
+        (void)var_whole;
+        (void)var_merged;
+        (void)stddev;
+
+        GroupAggStates sums;
+        sums.resize(1);
+        sums.update(std::vector<uint32_t>(values.size(), 0), values);
+        assert(sums.result(0, AggFunc::AVG).value.value() == static_cast<double>(sign) * (1000000000000.0 + 4.5));
+    }
+
+    // A small negative sum converts exactly
+    GroupAggStates negative;
+    negative.resize(1);
+    negative.update(std::vector<uint32_t>{0, 0}, std::vector<int32_t>{-1, -2});
+    assert(negative.result(0, AggFunc::AVG).value.value() == -1.5);
+
+    // Sample variants need two values
+    GroupAggStates single;
+    single.moments = true;
+    single.resize(1);
+    single.updateMoments(std::vector<uint32_t>{0}, std::vector<int32_t>{5});
+    assert(single.result(0, AggFunc::VAR_POP).value.value() == 0.0);
+    assert(!single.result(0, AggFunc::VAR_SAMP).value.has_value());
+
+    std::cout << "test_moments_merge: PASS\n";
+}
+
+int main() {
+    std::cout << "Running aggregation tests...\n";
+
+    test_hash_bytes();
+    test_string_group_table();
+    test_string_group_table_growth();
+    test_int_group_table();
+    test_key_set();
+    test_direct_group_table();
+    test_packed_group_table();
+    test_group_agg_states();
+    test_sum_overflow_tracking();
+    test_moments_merge();
+
+    std::cout << "\nAll aggregation tests passed.\n";
+    return 0;
+}
@@ -5,6 +5,7 @@
 #include "encoding.h"
 #include <cassert>
 #include <iostream>
+#include <limits>
 #include <vector>
 
 using namespace columnar;
@@ -83,6 +84,21 @@ void test_delta_int64() {
     std::cout << "test_delta_int64: PASS\n";
 }
 
+void test_delta_wraparound() {
+    // Deltas between extreme values wrap; decoding must restore them exactly
+    std::vector<int32_t> values32 = {std::numeric_limits<int32_t>::max(), -5, std::numeric_limits<int32_t>::min(),
+                                     std::numeric_limits<int32_t>::max()};
+    auto encoded = DeltaEncoder::encodeInt32(values32);
+    assert(DeltaEncoder::decodeInt32(encoded.data(), encoded.size(), values32.size()) == values32);
+
+    std::vector<int64_t> values64 = {std::numeric_limits<int64_t>::max() - 1, std::numeric_limits<int64_t>::max() - 1,
+                                     -5, std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max()};
+    encoded = DeltaEncoder::encodeInt64(values64);
+    assert(DeltaEncoder::decodeInt64(encoded.data(), encoded.size(), values64.size()) == values64);
+
+    std::cout << "test_delta_wraparound: PASS\n";
+}
+
 void test_dictionary_encoding() {
     std::vector<std::string> values = {"apple", "banana", "apple", "cherry", "banana", "apple"};
 
@@ -119,6 +135,7 @@ int main() {
     test_rle_int64();
     test_delta_int32();
     test_delta_int64();
+    test_delta_wraparound();
     test_dictionary_encoding();
     test_dictionary_high_cardinality();
 
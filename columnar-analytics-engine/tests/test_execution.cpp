@@ -4,10 +4,17 @@
 
 #include "format.h"
 #include "execution.h"
+#include "sketch.h"
+#include <algorithm>
 #include <cassert>
+#include <climits>
+#include <cmath>
 #include <iostream>
 #include <filesystem>
+#include <limits>
 #include <memory>
+#include <random>
+#include <tuple>
 
 using namespace columnar;
 
@@ -39,6 +46,53 @@ void createTestFile() {
     writer.close();
 }
 
+// Three row groups of four rows: id 0..11, value = id * 10
+void createMultiRowGroupFile() {
+    Schema schema;
+    schema.columns = {
+        {"id", ColumnType::INT64, EncodingType::PLAIN},
+        {"value", ColumnType::INT32, EncodingType::PLAIN}
+    };
+
+    FileWriter writer(TEST_FILE, schema);
+
+    for (int64_t rg = 0; rg < 3; rg++) {
+        std::vector<int64_t> ids;
+        std::vector<int32_t> values;
+        for (int64_t i = rg * 4; i < rg * 4 + 4; i++) {
+            ids.push_back(i);
+            values.push_back(static_cast<int32_t>(i * 10));
+        }
+        writer.writeInt64Column(0, ids);
+        writer.writeInt32Column(1, values);
+        writer.flushRowGroup();
+    }
+    writer.close();
+}
+
+std::vector<int64_t> collectIds(ResultStream& stream) {
+    std::vector<int64_t> ids;
+    while (stream.hasNext()) {
+        Batch batch = stream.next();
+        for (int64_t id : batch.getColumn<int64_t>(batch.columnIndex("id"))) {
+            ids.push_back(id);
+        }
+    }
+    return ids;
+}
+
+// Ids 0..num_rows-1 for which passes(id) holds, in order
+template<typename Pred>
+std::vector<int64_t> expectedIds(int64_t num_rows, Pred passes) {
+    std::vector<int64_t> ids;
+    for (int64_t id = 0; id < num_rows; id++) {
+        if (passes(id)) {
+            ids.push_back(id);
+        }
+    }
+    return ids;
+}
+
 void test_predicate_evaluation() {
     Predicate pred{"value", CompareOp::GT, 150};
 
@@ -113,6 +167,689 @@ void test_scanner_with_filter() {
     std::cout << "test_scanner_with_filter: PASS\n";
 }
 
+void test_in_predicate() {
+    cleanup();
+    createMultiRowGroupFile();
+    auto reader = std::make_shared<FileReader>(TEST_FILE);
+
+    // Keys 1, 2 and 3 fill the first row group's stats range [0, 3] only
+    // partly; the second row group [4, 7] holds none
+    Predicate in = Predicate::in("id", {3, 11, 1, 2, 9, 100});
+    assert(in.evaluate(int64_t{11}) && !in.evaluate(int32_t{4}));
+
+    const auto& row_groups = reader->metadata().row_groups;
+    assert(in.matchStats(row_groups[0].column_chunks[0].page_headers[0].stats) == StatsMatch::MAYBE);
+    assert(in.matchStats(row_groups[1].column_chunks[0].page_headers[0].stats) == StatsMatch::NEVER);
+    assert(Predicate::in("id", {4, 5, 6, 7}).matchStats(row_groups[1].column_chunks[0].page_headers[0].stats) ==
+           StatsMatch::ALWAYS);
+    (void)row_groups;
+
+    Scanner scanner(reader, {"id"}, 2);
+    scanner.addFilter(in);
+    scanner.addFilter(Predicate{"value", CompareOp::GE, 20});
+    std::vector<int64_t> ids;
+    std::vector<size_t> row_groups_read;
+    while (scanner.hasNext()) {
+        Batch batch = scanner.next();
+        const auto& batch_ids = batch.getColumn<int64_t>(0);
+        ids.insert(ids.end(), batch_ids.begin(), batch_ids.end());
+        row_groups_read.push_back(scanner.currentRowGroup());
+    }
+    assert((ids == std::vector<int64_t>{2, 3, 9, 11}));
+    assert(std::find(row_groups_read.begin(), row_groups_read.end(), 1) == row_groups_read.end());
+
+    // As an aggregate filter, with row groups answered from stats
+    QueryExecutor executor(reader);
+    executor.addFilter(Predicate::in("id", {4, 5, 6, 7, 8}));
+    executor.setAggregation(AggFunc::SUM, "value");
+    auto result = executor.executeAggregate();
+    assert(result.count == 5);
+    assert(result.sum == 300);
+
+    cleanup();
+    std::cout << "test_in_predicate: PASS\n";
+}
+
+void test_filter_expressions() {
+    cleanup();
+    createMultiRowGroupFile();
+    auto reader = std::make_shared<FileReader>(TEST_FILE);
+
+    // Three-valued verdicts against the row groups [0, 3], [4, 7], [8, 11]
+    const auto& row_groups = reader->metadata().row_groups;
+    auto verdicts = [&](const FilterExpr& expr) {
+        std::vector<StatsMatch> matches;
+        for (const auto& rg : row_groups) {
+            matches.push_back(expr.matchStats([&](const std::string& column) {
+                return &rg.column_chunks[reader->schema().columnIndex(column)].page_headers[0].stats;
+            }));
+        }
+        return matches;
+    };
+    FilterExpr ranges = FilterExpr::anyOf({Predicate{"id", CompareOp::LE, 1}, FilterExpr::between("id", 10, 20)});
+    assert((verdicts(ranges) == std::vector<StatsMatch>{StatsMatch::MAYBE, StatsMatch::NEVER, StatsMatch::MAYBE}));
+    assert((verdicts(FilterExpr::negate(FilterExpr::between("id", 4, 7))) ==
+            std::vector<StatsMatch>{StatsMatch::ALWAYS, StatsMatch::NEVER, StatsMatch::ALWAYS}));
+    assert((verdicts(FilterExpr::allOf({Predicate{"id", CompareOp::GE, 4}, Predicate{"value", CompareOp::LT, 80}})) ==
+            std::vector<StatsMatch>{StatsMatch::NEVER, StatsMatch::ALWAYS, StatsMatch::NEVER}));
+    (void)verdicts;
+
+    // OR of ranges, ANDed with a plain predicate; the middle row group is
+    // never read
+    Scanner scanner(reader, {"id"}, 3);
+    scanner.addFilter(FilterExpr::anyOf({FilterExpr::between("id", 1, 2), FilterExpr::between("id", 9, 10)}));
+    scanner.addFilter(Predicate{"value", CompareOp::GE, 20});
+    std::vector<int64_t> ids;
+    std::vector<size_t> row_groups_read;
+    while (scanner.hasNext()) {
+        Batch batch = scanner.next();
+        const auto& batch_ids = batch.getColumn<int64_t>(0);
+        ids.insert(ids.end(), batch_ids.begin(), batch_ids.end());
+        row_groups_read.push_back(scanner.currentRowGroup());
+    }
+    assert((ids == std::vector<int64_t>{2, 9, 10}));
+    assert(std::find(row_groups_read.begin(), row_groups_read.end(), 1) == row_groups_read.end());
+
+    // IN inside an OR, through the executor
+    QueryExecutor query(reader);
+    query.setProjection({"id"});
+    query.addFilter(FilterExpr::anyOf({Predicate::in("id", {5, 6}), Predicate{"value", CompareOp::GT, 100}}));
+    ResultStream stream = query.executeStream();
+    assert((collectIds(stream) == std::vector<int64_t>{5, 6, 11}));
+
+    // NOT as an aggregate filter: the first two row groups are skipped and
+    // the last one is answered from stats
+    QueryExecutor executor(reader);
+    executor.addFilter(FilterExpr::negate(FilterExpr::between("id", 0, 7)));
+    executor.setAggregation(AggFunc::SUM, "value");
+    auto result = executor.executeAggregate();
+    assert(result.count == 4);
+    assert(result.sum == 380);
+
+    // Bitmaps over several words, with a partial last word
+    Batch::ColumnData values = std::vector<int64_t>(150);
+    auto& vals = std::get<std::vector<int64_t>>(values);
+    for (size_t i = 0; i < vals.size(); i++) {
+        vals[i] = static_cast<int64_t>(i);
+    }
+    FilterExpr outside = FilterExpr::negate(
+        FilterExpr::anyOf({FilterExpr::between("x", 10, 69), Predicate{"x", CompareOp::GE, 140}}));
+    std::vector<uint64_t> bits;
+    outside.evaluate([&](const std::string&) -> const Batch::ColumnData& { return values; }, 5, 150, bits);
+    assert(bits.size() == 3);
+    size_t passed = 0;
+    for (size_t i = 0; i < 145; i++) {
+        bool bit = ((bits[i / 64] >> (i % 64)) & 1) != 0;
+        int64_t v = static_cast<int64_t>(i + 5);
+        assert(bit == ((v < 10 || v > 69) && v < 140));
+        passed += bit ? 1 : 0;
+        (void)v;
+    }
+    assert(passed == 5 + 70);
+    assert((bits[2] >> (145 % 64)) == 0);
+    (void)passed;
+
+    // String columns are not supported in expressions
+    cleanup();
+    createTestFile();
+    auto strings = std::make_shared<FileReader>(TEST_FILE);
+    Scanner string_scanner(strings, {"id"});
+    bool threw = false;
+    try {
+        string_scanner.addFilter(FilterExpr::negate(Predicate{"category", CompareOp::EQ, 0}));
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    (void)threw;
+
+    cleanup();
+    std::cout << "test_filter_expressions: PASS\n";
+}
+
+// Three row groups of ten rows: id 0..29, status by row group (active and
+// pending; closed; active and closed), name = "n<id>" (plain encoded)
+void createStatusFile() {
+    Schema schema;
+    schema.columns = {
+        {"id", ColumnType::INT64, EncodingType::PLAIN},
+        {"status", ColumnType::STRING, EncodingType::DICTIONARY},
+        {"name", ColumnType::STRING, EncodingType::PLAIN}
+    };
+
+    FileWriter writer(TEST_FILE, schema);
+    for (int64_t rg = 0; rg < 3; rg++) {
+        std::vector<int64_t> ids;
+        std::vector<std::string> statuses;
+        std::vector<std::string> names;
+        for (int64_t id = rg * 10; id < rg * 10 + 10; id++) {
+            ids.push_back(id);
+            if (rg == 0) {
+                statuses.push_back(id % 2 == 0 ? "active" : "pending");
+            } else if (rg == 1) {
+                statuses.push_back("closed");
+            } else {
+                statuses.push_back(id % 3 == 0 ? "active" : "closed");
+            }
+            names.push_back("n" + std::to_string(id));
+        }
+        writer.writeInt64Column(0, ids);
+        writer.writeStringColumn(1, statuses);
+        writer.writeStringColumn(2, names);
+        writer.flushRowGroup();
+    }
+    writer.close();
+}
+
+void test_string_predicates() {
+    Predicate eq = Predicate::compareString("status", CompareOp::EQ, "active");
+    Predicate lt = Predicate::compareString("status", CompareOp::LT, "b");
+    Predicate in = Predicate::inStrings("status", {"pending", "closed", "pending"});
+    Predicate prefix = Predicate::startsWith("name", "n1");
+    assert(eq.evaluate("active") && !eq.evaluate("activ"));
+    assert(lt.evaluate("active") && !lt.evaluate("closed"));
+    assert(in.evaluate("closed") && !in.evaluate("active") && in.strings->size() == 2);
+    assert(prefix.evaluate("n1") && prefix.evaluate("n17") && !prefix.evaluate("n2"));
+
+    cleanup();
+    createStatusFile();
+    auto reader = std::make_shared<FileReader>(TEST_FILE);
+
+    // No entry of the first row group's dictionary matches: it is skipped
+    // without reading its other columns. The filtered column is decoded
+    // for the matching rows only.
+    Scanner scanner(reader, {"id", "status"}, 4);
+    scanner.addFilter(Predicate::compareString("status", CompareOp::EQ, "closed"));
+    std::vector<int64_t> ids;
+    std::vector<size_t> row_groups_read;
+    while (scanner.hasNext()) {
+        Batch batch = scanner.next();
+        const auto& batch_ids = batch.getColumn<int64_t>(0);
+        const auto& statuses = batch.getColumn<std::string>(1);
+        for (size_t i = 0; i < batch.num_rows; i++) {
+            assert(statuses[i] == "closed");
+            ids.push_back(batch_ids[i]);
+        }
+        (void)statuses;
+        row_groups_read.push_back(scanner.currentRowGroup());
+    }
+    assert(ids.size() == 10 + 7);
+    assert(ids.front() == 10 && ids.back() == 29);
+    assert(std::find(row_groups_read.begin(), row_groups_read.end(), 0) == row_groups_read.end());
+
+    // Prefix on a plain column, combined with a dictionary filter delivered
+    // as codes
+    Scanner codes(reader, {"id", "status"});
+    codes.setDictionaryCodes("status");
+    codes.addFilter(Predicate::startsWith("name", "n2"));
+    codes.addFilter(Predicate::inStrings("status", {"active"}));
+    ids.clear();
+    while (codes.hasNext()) {
+        Batch batch = codes.next();
+        const auto* dictionary = batch.dictionary(1);
+        assert(dictionary != nullptr);
+        for (size_t i = 0; i < batch.num_rows; i++) {
+            assert((*dictionary)[static_cast<size_t>(batch.getColumn<int32_t>(1)[i])] == "active");
+            ids.push_back(batch.getColumn<int64_t>(0)[i]);
+        }
+        (void)dictionary;
+    }
+    assert((ids == std::vector<int64_t>{2, 21, 24, 27}));
+
+    // Query and aggregate filters, with GROUP BY reading codes
+    QueryExecutor executor(reader);
+    executor.addFilter(Predicate::compareString("status", CompareOp::NE, "pending"));
+    executor.setGroupBy("status");
+    executor.addAggregation(AggFunc::COUNT, "id");
+    executor.addAggregation(AggFunc::SUM, "id", {Predicate::startsWith("name", "n1")});
+    auto groups = executor.executeGroupByAggregates();
+    assert(groups.size() == 2);
+    assert(groups[0].keys[0] == "active" && groups[0].aggs[0].count == 5 + 3);
+    assert(groups[1].keys[0] == "closed" && groups[1].aggs[0].count == 10 + 7);
+    assert(groups[0].aggs[1].count == 0 && groups[1].aggs[1].sum == 145);
+
+    // OR over string predicates, tested on codes of the dictionary column
+    // and on strings of the plain one. Row group 1 (all closed, names
+    // n10-n19) is ruled out by its stats.
+    FilterExpr either = FilterExpr::anyOf(
+        {Predicate::compareString("status", CompareOp::EQ, "pending"),
+         FilterExpr::allOf({Predicate::startsWith("name", "n2"),
+                            FilterExpr::negate(Predicate::compareString("status", CompareOp::EQ, "closed"))})});
+    Scanner any_of(reader, {"id", "status"}, 4);
+    any_of.addFilter(either);
+    ids.clear();
+    row_groups_read.clear();
+    while (any_of.hasNext()) {
+        Batch batch = any_of.next();
+        for (size_t i = 0; i < batch.num_rows; i++) {
+            int64_t id = batch.getColumn<int64_t>(0)[i];
+            assert(batch.getColumn<std::string>(1)[i] == (id < 10 && id % 2 == 1 ? "pending" : "active"));
+            ids.push_back(id);
+        }
+        row_groups_read.push_back(any_of.currentRowGroup());
+    }
+    assert((ids == std::vector<int64_t>{1, 2, 3, 5, 7, 9, 21, 24, 27}));
+    assert(std::find(row_groups_read.begin(), row_groups_read.end(), 1) == row_groups_read.end());
+
+    // Mixed with an integer leaf, in a query
+    QueryExecutor mixed(reader);
+    mixed.addFilter(FilterExpr::anyOf({either, Predicate{"id", CompareOp::EQ, 15}}));
+    mixed.setAggregation(AggFunc::SUM, "id");
+    auto mixed_sum = mixed.executeAggregate();
+    assert(mixed_sum.count == 10 && mixed_sum.sum == 1 + 2 + 3 + 5 + 7 + 9 + 15 + 21 + 24 + 27);
+    (void)mixed_sum;
+
+    // Predicates must match the column type
+    Scanner mismatched(reader, {"id"});
+    bool threw_numeric = false;
+    bool threw_string = false;
+    try {
+        mismatched.addFilter(Predicate{"status", CompareOp::EQ, 1});
+    } catch (const std::runtime_error&) {
+        threw_numeric = true;
+    }
+    try {
+        mismatched.addFilter(Predicate::compareString("id", CompareOp::EQ, "1"));
+    } catch (const std::runtime_error&) {
+        threw_string = true;
+    }
+    bool threw_expr = false;
+    try {
+        mismatched.addFilter(FilterExpr::anyOf({Predicate{"id", CompareOp::EQ, 1},
+                                                Predicate::compareString("id", CompareOp::EQ, "1")}));
+    } catch (const std::runtime_error&) {
+        threw_expr = true;
+    }
+    assert(threw_numeric && threw_string && threw_expr);
+    (void)threw_numeric;
+    (void)threw_string;
+    (void)threw_expr;
+
+    cleanup();
+    std::cout << "test_string_predicates: PASS\n";
+}
+
+void test_string_stats_pruning() {
+    cleanup();
+    createStatusFile();
+    auto reader = std::make_shared<FileReader>(TEST_FILE);
+
+    // Bounds per row group: status [active, pending], [closed, closed],
+    // [active, closed]; name [n0, n9], [n10, n19], [n20, n29]
+    const auto& row_groups = reader->metadata().row_groups;
+    auto verdicts = [&](const Predicate& pred) {
+        size_t col_idx = reader->schema().columnIndex(pred.column);
+        std::vector<StatsMatch> matches;
+        for (const auto& rg : row_groups) {
+            matches.push_back(pred.matchStats(rg.column_chunks[col_idx].page_headers[0].stats));
+        }
+        return matches;
+    };
+    const auto NEVER = StatsMatch::NEVER;
+    const auto MAYBE = StatsMatch::MAYBE;
+    const auto ALWAYS = StatsMatch::ALWAYS;
+    assert((verdicts(Predicate::compareString("status", CompareOp::EQ, "pending")) ==
+            std::vector<StatsMatch>{MAYBE, NEVER, NEVER}));
+    assert((verdicts(Predicate::compareString("status", CompareOp::NE, "closed")) ==
+            std::vector<StatsMatch>{MAYBE, NEVER, MAYBE}));
+    assert((verdicts(Predicate::inStrings("status", {"closed", "zzz"})) ==
+            std::vector<StatsMatch>{MAYBE, ALWAYS, MAYBE}));
+    assert((verdicts(Predicate::startsWith("name", "n2")) == std::vector<StatsMatch>{MAYBE, NEVER, ALWAYS}));
+    assert((verdicts(Predicate::compareString("name", CompareOp::GE, "n3")) ==
+            std::vector<StatsMatch>{MAYBE, NEVER, NEVER}));
+    assert((verdicts(Predicate::compareString("name", CompareOp::LT, "n1")) ==
+            std::vector<StatsMatch>{MAYBE, NEVER, NEVER}));
+    (void)verdicts;
+    (void)NEVER;
+    (void)MAYBE;
+    (void)ALWAYS;
+
+    // Only the first row group is read
+    Scanner scanner(reader, {"id"});
+    scanner.addFilter(Predicate::compareString("name", CompareOp::GE, "n3"));
+    std::vector<int64_t> ids;
+    while (scanner.hasNext()) {
+        Batch batch = scanner.next();
+        assert(scanner.currentRowGroup() == 0);
+        const auto& batch_ids = batch.getColumn<int64_t>(0);
+        ids.insert(ids.end(), batch_ids.begin(), batch_ids.end());
+    }
+    assert((ids == std::vector<int64_t>{3, 4, 5, 6, 7, 8, 9}));
+
+    // The last row group is counted from its stats
+    QueryExecutor count(reader);
+    count.addFilter(Predicate::startsWith("name", "n2"));
+    count.setAggregation(AggFunc::COUNT, "id");
+    assert(count.executeAggregate().count == 1 + 10);
+
+    // ORDER BY name DESC LIMIT 3 is settled by the first row group; the
+    // others are skipped from their max bounds
+    QueryExecutor top(reader);
+    top.setProjection({"name"});
+    top.setOrderBy("name", true);
+    top.setLimit(3);
+    std::vector<std::string> names;
+    for (const auto& batch : top.executeQuery()) {
+        const auto& batch_names = batch.getColumn<std::string>(0);
+        names.insert(names.end(), batch_names.begin(), batch_names.end());
+    }
+    assert((names == std::vector<std::string>{"n9", "n8", "n7"}));
+    assert(top.prunedRowGroups() == 2);
+
+    cleanup();
+    std::cout << "test_string_stats_pruning: PASS\n";
+}
+
+void test_bloom_filter_pruning() {
+    cleanup();
+
+    // Ten row groups of shuffled keys: every chunk spans nearly the whole
+    // key range, so stats cannot rule any out
+    Schema schema;
+    schema.columns = {
+        {"key", ColumnType::INT64, EncodingType::PLAIN},
+        {"name", ColumnType::STRING, EncodingType::PLAIN}
+    };
+    {
+        FileWriter writer(TEST_FILE, schema);
+        writer.setBloomFilter(0, 0.01);
+        writer.setBloomFilter(1, 0.01);
+        for (int64_t rg = 0; rg < 10; rg++) {
+            std::vector<int64_t> keys;
+            std::vector<std::string> names;
+            for (int64_t i = 0; i < 100; i++) {
+                keys.push_back(((rg * 100 + i) * 7919) % 1000);
+                names.push_back("k" + std::to_string(keys.back()));
+            }
+            writer.writeInt64Column(0, keys);
+            writer.writeStringColumn(1, names);
+            writer.flushRowGroup();
+        }
+        writer.close();
+    }
+    auto reader = std::make_shared<FileReader>(TEST_FILE);
+
+    // Scan, returning the keys found and the row groups read
+    auto lookup = [&](const Predicate& pred) {
+        Scanner scanner(reader, {"key"});
+        scanner.addFilter(pred);
+        std::vector<int64_t> keys;
+        std::vector<size_t> row_groups;
+        while (scanner.hasNext()) {
+            Batch batch = scanner.next();
+            row_groups.push_back(scanner.currentRowGroup());
+            const auto& batch_keys = batch.getColumn<int64_t>(0);
+            keys.insert(keys.end(), batch_keys.begin(), batch_keys.end());
+        }
+        std::sort(keys.begin(), keys.end());
+        return std::make_pair(keys, row_groups);
+    };
+
+    // Key 7919 * 123 % 1000 = 37 is in row group 1 only
+    auto [keys, row_groups] = lookup(Predicate{"key", CompareOp::EQ, 37});
+    assert((keys == std::vector<int64_t>{37}));
+    assert(row_groups.size() <= 2 && std::count(row_groups.begin(), row_groups.end(), 1) == 1);
+
+    std::tie(keys, row_groups) = lookup(Predicate::compareString("name", CompareOp::EQ, "k37"));
+    assert((keys == std::vector<int64_t>{37}));
+    assert(row_groups.size() <= 2);
+
+    std::tie(keys, row_groups) = lookup(Predicate::in("key", {37, 2000, 5000}));
+    assert((keys == std::vector<int64_t>{37}));
+    assert(row_groups.size() <= 2);
+
+    std::tie(keys, row_groups) = lookup(Predicate::inStrings("name", {"k37", "k38", "none"}));
+    assert((keys == std::vector<int64_t>{37, 38}));
+    assert(row_groups.size() <= 3);
+
+    // A missing key reads nothing
+    std::tie(keys, row_groups) = lookup(Predicate{"key", CompareOp::EQ, 5000});
+    assert(keys.empty());
+    assert(row_groups.empty());
+
+    cleanup();
+    std::cout << "test_bloom_filter_pruning: PASS\n";
+}
+
+void test_sorted_range_selection() {
+    cleanup();
+
+    // One row group: id ascending, up ascending with repeats, down
+    // descending, name ascending
+    Schema schema;
+    schema.columns = {
+        {"id", ColumnType::INT64, EncodingType::PLAIN},
+        {"up", ColumnType::INT32, EncodingType::DELTA},
+        {"down", ColumnType::INT64, EncodingType::PLAIN},
+        {"name", ColumnType::STRING, EncodingType::PLAIN}
+    };
+    const int64_t num_rows = 300;
+    auto up = [](int64_t id) { return id / 3; };
+    auto down = [](int64_t id) { return (num_rows - id) / 2; };
+    auto name = [](int64_t id) {
+        std::string digits = std::to_string(id);
+        return "n" + std::string(3 - digits.size(), '0') + digits;
+    };
+    {
+        FileWriter writer(TEST_FILE, schema);
+        std::vector<int64_t> ids;
+        std::vector<int32_t> ups;
+        std::vector<int64_t> downs;
+        std::vector<std::string> names;
+        for (int64_t id = 0; id < num_rows; id++) {
+            ids.push_back(id);
+            ups.push_back(static_cast<int32_t>(up(id)));
+            downs.push_back(down(id));
+            names.push_back(name(id));
+        }
+        writer.writeInt64Column(0, ids);
+        writer.writeInt32Column(1, ups);
+        writer.writeInt64Column(2, downs);
+        writer.writeStringColumn(3, names);
+        writer.close();
+    }
+    auto reader = std::make_shared<FileReader>(TEST_FILE);
+    assert(reader->metadata().row_groups[0].column_chunks[2].sort_order == ChunkOrder::DESCENDING);
+
+    auto scan = [&](const FilterExpr& filter, std::vector<size_t>* sizes = nullptr) {
+        Scanner scanner(reader, {"id"}, 16);
+        scanner.addFilter(filter);
+        std::vector<int64_t> ids;
+        while (scanner.hasNext()) {
+            Batch batch = scanner.next();
+            const auto& batch_ids = batch.getColumn<int64_t>(0);
+            ids.insert(ids.end(), batch_ids.begin(), batch_ids.end());
+            if (sizes) {
+                sizes->push_back(batch.num_rows);
+            }
+        }
+        return ids;
+    };
+    auto expected = [&](auto passes) { return expectedIds(num_rows, passes); };
+
+    // Every comparison on both orders, at the ends, inside and outside the range
+    for (CompareOp op : {CompareOp::EQ, CompareOp::LT, CompareOp::LE, CompareOp::GT, CompareOp::GE}) {
+        for (int64_t value : {-1, 0, 1, 37, 99, 100, 149, 150, 151}) {
+            Predicate up_pred{"up", op, value};
+            Predicate down_pred{"down", op, value};
+            assert(scan(up_pred) == expected([&](int64_t id) { return up_pred.evaluate(up(id)); }));
+            assert(scan(down_pred) == expected([&](int64_t id) { return down_pred.evaluate(down(id)); }));
+        }
+    }
+
+    // Strings, including a prefix
+    auto names = [&](const Predicate& pred) {
+        return expected([&](int64_t id) { return pred.evaluate(name(id)); });
+    };
+    for (const auto& pred : {Predicate::compareString("name", CompareOp::LT, "n1"),
+                             Predicate::compareString("name", CompareOp::GE, "n250"),
+                             Predicate::compareString("name", CompareOp::EQ, "n042"),
+                             Predicate::startsWith("name", "n12"),
+                             Predicate::startsWith("name", "x")}) {
+        assert(scan(pred) == names(pred));
+        (void)pred;
+    }
+    (void)names;
+
+    // A range of several filters is their intersection, and its rows come
+    // in full batches; filters on other columns still apply row by row
+    std::vector<size_t> sizes;
+    auto ids = scan(FilterExpr::allOf({FilterExpr::between("id", 100, 149), Predicate{"down", CompareOp::LE, 90}}),
+                    &sizes);
+    assert(ids == expected([](int64_t id) { return id >= 119 && id <= 149; }));
+    assert((sizes == std::vector<size_t>{16, 15}));
+    ids = scan(FilterExpr::allOf({Predicate{"up", CompareOp::LT, 20}, Predicate{"down", CompareOp::EQ, 149}}));
+    assert((ids == std::vector<int64_t>{1, 2}));
+    ids = scan(FilterExpr::allOf({Predicate{"up", CompareOp::LT, 20}, Predicate{"id", CompareOp::NE, 0}}));
+    assert(ids == expected([](int64_t id) { return id > 0 && id < 60; }));
+    (void)ids;
+
+    // Disjoint ranges read nothing
+    assert(scan(FilterExpr::allOf({Predicate{"id", CompareOp::LT, 10}, Predicate{"up", CompareOp::GT, 50}})).empty());
+
+    cleanup();
+    std::cout << "test_sorted_range_selection: PASS\n";
+}
+
+void test_column_index_skipping() {
+    cleanup();
+
+    // One row group of 10000 rows in blocks of 500: ts rises with some
+    // jitter (clustered, not sorted), bucket alternates between 0 and 100
+    // every block, id is sorted
+    Schema schema;
+    schema.columns = {
+        {"id", ColumnType::INT64, EncodingType::PLAIN},
+        {"ts", ColumnType::INT64, EncodingType::DELTA},
+        {"bucket", ColumnType::INT32, EncodingType::PLAIN},
+        {"score", ColumnType::INT32, EncodingType::RLE},
+        {"name", ColumnType::STRING, EncodingType::DICTIONARY}
+    };
+    const int64_t num_rows = 10000;
+    auto ts = [](int64_t id) { return id + (id * 7919) % 50; };
+    auto bucket = [](int64_t id) { return (id / 500) % 2 * 100; };
+    // The same rows without indexes, to compare the bytes read against
+    const std::string plain_file = TEST_FILE + ".noindex";
+    for (const std::string& path : {TEST_FILE, plain_file}) {
+        FileWriter writer(path, schema);
+        if (path == TEST_FILE) {
+            writer.setColumnIndex(500);
+        }
+        std::vector<int64_t> ids;
+        std::vector<int64_t> tss;
+        std::vector<int32_t> buckets;
+        std::vector<int32_t> scores;
+        std::vector<std::string> names;
+        for (int64_t id = 0; id < num_rows; id++) {
+            ids.push_back(id);
+            tss.push_back(ts(id));
+            buckets.push_back(static_cast<int32_t>(bucket(id)));
+            scores.push_back(static_cast<int32_t>(id / 100));
+            names.push_back(id % 2 == 0 ? "even" : "odd");
+        }
+        writer.writeInt64Column(0, ids);
+        writer.writeInt64Column(1, tss);
+        writer.writeInt32Column(2, buckets);
+        writer.writeInt32Column(3, scores);
+        writer.writeStringColumn(4, names);
+        writer.close();
+    }
+    auto reader = std::make_shared<FileReader>(TEST_FILE);
+    assert(reader->metadata().row_groups[0].column_chunks[1].sort_order == ChunkOrder::UNSORTED);
+
+    // Rows returned, checked against every selected column
+    auto scan = [&](const std::vector<FilterExpr>& filters, std::shared_ptr<FileReader> from = nullptr) {
+        Scanner scanner(from ? from : reader, {"id", "ts", "bucket", "score", "name"}, 256);
+        for (const auto& filter : filters) {
+            scanner.addFilter(filter);
+        }
+        std::vector<int64_t> ids;
+        while (scanner.hasNext()) {
+            Batch batch = scanner.next();
+            for (size_t i = 0; i < batch.num_rows; i++) {
+                int64_t id = batch.getColumn<int64_t>(0)[i];
+                assert(batch.getColumn<int64_t>(1)[i] == ts(id));
+                assert(batch.getColumn<int32_t>(2)[i] == bucket(id));
+                assert(batch.getColumn<int32_t>(3)[i] == id / 100);
+                assert(batch.getColumn<std::string>(4)[i] == (id % 2 == 0 ? "even" : "odd"));
+                ids.push_back(id);
+            }
+        }
+        return ids;
+    };
+    auto expected = [&](auto passes) { return expectedIds(num_rows, passes); };
+
+    assert(scan({}) == expected([](int64_t) { return true; }));
+    assert(scan({FilterExpr::between("ts", 4000, 4100)}) ==
+           expected([&](int64_t id) { return ts(id) >= 4000 && ts(id) <= 4100; }));
+    assert(scan({FilterExpr::anyOf({FilterExpr::between("ts", 1000, 1010), Predicate{"ts", CompareOp::GT, 9990}})}) ==
+           expected([&](int64_t id) { return (ts(id) >= 1000 && ts(id) <= 1010) || ts(id) > 9990; }));
+
+    // Every other block, then one range within it: blocks and the sorted
+    // id range combine
+    assert(scan({Predicate{"bucket", CompareOp::EQ, 100}}) == expected([&](int64_t id) { return bucket(id) == 100; }));
+    assert(scan({Predicate{"bucket", CompareOp::EQ, 100}, Predicate{"id", CompareOp::GE, 1200},
+                 Predicate{"id", CompareOp::LT, 3700}, Predicate::compareString("name", CompareOp::EQ, "odd")}) ==
+           expected([&](int64_t id) { return bucket(id) == 100 && id >= 1200 && id < 3700 && id % 2 == 1; }));
+
+    // The chunk's min/max (0 and 100) admit 50, but no block does
+    assert(scan({Predicate{"bucket", CompareOp::EQ, 50}}).empty());
+
+    // Skipped blocks of seekable chunks are never read: a selective filter
+    // reads a fraction of the page bytes an unindexed file needs
+    auto plain_reader = std::make_shared<FileReader>(plain_file);
+    uint64_t indexed_before = reader->pageBytesRead();
+    auto ids = scan({FilterExpr::between("ts", 4000, 4100)});
+    uint64_t indexed_bytes = reader->pageBytesRead() - indexed_before;
+    assert(scan({FilterExpr::between("ts", 4000, 4100)}, plain_reader) == ids);
+    assert(indexed_bytes * 2 < plain_reader->pageBytesRead());
+    (void)scan;
+    (void)expected;
+    (void)indexed_bytes;
+
+    std::filesystem::remove(plain_file);
+    cleanup();
+    std::cout << "test_column_index_skipping: PASS\n";
+}
+
+void test_scanner_batch_size() {
+    cleanup();
+    createTestFile();
+
+    auto reader = std::make_shared<FileReader>(TEST_FILE);
+    Scanner scanner(reader, {"id", "category"}, 2);
+
+    std::vector<size_t> sizes;
+    std::vector<int64_t> ids;
+    while (scanner.hasNext()) {
+        Batch batch = scanner.next();
+        sizes.push_back(batch.num_rows);
+        for (int64_t id : batch.getColumn<int64_t>(0)) {
+            ids.push_back(id);
+        }
+        assert(batch.getColumn<std::string>(1).size() == batch.num_rows);
+    }
+
+    assert((sizes == std::vector<size_t>{2, 2, 1}));
+    assert((ids == std::vector<int64_t>{1, 2, 3, 4, 5}));
+
+    Scanner filtered(reader, {"id"}, 2);
+    filtered.addFilter(Predicate{"value", CompareOp::GT, 150});
+
+    ids.clear();
+    while (filtered.hasNext()) {
+        Batch batch = filtered.next();
+        assert(batch.num_rows <= 2);
+        for (int64_t id : batch.getColumn<int64_t>(0)) {
+            ids.push_back(id);
+        }
+    }
+    assert((ids == std::vector<int64_t>{2, 4, 5}));
+
+    cleanup();
+    std::cout << "test_scanner_batch_size: PASS\n";
+}
+
 void test_query_projection() {
     cleanup();
     createTestFile();
@@ -132,6 +869,228 @@ void test_query_projection() {
     std::cout << "test_query_projection: PASS\n";
 }
 
+void test_result_stream() {
+    cleanup();
+    createTestFile();
+
+    auto reader = std::make_shared<FileReader>(TEST_FILE);
+    QueryExecutor executor(reader);
+    executor.setBatchSize(2);
+    executor.addFilter(Predicate{"value", CompareOp::GE, 300});
+
+    auto stream = executor.executeStream();
+    size_t total_rows = 0;
+    while (stream.hasNext()) {
+        Batch batch = stream.next();
+        assert(batch.num_rows > 0);
+        total_rows += batch.num_rows;
+    }
+    assert(total_rows == 1);
+
+    // Early termination
+    QueryExecutor unfiltered(reader);
+    unfiltered.setBatchSize(2);
+    auto partial = unfiltered.executeStream();
+    assert(partial.hasNext());
+    assert(partial.next().num_rows == 2);
+    partial.close();
+    assert(!partial.hasNext());
+
+    cleanup();
+    std::cout << "test_result_stream: PASS\n";
+}
+
+void test_limit_offset() {
+    cleanup();
+    createMultiRowGroupFile();
+
+    auto reader = std::make_shared<FileReader>(TEST_FILE);
+
+    {
+        QueryExecutor executor(reader);
+        executor.setLimit(3);
+        auto stream = executor.executeStream();
+        assert((collectIds(stream) == std::vector<int64_t>{0, 1, 2}));
+    }
+
+    {
+        // Offset skips the first row group entirely and lands mid-group
+        QueryExecutor executor(reader);
+        executor.setLimit(4, 6);
+        auto stream = executor.executeStream();
+        assert((collectIds(stream) == std::vector<int64_t>{6, 7, 8, 9}));
+    }
+
+    {
+        QueryExecutor executor(reader);
+        executor.addFilter(Predicate{"value", CompareOp::GE, 30});
+        executor.setLimit(2, 3);
+        auto stream = executor.executeStream();
+        assert((collectIds(stream) == std::vector<int64_t>{6, 7}));
+    }
+
+    {
+        QueryExecutor executor(reader);
+        executor.setLimit(10, 100);
+        auto stream = executor.executeStream();
+        assert(!stream.hasNext());
+    }
+
+    cleanup();
+    std::cout << "test_limit_offset: PASS\n";
+}
+
+void test_order_by_limit() {
+    cleanup();
+    createMultiRowGroupFile();
+
+    auto reader = std::make_shared<FileReader>(TEST_FILE);
+
+    {
+        // The top 3 values live in the last row group; the others are
+        // skipped from their max without being read
+        QueryExecutor executor(reader);
+        executor.setProjection({"id"});
+        executor.setOrderBy("value", true);
+        executor.setLimit(3);
+        auto stream = executor.executeStream();
+        assert((collectIds(stream) == std::vector<int64_t>{11, 10, 9}));
+        assert(executor.prunedRowGroups() == 2);
+    }
+
+    {
+        // Ascending with an offset and a filter; the key column is not projected
+        QueryExecutor executor(reader);
+        executor.setProjection({"id"});
+        executor.addFilter(Predicate{"id", CompareOp::NE, 1});
+        executor.setOrderBy("value");
+        executor.setLimit(3, 2);
+        auto batches = executor.executeQuery();
+        assert(batches.size() == 1 && batches[0].columns.size() == 1);
+        assert((batches[0].getColumn<int64_t>(0) == std::vector<int64_t>{3, 4, 5}));
+        assert(executor.prunedRowGroups() == 1);
+    }
+
+    cleanup();
+    std::cout << "test_order_by_limit: PASS\n";
+}
+
+void test_order_by_external_sort() {
+    cleanup();
+
+    Schema schema;
+    schema.columns = {
+        {"id", ColumnType::INT64, EncodingType::PLAIN},
+        {"score", ColumnType::INT32, EncodingType::PLAIN},
+        {"name", ColumnType::STRING, EncodingType::DICTIONARY}
+    };
+
+    // Random scores with many ties; names share long prefixes
+    std::vector<int64_t> all_ids;
+    std::vector<int32_t> all_scores;
+    std::vector<std::string> all_names;
+    {
+        std::mt19937 rng(3);
+        FileWriter writer(TEST_FILE, schema);
+        for (int rg = 0; rg < 5; rg++) {
+            std::vector<int64_t> ids;
+            std::vector<int32_t> scores;
+            std::vector<std::string> names;
+            for (int i = 0; i < 4000; i++) {
+                ids.push_back(rg * 4000 + i);
+                scores.push_back(static_cast<int32_t>(rng() % 1000) - 500);
+                names.push_back("customer_" + std::to_string(rng() % 700));
+            }
+            writer.writeInt64Column(0, ids);
+            writer.writeInt32Column(1, scores);
+            writer.writeStringColumn(2, names);
+            writer.flushRowGroup();
+            all_ids.insert(all_ids.end(), ids.begin(), ids.end());
+            all_scores.insert(all_scores.end(), scores.begin(), scores.end());
+            all_names.insert(all_names.end(), names.begin(), names.end());
+        }
+        writer.close();
+    }
+
+    auto reader = std::make_shared<FileReader>(TEST_FILE);
+
+    // Reference orders: stable sorts of the row ids, so ties keep file order
+    std::vector<int64_t> by_score_desc = all_ids;
+    std::stable_sort(by_score_desc.begin(), by_score_desc.end(),
+                     [&](int64_t a, int64_t b) { return all_scores[a] > all_scores[b]; });
+    std::vector<int64_t> by_name = all_ids;
+    std::stable_sort(by_name.begin(), by_name.end(),
+                     [&](int64_t a, int64_t b) { return all_names[a] < all_names[b]; });
+
+    for (size_t budget : {size_t{0}, size_t{64} << 10}) {
+        QueryExecutor executor(reader);
+        executor.setProjection({"id"});
+        executor.setOrderBy("score", true);
+        executor.setMemoryBudget(budget);
+        executor.setBatchSize(1000);
+        auto stream = executor.executeStream();
+        assert(collectIds(stream) == by_score_desc);
+        assert((executor.spilledRows() > 0) == (budget > 0));
+
+        executor.setOrderBy("name");
+        executor.addFilter(Predicate{"id", CompareOp::GE, 1000});
+        executor.setLimit(5000, 2000000);  // Too large for the heap: sorted and skipped
+        stream = executor.executeStream();
+        assert(collectIds(stream).empty());
+
+        executor.setLimit(std::numeric_limits<size_t>::max(), 3000);
+        stream = executor.executeStream();
+        std::vector<int64_t> expected;
+        for (int64_t id : by_name) {
+            if (id >= 1000) {
+                expected.push_back(id);
+            }
+        }
+        expected.erase(expected.begin(), expected.begin() + 3000);
+        assert(collectIds(stream) == expected);
+    }
+
+    cleanup();
+    std::cout << "test_order_by_external_sort: PASS\n";
+}
+
+void test_external_sort_run_memory() {
+    cleanup();
+
+    Schema schema;
+    schema.columns = {{"id", ColumnType::INT64, EncodingType::PLAIN}};
+
+    std::vector<int64_t> ids(3000);
+    for (size_t i = 0; i < ids.size(); i++) {
+        ids[i] = static_cast<int64_t>((i * 7919) % ids.size());
+    }
+    {
+        FileWriter writer(TEST_FILE, schema);
+        writer.writeInt64Column(0, ids);
+        writer.flushRowGroup();
+        writer.close();
+    }
+
+    // Each 1000-row batch costs 8 data bytes plus 16 bytes of sort key,
+    // order index and radix scratch per row: 24000 bytes. Counting the
+    // data alone, all three batches fit under half of the budget
+    auto reader = std::make_shared<FileReader>(TEST_FILE);
+    QueryExecutor executor(reader);
+    executor.setOrderBy("id");
+    executor.setMemoryBudget(2 * 40000);
+    executor.setBatchSize(1000);
+    auto stream = executor.executeStream();
+
+    std::vector<int64_t> expected = ids;
+    std::sort(expected.begin(), expected.end());
+    assert(collectIds(stream) == expected);
+    // The run is cut once the second batch brings it past 40000 bytes
+    assert(executor.spilledRows() == 2000);
+
+    cleanup();
+    std::cout << "test_external_sort_run_memory: PASS\n";
+}
+
 void test_aggregation_count() {
     cleanup();
     createTestFile();
@@ -182,6 +1141,329 @@ void test_aggregation_with_filter() {
     std::cout << "test_aggregation_with_filter: PASS\n";
 }
 
+void test_aggregation_from_metadata() {
+    cleanup();
+    createMultiRowGroupFile();
+
+    auto reader = std::make_shared<FileReader>(TEST_FILE);
+
+    PageStats stats;
+    stats.min_int = 100;
+    stats.max_int = 200;
+    assert(Predicate({"value", CompareOp::GE, 100}).matchStats(stats) == StatsMatch::ALWAYS);
+    assert(Predicate({"value", CompareOp::GT, 150}).matchStats(stats) == StatsMatch::MAYBE);
+    assert(Predicate({"value", CompareOp::GT, 200}).matchStats(stats) == StatsMatch::NEVER);
+    assert(Predicate({"value", CompareOp::NE, 50}).matchStats(stats) == StatsMatch::ALWAYS);
+
+    {
+        QueryExecutor executor(reader);
+        executor.setAggregation(AggFunc::COUNT, "id");
+        assert(executor.executeAggregate().count == 12);
+    }
+
+    {
+        QueryExecutor executor(reader);
+        executor.setAggregation(AggFunc::MAX, "value");
+        auto result = executor.executeAggregate();
+        assert(result.count == 12);
+        assert(result.max.value() == 110);
+        (void)result;
+    }
+
+    {
+        // First row group overlaps the filter, the other two are contained
+        QueryExecutor executor(reader);
+        executor.addFilter(Predicate{"value", CompareOp::GE, 30});
+        executor.setAggregation(AggFunc::MIN, "id");
+        auto result = executor.executeAggregate();
+        assert(result.count == 9);
+        assert(result.min.value() == 3);
+        (void)result;
+    }
+
+    {
+        QueryExecutor executor(reader);
+        executor.addFilter(Predicate{"value", CompareOp::LT, 50});
+        executor.setAggregation(AggFunc::COUNT, "id");
+        assert(executor.executeAggregate().count == 5);
+    }
+
+    {
+        // Stored sums for the contained row groups plus a decoded boundary
+        QueryExecutor executor(reader);
+        executor.addFilter(Predicate{"value", CompareOp::GT, 20});
+        executor.setAggregation(AggFunc::SUM, "value");
+        auto result = executor.executeAggregate();
+        assert(result.count == 9);
+        assert(result.sum == 30 + 220 + 380);
+        (void)result;
+    }
+
+    cleanup();
+    std::cout << "test_aggregation_from_metadata: PASS\n";
+}
+
+void test_multiple_aggregates() {
+    cleanup();
+    createMultiRowGroupFile();
+
+    auto reader = std::make_shared<FileReader>(TEST_FILE);
+
+    QueryExecutor executor(reader);
+    executor.addAggregation(AggFunc::SUM, "value");
+    executor.addAggregation(AggFunc::MAX, "id", {Predicate{"value", CompareOp::LT, 50}});
+    executor.addAggregation(AggFunc::COUNT, "id", {Predicate{"id", CompareOp::GE, 6}});
+    executor.addAggregation(AggFunc::MIN, "value", {Predicate{"id", CompareOp::GE, 100}});
+
+    auto results = executor.executeAggregates();
+    assert(results.size() == 4);
+    assert(results[0].count == 12 && results[0].sum == 660);
+    assert(results[1].count == 5 && results[1].max.value() == 4);
+    assert(results[2].count == 6);
+    assert(results[3].count == 0 && !results[3].min.has_value());
+
+    // Query filters apply to every aggregate, own filters on top
+    executor.addFilter(Predicate{"id", CompareOp::GE, 2});
+    results = executor.executeAggregates();
+    assert(results[0].count == 10 && results[0].sum == 650);
+    assert(results[1].count == 3 && results[1].max.value() == 4);
+    assert(results[2].count == 6);
+
+    assert(executor.executeAggregate().sum == 650);
+
+    cleanup();
+    std::cout << "test_multiple_aggregates: PASS\n";
+}
+
+void test_statistical_aggregates() {
+    cleanup();
+
+    Schema schema;
+    schema.columns = {
+        {"key", ColumnType::INT64, EncodingType::PLAIN},
+        {"value", ColumnType::INT32, EncodingType::PLAIN},
+        {"big", ColumnType::INT64, EncodingType::PLAIN}
+    };
+
+    // key k holds values k, k + 2, k + 4 (k = 0, 1); big overflows SUM
+    {
+        FileWriter writer(TEST_FILE, schema);
+        for (int rg = 0; rg < 2; rg++) {
+            std::vector<int64_t> keys = {0, 1, 0};
+            std::vector<int32_t> values = {rg * 4, 1 + rg * 4, 2};
+            std::vector<int64_t> big = {INT64_MAX, INT64_MAX, 1};
+            if (rg == 1) {
+                keys = {1, 0, 1};
+                values = {3, 4, 5};
+            }
+            writer.writeInt64Column(0, keys);
+            writer.writeInt32Column(1, values);
+            writer.writeInt64Column(2, big);
+            writer.flushRowGroup();
+        }
+        writer.close();
+    }
+
+    auto reader = std::make_shared<FileReader>(TEST_FILE);
+
+    // Values 0..5: mean 2.5, population variance 35/12
+    for (size_t threads : {1, 2}) {
+        QueryExecutor executor(reader);
+        executor.setThreads(threads);
+        executor.addAggregation(AggFunc::AVG, "value");
+        executor.addAggregation(AggFunc::VAR_POP, "value");
+        executor.addAggregation(AggFunc::VAR_SAMP, "value");
+        executor.addAggregation(AggFunc::STDDEV, "value");
+        executor.addAggregation(AggFunc::AVG, "value", {Predicate{"value", CompareOp::GE, 2}});
+        auto results = executor.executeAggregates();
+
+        assert(results[0].value.value() == 2.5);
+        assert(std::abs(results[1].value.value() - 35.0 / 12) < 1e-12);
+        assert(std::abs(results[2].value.value() - 3.5) < 1e-12);
+        assert(std::abs(results[3].value.value() - std::sqrt(3.5)) < 1e-12);
+        assert(results[4].count == 4 && results[4].value.value() == 3.5);
+    }
+
+    QueryExecutor grouped(reader);
+    grouped.setGroupBy("key");
+    grouped.addAggregation(AggFunc::AVG, "value");
+    grouped.addAggregation(AggFunc::VAR_SAMP, "value");
+    grouped.addAggregation(AggFunc::STDDEV_POP, "value");
+    auto groups = grouped.executeGroupByAggregates();
+    assert(groups.size() == 2);
+    assert(groups[0].aggs[0].value.value() == 2.0 && groups[1].aggs[0].value.value() == 3.0);
+    assert(std::abs(groups[0].aggs[1].value.value() - 4.0) < 1e-12);
+    assert(std::abs(groups[1].aggs[2].value.value() - std::sqrt(8.0 / 3)) < 1e-12);
+
+    // SUM past int64 throws; AVG of the same column stays exact
+    QueryExecutor overflow(reader);
+    overflow.setAggregation(AggFunc::SUM, "big");
+    bool threw = false;
+    try {
+        overflow.executeAggregates();
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    overflow.setAggregation(AggFunc::AVG, "big");
+    double expected_avg = (4.0 * static_cast<double>(INT64_MAX) + 2.0) / 6.0;
+    assert(std::abs(overflow.executeAggregate().value.value() - expected_avg) < 1e6);
+
+    overflow.setGroupBy("key");
+    overflow.setAggregation(AggFunc::SUM, "big");
+    threw = false;
+    try {
+        overflow.executeGroupBy();
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    (void)threw;
+    (void)expected_avg;
+
+    // Negative sums, in and past the int64 range: key k holds values
+    // -1 - 5k, -2 - 5k
+    cleanup();
+    {
+        FileWriter writer(TEST_FILE, schema);
+        writer.writeInt64Column(0, std::vector<int64_t>{0, 0, 1, 1});
+        writer.writeInt32Column(1, std::vector<int32_t>{-1, -2, -6, -7});
+        writer.writeInt64Column(2, std::vector<int64_t>{INT64_MIN, INT64_MIN, -2, -2});
+        writer.close();
+    }
+    reader = std::make_shared<FileReader>(TEST_FILE);
+
+    for (size_t threads : {1, 2}) {
+        QueryExecutor executor(reader);
+        executor.setThreads(threads);
+        executor.addAggregation(AggFunc::AVG, "value");
+        executor.addAggregation(AggFunc::VAR_POP, "value");
+        executor.addAggregation(AggFunc::AVG, "big");
+        executor.addAggregation(AggFunc::AVG, "value", {Predicate{"key", CompareOp::EQ, 0}});
+        executor.addAggregation(AggFunc::VAR_POP, "value", {Predicate{"key", CompareOp::EQ, 0}});
+        auto results = executor.executeAggregates();
+
+        assert(results[0].value.value() == -4.0);
+        assert(std::abs(results[1].value.value() - 6.5) < 1e-12);
+        assert(results[2].value.value() == static_cast<double>(INT64_MIN) / 2 - 1.0);
+        assert(results[3].value.value() == -1.5);
+        assert(std::abs(results[4].value.value() - 0.25) < 1e-12);
+    }
+
+    QueryExecutor negative(reader);
+    negative.setGroupBy("key");
+    negative.addAggregation(AggFunc::AVG, "value");
+    negative.addAggregation(AggFunc::VAR_POP, "value");
+    auto negative_groups = negative.executeGroupByAggregates();
+    assert(negative_groups.size() == 2);
+    assert(negative_groups[0].aggs[0].value.value() == -1.5);
+    assert(negative_groups[1].aggs[0].value.value() == -6.5);
+    assert(std::abs(negative_groups[0].aggs[1].value.value() - 0.25) < 1e-12);
+    assert(std::abs(negative_groups[1].aggs[1].value.value() - 0.25) < 1e-12);
+
+    cleanup();
+    std::cout << "test_statistical_aggregates: PASS\n";
+}
+
+void test_count_distinct() {
+    cleanup();
+
+    Schema schema;
+    schema.columns = {
+        {"id", ColumnType::INT64, EncodingType::PLAIN},
+        {"city", ColumnType::STRING, EncodingType::DICTIONARY}
+    };
+
+    // 4 row groups of 5000 rows; ids repeat every 7000, cities every 40
+    {
+        FileWriter writer(TEST_FILE, schema);
+        for (int rg = 0; rg < 4; rg++) {
+            std::vector<int64_t> ids;
+            std::vector<std::string> cities;
+            for (int i = 0; i < 5000; i++) {
+                int row = rg * 5000 + i;
+                ids.push_back(row % 7000);
+                cities.push_back("city_" + std::to_string(row % 40));
+            }
+            writer.writeInt64Column(0, ids);
+            writer.writeStringColumn(1, cities);
+            writer.flushRowGroup();
+        }
+        writer.close();
+    }
+
+    auto reader = std::make_shared<FileReader>(TEST_FILE);
+
+    for (size_t threads : {1, 4}) {
+        QueryExecutor executor(reader);
+        executor.setThreads(threads);
+        executor.addAggregation(AggFunc::COUNT_DISTINCT, "id");
+        executor.addAggregation(AggFunc::COUNT_DISTINCT, "city");
+        executor.addAggregation(AggFunc::APPROX_COUNT_DISTINCT, "id");
+        executor.addAggregation(AggFunc::COUNT_DISTINCT, "id", {Predicate{"id", CompareOp::LT, 100}});
+        auto results = executor.executeAggregates();
+
+        assert(results[0].distinct.value() == 7000);
+        assert(results[1].distinct.value() == 40);
+        assert(results[3].distinct.value() == 100);
+
+        // The default chunk sketches are coarser than the default error asks
+        // for: the answer comes from them, with their larger error
+        const auto& sketch = *results[2].sketch;
+        assert(sketch.precision() == DEFAULT_CHUNK_SKETCH_PRECISION);
+        assert(sketch.relativeError() > 0.01);
+        assert(std::abs(results[2].distinct.value() - 7000) < 7000 * 3 * sketch.relativeError());
+        (void)sketch;
+    }
+
+    // Row group 0 (ids 0-4999) is answered from its chunk sketch, the others
+    // are scanned; the scanned sketches merge at the chunk precision
+    QueryExecutor mixed(reader);
+    mixed.setAggregation(AggFunc::APPROX_COUNT_DISTINCT, "id");
+    mixed.addFilter(Predicate{"id", CompareOp::LT, 5000});
+    auto mixed_result = mixed.executeAggregate();
+    assert(mixed_result.sketch->precision() == DEFAULT_CHUNK_SKETCH_PRECISION);
+    assert(std::abs(mixed_result.distinct.value() - 5000) < 5000 * 3 * mixed_result.sketch->relativeError());
+
+    // Sketches of two scans merge into the sketch of the union
+    QueryExecutor low(reader);
+    low.addAggregation(AggFunc::APPROX_COUNT_DISTINCT, "id", {Predicate{"id", CompareOp::LT, 4000}});
+    QueryExecutor high(reader);
+    high.addAggregation(AggFunc::APPROX_COUNT_DISTINCT, "id", {Predicate{"id", CompareOp::GE, 3000}});
+    auto low_result = low.executeAggregates();
+    auto high_result = high.executeAggregates();
+    HyperLogLog merged = *low_result[0].sketch;
+    merged.merge(*high_result[0].sketch);
+    assert(std::abs(merged.estimate() - 7000) < 7000 * 0.03);
+
+    // A tolerance the chunk sketches meet is answered from metadata alone
+    QueryExecutor coarse(reader);
+    coarse.setDistinctError(0.05);
+    coarse.setAggregation(AggFunc::APPROX_COUNT_DISTINCT, "city");
+    auto from_metadata = coarse.executeAggregate();
+    unsigned precision = HyperLogLog::precisionForError(0.05);
+    assert(from_metadata.sketch->serialize() == reader->distinctSketch(1)->reduce(precision).serialize());
+    assert(from_metadata.count == 20000);
+    assert(std::abs(from_metadata.distinct.value() - 40) <= 40 * 0.1);
+    (void)precision;
+
+    QueryExecutor grouped(reader);
+    grouped.setGroupBy("city");
+    grouped.setAggregation(AggFunc::COUNT_DISTINCT, "id");
+    bool threw = false;
+    try {
+        grouped.executeGroupByAggregates();
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    (void)threw;
+
+    cleanup();
+    std::cout << "test_count_distinct: PASS\n";
+}
+
 void test_group_by() {
     cleanup();
     createTestFile();
@@ -236,6 +1518,419 @@ void test_group_by_with_sum() {
     std::cout << "test_group_by_with_sum: PASS\n";
 }
 
+void test_group_by_multiple_aggregates() {
+    cleanup();
+    createTestFile();
+
+    auto reader = std::make_shared<FileReader>(TEST_FILE);
+    QueryExecutor executor(reader);
+
+    executor.setGroupBy("category");
+    executor.addAggregation(AggFunc::COUNT, "id");
+    executor.addAggregation(AggFunc::SUM, "value", {Predicate{"id", CompareOp::GE, 3}});
+    executor.addAggregation(AggFunc::MAX, "value");
+    executor.addAggregation(AggFunc::SUM, "value", {Predicate{"id", CompareOp::GE, 5}});
+
+    auto results = executor.executeGroupByAggregates();
+    assert(results.size() == 3);
+
+    // A: ids 1, 3 (values 100, 150)
+    assert(results[0].keys[0] == "A");
+    assert(results[0].aggs[0].count == 2);
+    assert(results[0].aggs[1].count == 1 && results[0].aggs[1].sum == 150);
+    assert(results[0].aggs[2].max.value() == 150);
+    assert(results[0].aggs[3].count == 0 && results[0].aggs[3].sum == 0);
+
+    // B: ids 2, 5 (values 200, 250)
+    assert(results[1].keys[0] == "B");
+    assert(results[1].aggs[1].sum == 250);
+    assert(results[1].aggs[3].sum == 250);
+
+    // C: id 4 (value 300)
+    assert(results[2].keys[0] == "C");
+    assert(results[2].aggs[1].sum == 300 && results[2].aggs[2].max.value() == 300);
+
+    cleanup();
+    std::cout << "test_group_by_multiple_aggregates: PASS\n";
+}
+
+void test_group_by_dictionary_codes() {
+    cleanup();
+
+    Schema schema;
+    schema.columns = {
+        {"region", ColumnType::STRING, EncodingType::DICTIONARY},
+        {"value", ColumnType::INT32, EncodingType::PLAIN}
+    };
+
+    // Each row group has its own dictionary, in a different order
+    {
+        FileWriter writer(TEST_FILE, schema);
+        writer.writeStringColumn(0, {"north", "south", "north", "west"});
+        writer.writeInt32Column(1, {1, 2, 3, 40});
+        writer.flushRowGroup();
+        writer.writeStringColumn(0, {"east", "south", "north"});
+        writer.writeInt32Column(1, {5, 6, 7});
+        writer.flushRowGroup();
+        writer.close();
+    }
+
+    auto reader = std::make_shared<FileReader>(TEST_FILE);
+
+    Scanner scanner(reader, {"region"});
+    scanner.setDictionaryCodes("region");
+    Batch batch = scanner.next();
+    assert(batch.dictionary(0) != nullptr && batch.dictionary(0)->size() == 3);
+    assert((batch.getColumn<int32_t>(0) == std::vector<int32_t>{0, 1, 0, 2}));
+
+    QueryExecutor executor(reader);
+    executor.setGroupBy("region");
+    executor.setAggregation(AggFunc::SUM, "value");
+    executor.setBatchSize(2);
+
+    auto results = executor.executeGroupBy();
+    assert(results.size() == 4);
+    assert(results[0].first == "east" && results[0].second.sum == 5);
+    assert(results[1].first == "north" && results[1].second.sum == 11);
+    assert(results[1].second.count == 3 && results[1].second.max.value() == 7);
+    assert(results[2].first == "south" && results[2].second.sum == 8);
+    assert(results[3].first == "west" && results[3].second.sum == 40);
+
+    // Codes filtered out entirely never become groups
+    QueryExecutor filtered(reader);
+    filtered.setGroupBy("region");
+    filtered.setAggregation(AggFunc::COUNT, "value");
+    filtered.addFilter(Predicate{"value", CompareOp::LT, 10});
+
+    results = filtered.executeGroupBy();
+    assert(results.size() == 3);
+    assert(results[0].first == "east" && results[1].first == "north" && results[2].first == "south");
+    assert(results[1].second.count == 3);
+
+    cleanup();
+    std::cout << "test_group_by_dictionary_codes: PASS\n";
+}
+
+void test_group_by_composite_keys() {
+    cleanup();
+
+    Schema schema;
+    schema.columns = {
+        {"region", ColumnType::STRING, EncodingType::DICTIONARY},
+        {"status", ColumnType::STRING, EncodingType::PLAIN},
+        {"level", ColumnType::INT32, EncodingType::PLAIN},
+        {"value", ColumnType::INT64, EncodingType::PLAIN}
+    };
+
+    {
+        FileWriter writer(TEST_FILE, schema);
+        writer.writeStringColumn(0, {"north", "south", "north", "north"});
+        writer.writeStringColumn(1, {"open", "open", "closed", "open"});
+        writer.writeInt32Column(2, {-1, 2, -1, -1});
+        writer.writeInt64Column(3, {10, 20, 30, 40});
+        writer.flushRowGroup();
+        writer.writeStringColumn(0, {"south", "north"});
+        writer.writeStringColumn(1, {"open", "open"});
+        writer.writeInt32Column(2, {2, 5});
+        writer.writeInt64Column(3, {50, 60});
+        writer.flushRowGroup();
+        writer.close();
+    }
+
+    auto reader = std::make_shared<FileReader>(TEST_FILE);
+    QueryExecutor executor(reader);
+    executor.setGroupByColumns({"region", "status", "level"});
+    executor.addAggregation(AggFunc::COUNT, "value");
+    executor.addAggregation(AggFunc::SUM, "value");
+
+    auto results = executor.executeGroupByAggregates();
+    assert(results.size() == 4);
+    assert((results[0].keys == std::vector<std::string>{"north", "closed", "-1"}));
+    assert(results[0].aggs[1].sum == 30);
+    assert((results[1].keys == std::vector<std::string>{"north", "open", "-1"}));
+    assert(results[1].aggs[0].count == 2 && results[1].aggs[1].sum == 50);
+    assert((results[2].keys == std::vector<std::string>{"north", "open", "5"}));
+    assert((results[3].keys == std::vector<std::string>{"south", "open", "2"}));
+    assert(results[3].aggs[0].count == 2 && results[3].aggs[1].sum == 70);
+
+    auto single = executor.executeGroupBy();
+    assert(single[3].first == "south|open|2" && single[3].second.count == 2);
+
+    cleanup();
+    std::cout << "test_group_by_composite_keys: PASS\n";
+}
+
+void test_group_by_composite_wide_keys() {
+    cleanup();
+
+    Schema schema;
+    schema.columns = {
+        {"a", ColumnType::INT64, EncodingType::PLAIN},
+        {"b", ColumnType::INT64, EncodingType::PLAIN},
+        {"c", ColumnType::INT64, EncodingType::PLAIN}
+    };
+
+    // Full 64-bit ranges: too wide to pack, one word per column instead
+    const int64_t lo = INT64_MIN;
+    const int64_t hi = INT64_MAX;
+    {
+        FileWriter writer(TEST_FILE, schema);
+        writer.writeInt64Column(0, {lo, hi, lo, 0});
+        writer.writeInt64Column(1, {hi, lo, hi, 0});
+        writer.writeInt64Column(2, {0, 0, 0, hi});
+        writer.close();
+    }
+
+    auto reader = std::make_shared<FileReader>(TEST_FILE);
+    QueryExecutor executor(reader);
+    executor.setGroupByColumns({"a", "b", "c"});
+    executor.setAggregation(AggFunc::COUNT, "a");
+
+    auto results = executor.executeGroupByAggregates();
+    assert(results.size() == 3);
+    assert(results[0].keys[0] == std::to_string(lo) && results[0].aggs[0].count == 2);
+    assert((results[1].keys == std::vector<std::string>{"0", "0", std::to_string(hi)}));
+    assert(results[2].keys[0] == std::to_string(hi));
+
+    cleanup();
+    std::cout << "test_group_by_composite_wide_keys: PASS\n";
+}
+
+bool sameAggResult(const AggResult& a, const AggResult& b) {
+    return a.count == b.count && a.sum == b.sum && a.min == b.min && a.max == b.max;
+}
+
+bool sameGroups(const std::vector<GroupResult>& a, const std::vector<GroupResult>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].keys != b[i].keys || a[i].aggs.size() != b[i].aggs.size()) {
+            return false;
+        }
+        for (size_t j = 0; j < a[i].aggs.size(); j++) {
+            if (!sameAggResult(a[i].aggs[j], b[i].aggs[j])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void test_parallel_aggregation() {
+    cleanup();
+
+    Schema schema;
+    schema.columns = {
+        {"id", ColumnType::INT64, EncodingType::PLAIN},
+        {"region", ColumnType::STRING, EncodingType::DICTIONARY},
+        {"user", ColumnType::STRING, EncodingType::PLAIN},
+        {"value", ColumnType::INT32, EncodingType::PLAIN}
+    };
+
+    // 16 row groups; ids are distinct (well above the partitioned merge
+    // threshold), users repeat across row groups
+    {
+        FileWriter writer(TEST_FILE, schema);
+        const std::vector<std::string> regions = {"north", "south", "east", "west"};
+        for (int64_t rg = 0; rg < 16; rg++) {
+            std::vector<int64_t> ids;
+            std::vector<std::string> region_vals;
+            std::vector<std::string> users;
+            std::vector<int32_t> values;
+            for (int64_t i = 0; i < 2000; i++) {
+                int64_t id = rg * 2000 + i;
+                ids.push_back(id * 1000003);
+                region_vals.push_back(regions[static_cast<size_t>((id * 7) % 4)]);
+                users.push_back("user_" + std::to_string((id * 13) % 5000));
+                values.push_back(static_cast<int32_t>(id % 97) - 40);
+            }
+            writer.writeInt64Column(0, ids);
+            writer.writeStringColumn(1, region_vals);
+            writer.writeStringColumn(2, users);
+            writer.writeInt32Column(3, values);
+            writer.flushRowGroup();
+        }
+        writer.close();
+    }
+
+    auto reader = std::make_shared<FileReader>(TEST_FILE);
+
+    auto runAggregates = [&](size_t threads) {
+        QueryExecutor executor(reader);
+        executor.setThreads(threads);
+        executor.addFilter(Predicate{"id", CompareOp::GE, 5000});
+        executor.addAggregation(AggFunc::SUM, "value");
+        executor.addAggregation(AggFunc::MIN, "value", {Predicate{"value", CompareOp::GT, 0}});
+        executor.addAggregation(AggFunc::COUNT, "id");
+        return executor.executeAggregates();
+    };
+
+    auto serial = runAggregates(1);
+    auto parallel = runAggregates(4);
+    assert(serial.size() == parallel.size());
+    for (size_t a = 0; a < serial.size(); a++) {
+        assert(sameAggResult(serial[a], parallel[a]));
+    }
+    assert(serial[1].min.value() == 1);
+
+    for (const std::string group_col : {"region", "user", "id", "value"}) {
+        auto runGroupBy = [&](size_t threads) {
+            QueryExecutor executor(reader);
+            executor.setThreads(threads);
+            executor.setGroupBy(group_col);
+            executor.addAggregation(AggFunc::COUNT, "id");
+            executor.addAggregation(AggFunc::SUM, "value");
+            executor.addAggregation(AggFunc::MAX, "value", {Predicate{"value", CompareOp::LT, 10}});
+            return executor.executeGroupByAggregates();
+        };
+
+        auto serial_groups = runGroupBy(1);
+        auto parallel_groups = runGroupBy(4);
+        assert(sameGroups(serial_groups, parallel_groups));
+        assert(!serial_groups.empty());
+    }
+
+    cleanup();
+    std::cout << "test_parallel_aggregation: PASS\n";
+}
+
+void test_group_by_spill() {
+    cleanup();
+
+    Schema schema;
+    schema.columns = {
+        {"id", ColumnType::INT64, EncodingType::PLAIN},
+        {"user", ColumnType::STRING, EncodingType::DICTIONARY},
+        {"value", ColumnType::INT32, EncodingType::PLAIN}
+    };
+
+    {
+        FileWriter writer(TEST_FILE, schema);
+        for (int64_t rg = 0; rg < 4; rg++) {
+            std::vector<int64_t> ids;
+            std::vector<std::string> users;
+            std::vector<int32_t> values;
+            for (int64_t i = 0; i < 3000; i++) {
+                int64_t id = rg * 3000 + i;
+                ids.push_back((id % 4000) * 1000003);
+                users.push_back("user_" + std::to_string((id * 13) % 2500));
+                values.push_back(static_cast<int32_t>(id % 89) - 30);
+            }
+            writer.writeInt64Column(0, ids);
+            writer.writeStringColumn(1, users);
+            writer.writeInt32Column(2, values);
+            writer.flushRowGroup();
+        }
+        writer.close();
+    }
+
+    auto reader = std::make_shared<FileReader>(TEST_FILE);
+    const std::string spill_dir = "test_execution_spill";
+    std::filesystem::create_directory(spill_dir);
+
+    // Single keys, then composite keys: string and integer, two integers
+    const std::vector<std::vector<std::string>> group_cols = {{"user"}, {"id"}, {"user", "id"}, {"id", "value"}};
+    for (const auto& cols : group_cols) {
+        auto runGroupBy = [&](size_t budget) {
+            QueryExecutor executor(reader);
+            executor.setBatchSize(512);
+            executor.setMemoryBudget(budget);
+            executor.setSpillDirectory(spill_dir);
+            executor.addFilter(Predicate{"value", CompareOp::GE, -20});
+            executor.setGroupByColumns(cols);
+            executor.addAggregation(AggFunc::COUNT, "user");
+            executor.addAggregation(AggFunc::SUM, "value");
+            executor.addAggregation(AggFunc::MIN, "value", {Predicate{"value", CompareOp::GT, 10}});
+            auto groups = executor.executeGroupByAggregates();
+            return std::make_pair(groups, executor.spilledRows());
+        };
+
+        auto [in_memory, no_spill] = runGroupBy(0);
+        assert(no_spill == 0);
+
+        // A tiny budget forces spilling, recursively, at every level
+        auto [spilled, spilled_rows] = runGroupBy(1024);
+        assert(spilled_rows > 0);
+        assert(sameGroups(in_memory, spilled));
+        assert(std::filesystem::is_empty(spill_dir));
+
+        auto [roomy, roomy_rows] = runGroupBy(size_t{64} << 20);
+        assert(roomy_rows == 0);
+        assert(sameGroups(in_memory, roomy));
+    }
+
+    std::filesystem::remove_all(spill_dir);
+    cleanup();
+    std::cout << "test_group_by_spill: PASS\n";
+}
+
+void test_group_by_int_keys() {
+    cleanup();
+    createTestFile();
+
+    auto reader = std::make_shared<FileReader>(TEST_FILE);
+
+    // Narrow INT32 range: direct-indexed path, empty keys omitted
+    QueryExecutor by_value(reader);
+    by_value.setGroupBy("value");
+    by_value.setAggregation(AggFunc::SUM, "id");
+
+    auto results = by_value.executeGroupBy();
+    assert(results.size() == 5);
+    assert(results[0].first == "100" && results[0].second.sum == 1);
+    assert(results[1].first == "150" && results[1].second.sum == 3);
+    assert(results[4].first == "300" && results[4].second.sum == 4);
+
+    // Filtered COUNT grouped by INT64 id
+    QueryExecutor by_id(reader);
+    by_id.setGroupBy("id");
+    by_id.setAggregation(AggFunc::COUNT, "id");
+    by_id.addFilter(Predicate{"value", CompareOp::GE, 200});
+
+    results = by_id.executeGroupBy();
+    assert(results.size() == 3);
+    assert(results[0].first == "2" && results[1].first == "4" && results[2].first == "5");
+    assert(results[0].second.count == 1);
+
+    cleanup();
+    std::cout << "test_group_by_int_keys: PASS\n";
+}
+
+void test_group_by_wide_int_keys() {
+    cleanup();
+
+    Schema schema;
+    schema.columns = {
+        {"key", ColumnType::INT64, EncodingType::PLAIN},
+        {"value", ColumnType::INT32, EncodingType::PLAIN}
+    };
+
+    // Keys span far more than the direct-indexing limit: hashed path
+    {
+        FileWriter writer(TEST_FILE, schema);
+        std::vector<int64_t> keys = {-5000000000LL, 9, 7000000000LL, 9, -5000000000LL};
+        std::vector<int32_t> values = {1, 2, 3, 4, 5};
+        writer.writeInt64Column(0, keys);
+        writer.writeInt32Column(1, values);
+        writer.close();
+    }
+
+    auto reader = std::make_shared<FileReader>(TEST_FILE);
+    QueryExecutor executor(reader);
+    executor.setGroupBy("key");
+    executor.setAggregation(AggFunc::MAX, "value");
+
+    auto results = executor.executeGroupBy();
+    assert(results.size() == 3);
+    assert(results[0].first == "-5000000000" && results[0].second.max.value() == 5);
+    assert(results[1].first == "9" && results[1].second.max.value() == 4);
+    assert(results[2].first == "7000000000" && results[2].second.max.value() == 3);
+
+    cleanup();
+    std::cout << "test_group_by_wide_int_keys: PASS\n";
+}
+
 int main() {
     std::cout << "Running execution tests...\n";
 
@@ -243,12 +1938,37 @@ int main() {
     test_predicate_skip_page();
     test_scanner_basic();
     test_scanner_with_filter();
+    test_in_predicate();
+    test_filter_expressions();
+    test_string_predicates();
+    test_string_stats_pruning();
+    test_bloom_filter_pruning();
+    test_sorted_range_selection();
+    test_column_index_skipping();
+    test_scanner_batch_size();
     test_query_projection();
+    test_result_stream();
+    test_limit_offset();
+    test_order_by_limit();
+    test_order_by_external_sort();
+    test_external_sort_run_memory();
     test_aggregation_count();
     test_aggregation_sum();
     test_aggregation_with_filter();
+    test_aggregation_from_metadata();
+    test_multiple_aggregates();
+    test_statistical_aggregates();
+    test_count_distinct();
     test_group_by();
     test_group_by_with_sum();
+    test_group_by_multiple_aggregates();
+    test_group_by_dictionary_codes();
+    test_group_by_composite_keys();
+    test_group_by_composite_wide_keys();
+    test_parallel_aggregation();
+    test_group_by_spill();
+    test_group_by_int_keys();
+    test_group_by_wide_int_keys();
 
     std::cout << "\nAll execution tests passed.\n";
     return 0;
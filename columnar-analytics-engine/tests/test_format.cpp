@@ -3,10 +3,15 @@
 // Tests for file format read/write
 
 #include "format.h"
+#include "aggregation.h"
 #include <cassert>
+#include <cmath>
 #include <iostream>
+#include <string>
 #include <filesystem>
 #include <vector>
+#include <limits>
+#include <stdexcept>
 
 using namespace columnar;
 
@@ -128,6 +133,11 @@ void test_dictionary_encoding() {
         FileReader reader(TEST_FILE);
         auto decoded = reader.readStringColumn(0, 0);
         assert(decoded == regions);
+
+        // Codes index the dictionary in first-seen order
+        auto dict_col = reader.readDictionaryColumn(0, 0);
+        assert((dict_col.dictionary == std::vector<std::string>{"north", "south", "east"}));
+        assert((dict_col.codes == std::vector<int32_t>{0, 1, 0, 2, 1, 0}));
     }
 
     cleanup();
@@ -231,6 +241,430 @@ void test_statistics() {
     std::cout << "test_statistics: PASS\n";
 }
 
+void test_sum_statistics() {
+    cleanup();
+
+    Schema schema;
+    schema.columns = {
+        {"big", ColumnType::INT64, EncodingType::DELTA},
+        {"small", ColumnType::INT32, EncodingType::RLE}
+    };
+
+    // Sum of big exceeds int64 and must survive in the 128-bit stats
+    const int64_t big = std::numeric_limits<int64_t>::max() - 1;
+    std::vector<int64_t> bigs = {big, big, -5};
+    std::vector<int32_t> smalls = {-3, 7, 7};
+
+    {
+        FileWriter writer(TEST_FILE, schema);
+        writer.writeInt64Column(0, bigs);
+        writer.writeInt32Column(1, smalls);
+        writer.close();
+    }
+
+    {
+        FileReader reader(TEST_FILE);
+        const auto& rg = reader.metadata().row_groups[0];
+
+        const auto& big_sum = rg.column_chunks[0].page_headers[0].stats.sum;
+        assert(big_sum.has_value());
+        assert(!big_sum->fitsInt64());
+        assert(big_sum->hi == 0);
+        assert(big_sum->lo == 2 * static_cast<uint64_t>(big) - 5);
+
+        const auto& small_sum = rg.column_chunks[1].page_headers[0].stats.sum;
+        assert(small_sum.has_value() && small_sum->fitsInt64());
+        assert(small_sum->toInt64() == 11);
+        (void)big_sum;
+        (void)small_sum;
+
+        // Data pages are still located correctly behind the larger headers
+        assert(reader.readInt64Column(0, 0) == bigs);
+        assert(reader.readInt32Column(0, 1) == smalls);
+    }
+
+    cleanup();
+    std::cout << "test_sum_statistics: PASS\n";
+}
+
+void test_string_statistics() {
+    cleanup();
+
+    Schema schema;
+    schema.columns = {
+        {"name", ColumnType::STRING, EncodingType::PLAIN},
+        {"tag", ColumnType::STRING, EncodingType::DICTIONARY}
+    };
+
+    {
+        FileWriter writer(TEST_FILE, schema);
+        writer.writeStringColumn(0, {"bob", "alice", "carol"});
+        writer.writeStringColumn(1, {"x", "x", "x"});
+        writer.flushRowGroup();
+
+        // Long values are truncated: the min to a prefix, the max to a
+        // prefix with its last byte incremented, past any trailing 0xFF
+        writer.setStringStatsLength(4);
+        writer.writeStringColumn(0, {"customer_b", "customer_a", "cust\xFF\xFFz"});
+        writer.writeStringColumn(1, {"\xFF\xFF\xFF\xFF\xFF", "ab", "abcd"});
+        writer.flushRowGroup();
+
+        writer.setStringStatsLength(0);
+        writer.writeStringColumn(0, {"a"});
+        writer.writeStringColumn(1, {"b"});
+        writer.close();
+    }
+
+    {
+        FileReader reader(TEST_FILE);
+        const auto& row_groups = reader.metadata().row_groups;
+        auto stats = [&](size_t rg, size_t col) -> const PageStats& {
+            return row_groups[rg].column_chunks[col].page_headers[0].stats;
+        };
+
+        assert(stats(0, 0).min_string == "alice" && stats(0, 0).max_string == "carol");
+        assert(stats(0, 1).min_string == "x" && stats(0, 1).max_string == "x");
+        assert(!stats(0, 0).min_int.has_value());
+
+        assert(stats(1, 0).min_string == "cust" && stats(1, 0).max_string == "cusu");
+        assert(stats(1, 1).min_string == "ab" && !stats(1, 1).max_string.has_value());
+
+        assert(!stats(2, 0).min_string.has_value() && !stats(2, 0).max_string.has_value());
+        (void)stats;
+
+        // Data after the longer headers still reads back
+        assert(reader.readStringColumn(1, 0)[2] == "cust\xFF\xFFz");
+        assert(reader.readStringColumn(2, 1)[0] == "b");
+    }
+
+    bool threw = false;
+    try {
+        FileWriter writer(TEST_FILE, schema);
+        writer.setStringStatsLength(MAX_STRING_STATS_LENGTH + 1);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    (void)threw;
+
+    cleanup();
+    std::cout << "test_string_statistics: PASS\n";
+}
+
+void test_distinct_sketches() {
+    cleanup();
+
+    Schema schema;
+    schema.columns = {
+        {"id", ColumnType::INT64, EncodingType::DELTA},
+        {"code", ColumnType::INT32, EncodingType::RLE},
+        {"name", ColumnType::STRING, EncodingType::DICTIONARY}
+    };
+
+    // Row group rg holds ids [rg * 3000, rg * 3000 + 5000): 11000 in total
+    {
+        FileWriter writer(TEST_FILE, schema);
+        for (int rg = 0; rg < 3; rg++) {
+            std::vector<int64_t> ids;
+            std::vector<int32_t> codes;
+            std::vector<std::string> names;
+            for (int i = 0; i < 5000; i++) {
+                ids.push_back(rg * 3000 + i);
+                codes.push_back(i % 7);
+                names.push_back("name_" + std::to_string(i % 300));
+            }
+            if (rg == 2) {
+                writer.setSketchPrecision(8);
+            }
+            writer.writeInt64Column(0, ids);
+            writer.writeInt32Column(1, codes);
+            writer.writeStringColumn(2, names);
+            writer.flushRowGroup();
+        }
+        writer.close();
+    }
+
+    {
+        FileReader reader(TEST_FILE);
+        const auto& stats = reader.metadata().row_groups[0].column_chunks[2].page_headers[0].stats;
+        assert(stats.distinct_sketch.size() == 1 + (1u << DEFAULT_CHUNK_SKETCH_PRECISION));
+        assert(std::abs(static_cast<int>(stats.distinct_count_estimate) - 300) < 15);
+        (void)stats;
+
+        auto chunk = reader.distinctSketch(1, 1);
+        assert(chunk.has_value() && std::llround(chunk->estimate()) == 7);
+
+        // Chunks of different precisions merge at the coarsest one
+        auto ids = reader.distinctSketch(0);
+        assert(ids.has_value() && ids->precision() == 8);
+        assert(std::abs(ids->estimate() - 11000) < 11000 * 0.15);
+        auto names = reader.distinctSketch(2);
+        assert(names.has_value() && std::abs(names->estimate() - 300) < 300 * 0.15);
+        (void)chunk;
+        (void)ids;
+        (void)names;
+
+        assert(reader.readStringColumn(2, 2)[299] == "name_299");
+    }
+
+    // Sketches can be turned off; such files have no column sketch
+    {
+        FileWriter writer(TEST_FILE, schema);
+        writer.setSketchPrecision(0);
+        writer.writeInt64Column(0, {1, 2});
+        writer.writeInt32Column(1, {3, 4});
+        writer.writeStringColumn(2, {"a", "b"});
+        writer.close();
+    }
+
+    {
+        FileReader reader(TEST_FILE);
+        assert(reader.metadata().row_groups[0].column_chunks[2].page_headers[0].stats.distinct_count_estimate == 0);
+        assert(!reader.distinctSketch(0).has_value());
+        assert(reader.readInt64Column(0, 0) == std::vector<int64_t>({1, 2}));
+    }
+
+    cleanup();
+    std::cout << "test_distinct_sketches: PASS\n";
+}
+
+void test_bloom_filters() {
+    cleanup();
+
+    Schema schema;
+    schema.columns = {
+        {"id", ColumnType::INT64, EncodingType::PLAIN},
+        {"code", ColumnType::INT32, EncodingType::DELTA},
+        {"name", ColumnType::STRING, EncodingType::DICTIONARY}
+    };
+
+    {
+        FileWriter writer(TEST_FILE, schema);
+        writer.setBloomFilter(0, 0.01);
+        writer.setBloomFilter(2, 0.05);
+        for (int64_t rg = 0; rg < 2; rg++) {
+            std::vector<int64_t> ids;
+            std::vector<int32_t> codes;
+            std::vector<std::string> names;
+            for (int64_t i = rg * 100; i < rg * 100 + 100; i++) {
+                ids.push_back(i * 7);
+                codes.push_back(static_cast<int32_t>(i));
+                names.push_back("name_" + std::to_string(i));
+            }
+            writer.writeInt64Column(0, ids);
+            writer.writeInt32Column(1, codes);
+            writer.writeStringColumn(2, names);
+            writer.flushRowGroup();
+        }
+        writer.close();
+    }
+
+    {
+        FileReader reader(TEST_FILE);
+        const auto& chunks = reader.metadata().row_groups[1].column_chunks;
+        assert(chunks[0].bloom_size > 0 && chunks[2].bloom_size > 0);
+        assert(chunks[1].bloom_size == 0);
+        assert(!reader.readBloomFilter(1, 1).has_value());
+        (void)chunks;
+
+        // Every value written is found; the other row group's mostly are not
+        auto ids = reader.readBloomFilter(1, 0);
+        auto names = reader.readBloomFilter(1, 2);
+        assert(ids.has_value() && names.has_value());
+        size_t found = 0;
+        for (int64_t i = 0; i < 200; i++) {
+            std::string name = "name_" + std::to_string(i);
+            bool has_id = ids->mayContain(hashInt64(static_cast<uint64_t>(i * 7)));
+            bool has_name = names->mayContain(hashBytes(name.data(), name.size()));
+            if (i >= 100) {
+                assert(has_id && has_name);
+            } else {
+                found += (has_id ? 1 : 0) + (has_name ? 1 : 0);
+            }
+        }
+        assert(found < 20);
+        (void)found;
+
+        // The data is unaffected
+        assert(reader.readInt64Column(1, 0)[99] == 199 * 7);
+        assert(reader.readStringColumn(0, 2)[5] == "name_5");
+    }
+
+    bool threw = false;
+    try {
+        FileWriter writer(TEST_FILE, schema);
+        writer.setBloomFilter(0, 1.5);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    (void)threw;
+
+    cleanup();
+    std::cout << "test_bloom_filters: PASS\n";
+}
+
+void test_sort_order() {
+    cleanup();
+
+    Schema schema;
+    schema.columns = {
+        {"up", ColumnType::INT64, EncodingType::DELTA},
+        {"down", ColumnType::INT32, EncodingType::PLAIN},
+        {"mixed", ColumnType::INT64, EncodingType::PLAIN},
+        {"name", ColumnType::STRING, EncodingType::PLAIN}
+    };
+
+    {
+        FileWriter writer(TEST_FILE, schema);
+        writer.writeInt64Column(0, {1, 2, 2, 5});
+        writer.writeInt32Column(1, {9, 7, 7, -3});
+        writer.writeInt64Column(2, {1, 3, 2, 4});
+        writer.writeStringColumn(3, {"a", "ab", "b", "\xFF"});
+        writer.flushRowGroup();
+
+        // Equal values count as ascending
+        writer.writeInt64Column(0, {4, 4});
+        writer.writeInt32Column(1, {1, 2});
+        writer.writeInt64Column(2, {2, 1});
+        writer.writeStringColumn(3, {"b", "a"});
+        writer.close();
+    }
+
+    FileReader reader(TEST_FILE);
+    auto order = [&](size_t rg, size_t col) {
+        return reader.metadata().row_groups[rg].column_chunks[col].sort_order;
+    };
+    assert(order(0, 0) == ChunkOrder::ASCENDING);
+    assert(order(0, 1) == ChunkOrder::DESCENDING);
+    assert(order(0, 2) == ChunkOrder::UNSORTED);
+    assert(order(0, 3) == ChunkOrder::ASCENDING);
+    assert(order(1, 0) == ChunkOrder::ASCENDING);
+    assert(order(1, 1) == ChunkOrder::ASCENDING);
+    assert(order(1, 2) == ChunkOrder::DESCENDING);
+    assert(order(1, 3) == ChunkOrder::DESCENDING);
+    (void)order;
+
+    cleanup();
+    std::cout << "test_sort_order: PASS\n";
+}
+
+void test_column_index() {
+    cleanup();
+
+    Schema schema;
+    schema.columns = {
+        {"plain", ColumnType::INT64, EncodingType::PLAIN},
+        {"delta", ColumnType::INT32, EncodingType::DELTA},
+        {"rle", ColumnType::INT64, EncodingType::RLE},
+        {"name", ColumnType::STRING, EncodingType::PLAIN}
+    };
+
+    // Row groups of 1050 and 201 rows: last blocks of 50 and 1 rows
+    std::vector<std::vector<int64_t>> plains;
+    std::vector<std::vector<int32_t>> deltas;
+    {
+        FileWriter writer(TEST_FILE, schema);
+        writer.writeInt64Column(0, {1, 2});
+        writer.writeInt32Column(1, {1, 2});
+        writer.writeInt64Column(2, {1, 2});
+        writer.writeStringColumn(3, {"a", "b"});
+        bool threw = false;
+        try {
+            writer.setColumnIndex(100);
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw);
+        (void)threw;
+        writer.flushRowGroup();
+
+        writer.setColumnIndex(100);
+        for (int64_t num_rows : {1050, 201}) {
+            std::vector<int64_t> plain;
+            std::vector<int32_t> delta;
+            std::vector<int64_t> rle;
+            std::vector<std::string> names;
+            for (int64_t i = 0; i < num_rows; i++) {
+                plain.push_back((i * 7919) % 1000 - 500);
+                // Jumps between the int32 extremes make deltas wrap
+                if (i % 7 == 0) {
+                    delta.push_back(i % 2 == 0 ? std::numeric_limits<int32_t>::min() : std::numeric_limits<int32_t>::max());
+                } else {
+                    delta.push_back(static_cast<int32_t>(i % 3 == 0 ? -i * 100000 : i * i));
+                }
+                rle.push_back(i / 10);
+                names.push_back("n" + std::to_string(i));
+            }
+            writer.writeInt64Column(0, plain);
+            writer.writeInt32Column(1, delta);
+            writer.writeInt64Column(2, rle);
+            writer.writeStringColumn(3, names);
+            writer.flushRowGroup();
+            plains.push_back(plain);
+            deltas.push_back(delta);
+        }
+        writer.close();
+    }
+
+    FileReader reader(TEST_FILE);
+    const auto& row_groups = reader.metadata().row_groups;
+    assert(!reader.readColumnIndex(0, 0).has_value());
+    assert(!reader.readColumnIndex(1, 3).has_value());
+    assert(row_groups[2].column_chunks[0].index_offset > row_groups[2].column_chunks[3].file_offset);
+
+    for (size_t rg = 1; rg <= 2; rg++) {
+        auto plain = reader.readColumnIndex(rg, 0);
+        auto delta = reader.readColumnIndex(rg, 1);
+        auto rle = reader.readColumnIndex(rg, 2);
+        assert(plain && delta && rle);
+        assert(plain->rows_per_block == 100 && plain->numBlocks() == (rg == 1 ? 11u : 3u));
+        assert(plain->seekable() && delta->seekable() && !rle->seekable());
+        assert(rle->min_values[1] == 10 && rle->max_values[1] == 19);
+
+        // Block min/max hold the block's values
+        const auto& values = plains[rg - 1];
+        for (size_t block = 0; block < plain->numBlocks(); block++) {
+            auto first = values.begin() + static_cast<std::ptrdiff_t>(block * 100);
+            auto last = values.begin() + static_cast<std::ptrdiff_t>(std::min(values.size(), block * 100 + 100));
+            assert(plain->min_values[block] == *std::min_element(first, last));
+            assert(plain->max_values[block] == *std::max_element(first, last));
+            (void)first;
+            (void)last;
+        }
+
+        // Every block range decodes to the same rows as the whole chunk
+        for (size_t first = 0; first < plain->numBlocks(); first++) {
+            for (size_t end = first + 1; end <= plain->numBlocks(); end++) {
+                auto plain_rows = reader.readInt64Blocks(rg, 0, *plain, first, end);
+                auto delta_rows = reader.readInt32Blocks(rg, 1, *delta, first, end);
+                size_t row_end = std::min(values.size(), end * 100);
+                assert(std::equal(plain_rows.begin(), plain_rows.end(), values.begin() + static_cast<std::ptrdiff_t>(first * 100)));
+                assert(plain_rows.size() == row_end - first * 100);
+                assert(std::equal(delta_rows.begin(), delta_rows.end(),
+                                  deltas[rg - 1].begin() + static_cast<std::ptrdiff_t>(first * 100)));
+                assert(delta_rows.size() == row_end - first * 100);
+                (void)plain_rows;
+                (void)delta_rows;
+                (void)row_end;
+            }
+        }
+
+        bool threw = false;
+        try {
+            reader.readInt64Blocks(rg, 2, *rle, 0, 1);
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw);
+        (void)threw;
+    }
+    (void)row_groups;
+
+    cleanup();
+    std::cout << "test_column_index: PASS\n";
+}
+
 int main() {
     std::cout << "Running format tests...\n";
 
@@ -241,6 +675,12 @@ int main() {
     test_string_plain_encoding();
     test_multiple_row_groups();
     test_statistics();
+    test_sum_statistics();
+    test_distinct_sketches();
+    test_string_statistics();
+    test_bloom_filters();
+    test_sort_order();
+    test_column_index();
 
     std::cout << "\nAll format tests passed.\n";
     return 0;
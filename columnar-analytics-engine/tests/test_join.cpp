@@ -0,0 +1,262 @@
+// Columnar Analytics Engine
+// Author: RIAL Fares
+// Tests for hash joins
+
+#include "format.h"
+#include "join.h"
+#include <cassert>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace columnar;
+
+const std::string FACT_FILE = "test_join_fact.col";
+const std::string DIM_FILE = "test_join_dim.col";
+
+void cleanup() {
+    for (const auto& path : {FACT_FILE, DIM_FILE}) {
+        if (std::filesystem::exists(path)) {
+            std::filesystem::remove(path);
+        }
+    }
+}
+
+// Four row groups of 50 rows: id 0..199, customer = id % 13, name = "c<customer>"
+void createFactFile() {
+    Schema schema;
+    schema.columns = {
+        {"id", ColumnType::INT64, EncodingType::PLAIN},
+        {"customer", ColumnType::INT32, EncodingType::PLAIN},
+        {"name", ColumnType::STRING, EncodingType::DICTIONARY}
+    };
+
+    FileWriter writer(FACT_FILE, schema);
+    for (int64_t rg = 0; rg < 4; rg++) {
+        std::vector<int64_t> ids;
+        std::vector<int32_t> customers;
+        std::vector<std::string> names;
+        for (int64_t id = rg * 50; id < rg * 50 + 50; id++) {
+            ids.push_back(id);
+            customers.push_back(static_cast<int32_t>(id % 13));
+            names.push_back("c" + std::to_string(id % 13));
+        }
+        writer.writeInt64Column(0, ids);
+        writer.writeInt32Column(1, customers);
+        writer.writeStringColumn(2, names);
+        writer.flushRowGroup();
+    }
+    writer.close();
+}
+
+// Customers 0..9, customer 3 twice, plus customer 20 which no fact row has
+const std::vector<int64_t> DIM_CUSTOMERS = {0, 1, 2, 3, 3, 4, 5, 6, 7, 8, 9, 20};
+
+std::string dimRegion(size_t row) {
+    return "region_" + std::to_string(row);
+}
+
+void createDimFile() {
+    Schema schema;
+    schema.columns = {
+        {"customer", ColumnType::INT64, EncodingType::PLAIN},
+        {"name", ColumnType::STRING, EncodingType::PLAIN},
+        {"region", ColumnType::STRING, EncodingType::PLAIN}
+    };
+
+    std::vector<std::string> names;
+    std::vector<std::string> regions;
+    for (size_t i = 0; i < DIM_CUSTOMERS.size(); i++) {
+        names.push_back("c" + std::to_string(DIM_CUSTOMERS[i]));
+        regions.push_back(dimRegion(i));
+    }
+
+    FileWriter writer(DIM_FILE, schema);
+    writer.writeInt64Column(0, DIM_CUSTOMERS);
+    writer.writeStringColumn(1, names);
+    writer.writeStringColumn(2, regions);
+    writer.close();
+}
+
+// (id, region) of every joined row, in result order
+std::vector<std::tuple<int64_t, std::string>> collect(ResultStream stream, size_t id_col, size_t region_col) {
+    std::vector<std::tuple<int64_t, std::string>> rows;
+    while (stream.hasNext()) {
+        Batch batch = stream.next();
+        const auto& ids = batch.getColumn<int64_t>(id_col);
+        const auto& regions = batch.getColumn<std::string>(region_col);
+        for (size_t i = 0; i < batch.num_rows; i++) {
+            rows.emplace_back(ids[i], regions[i]);
+        }
+    }
+    return rows;
+}
+
+// Nested loop join of the fact rows against the dimension rows, in fact order
+std::vector<std::tuple<int64_t, std::string>> expectedJoin(bool left) {
+    std::vector<std::tuple<int64_t, std::string>> rows;
+    for (int64_t id = 0; id < 200; id++) {
+        bool matched = false;
+        for (size_t d = 0; d < DIM_CUSTOMERS.size(); d++) {
+            if (DIM_CUSTOMERS[d] == id % 13) {
+                rows.emplace_back(id, dimRegion(d));
+                matched = true;
+            }
+        }
+        if (left && !matched) {
+            rows.emplace_back(id, "");
+        }
+    }
+    return rows;
+}
+
+void test_inner_join() {
+    auto fact = std::make_shared<FileReader>(FACT_FILE);
+    auto dim = std::make_shared<FileReader>(DIM_FILE);
+    auto expected = expectedJoin(false);
+
+    for (size_t threads : {1, 4}) {
+        // INT32 keys joined with INT64 keys; the smaller (right) file is built
+        HashJoin join(fact, "customer", dim, "customer");
+        join.setRightColumns({"region"});
+        join.setThreads(threads);
+        join.setBatchSize(16);
+        assert(!join.buildsOnLeft());
+
+        auto rows = collect(join.execute(), 0, 3);
+        assert(join.buildRows() == DIM_CUSTOMERS.size());
+        assert(rows == expected);
+    }
+
+    // With the small file on the left, it is still the one built, and rows
+    // come in the order of the probed (right) file
+    HashJoin swapped(dim, "customer", fact, "customer");
+    swapped.setLeftColumns({"region"});
+    swapped.setRightColumns({"id"});
+    swapped.setThreads(2);
+    assert(swapped.buildsOnLeft());
+    auto rows = collect(swapped.execute(), 1, 0);
+    assert(rows == expected);
+
+    std::cout << "test_inner_join: PASS\n";
+}
+
+void test_left_join() {
+    auto fact = std::make_shared<FileReader>(FACT_FILE);
+    auto dim = std::make_shared<FileReader>(DIM_FILE);
+
+    HashJoin join(fact, "customer", dim, "customer", JoinType::LEFT);
+    join.setLeftColumns({"id"});
+    join.setRightColumns({"region"});
+    join.setThreads(3);
+    assert(!join.buildsOnLeft());
+
+    ResultStream stream = join.execute();
+    size_t unmatched = 0;
+    std::vector<std::tuple<int64_t, std::string>> rows;
+    while (stream.hasNext()) {
+        Batch batch = stream.next();
+        assert((batch.column_names == std::vector<std::string>{"id", "region", "matched"}));
+        const auto& ids = batch.getColumn<int64_t>(0);
+        const auto& regions = batch.getColumn<std::string>(1);
+        const auto& matched = batch.getColumn<int32_t>(2);
+        for (size_t i = 0; i < batch.num_rows; i++) {
+            rows.emplace_back(ids[i], regions[i]);
+            // Customers 10..12 have no dimension row
+            assert((matched[i] == 0) == (ids[i] % 13 >= 10));
+            unmatched += matched[i] == 0 ? 1 : 0;
+        }
+    }
+    assert(rows == expectedJoin(true));
+    assert(unmatched == 45);
+    (void)unmatched;
+
+    std::cout << "test_left_join: PASS\n";
+}
+
+void test_string_key_join() {
+    auto fact = std::make_shared<FileReader>(FACT_FILE);
+    auto dim = std::make_shared<FileReader>(DIM_FILE);
+
+    HashJoin join(fact, "name", dim, "name");
+    join.setLeftColumns({"id", "customer"});
+    join.setRightColumns({"customer", "region"});
+    join.addRightFilter({"customer", CompareOp::LE, 3});
+    join.setThreads(2);
+
+    ResultStream stream = join.execute();
+    size_t num_rows = 0;
+    while (stream.hasNext()) {
+        Batch batch = stream.next();
+        // Right columns named like left ones are qualified
+        assert((batch.column_names == std::vector<std::string>{"id", "customer", "right.customer", "region"}));
+        const auto& left_customers = batch.getColumn<int32_t>(1);
+        const auto& right_customers = batch.getColumn<int64_t>(2);
+        for (size_t i = 0; i < batch.num_rows; i++) {
+            assert(left_customers[i] == right_customers[i]);
+            assert(right_customers[i] <= 3);
+        }
+        (void)left_customers;
+        (void)right_customers;
+        num_rows += batch.num_rows;
+    }
+    // Customers 0..2 occur 16 times each, customer 3 matches twice
+    assert(num_rows == 16 * 3 + 16 * 2);
+    (void)num_rows;
+
+    std::cout << "test_string_key_join: PASS\n";
+}
+
+void test_join_errors_and_pruning() {
+    auto fact = std::make_shared<FileReader>(FACT_FILE);
+    auto dim = std::make_shared<FileReader>(DIM_FILE);
+
+    // Integer keys cannot be joined with string keys
+    bool threw = false;
+    try {
+        HashJoin join(fact, "customer", dim, "name");
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    (void)threw;
+
+    // Fact ids 0..20 all lie in the first row group; the others are skipped
+    // from their stats and the result is unchanged
+    HashJoin join(fact, "id", dim, "customer");
+    join.setLeftColumns({"id"});
+    join.setRightColumns({"region"});
+    auto rows = collect(join.execute(), 0, 1);
+    assert(rows.size() == DIM_CUSTOMERS.size());
+    assert(std::get<0>(rows.back()) == 20);
+
+    // An empty build side gives an empty inner join
+    HashJoin empty(fact, "id", dim, "customer");
+    empty.addRightFilter({"customer", CompareOp::GT, 100});
+    ResultStream stream = empty.execute();
+    assert(!stream.hasNext());
+    assert(empty.buildRows() == 0);
+
+    std::cout << "test_join_errors_and_pruning: PASS\n";
+}
+
+int main() {
+    std::cout << "Running join tests...\n";
+
+    cleanup();
+    createFactFile();
+    createDimFile();
+
+    test_inner_join();
+    test_left_join();
+    test_string_key_join();
+    test_join_errors_and_pruning();
+
+    cleanup();
+    std::cout << "\nAll join tests passed.\n";
+    return 0;
+}
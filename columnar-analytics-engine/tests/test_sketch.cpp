@@ -0,0 +1,216 @@
+// Columnar Analytics Engine
+// Author: RIAL Fares
+// Tests for probabilistic sketches
+
+#include "sketch.h"
+#include "aggregation.h"
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+using namespace columnar;
+
+void test_hll_precision_for_error() {
+    assert(HyperLogLog::precisionForError(0.01) == 14);
+    assert(HyperLogLog::precisionForError(0.05) == 9);
+    assert(HyperLogLog::precisionForError(1.0) == HyperLogLog::MIN_PRECISION);
+    assert(HyperLogLog::precisionForError(1e-9) == HyperLogLog::MAX_PRECISION);
+
+    bool threw = false;
+    try {
+        HyperLogLog::precisionForError(0.0);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    (void)threw;
+
+    std::cout << "test_hll_precision_for_error: PASS\n";
+}
+
+void test_hll_estimate() {
+    for (uint64_t n : {0ULL, 1ULL, 100ULL, 5000ULL, 200000ULL}) {
+        HyperLogLog sketch(14);
+        for (uint64_t i = 0; i < n; i++) {
+            sketch.add(hashInt64(i));
+            sketch.add(hashInt64(i));  // Duplicates do not count
+        }
+        double estimate = sketch.estimate();
+        double error = n == 0 ? estimate : std::abs(estimate - static_cast<double>(n)) / static_cast<double>(n);
+        assert(error < 0.03);
+        (void)error;
+    }
+
+    std::cout << "test_hll_estimate: PASS\n";
+}
+
+void test_hll_merge() {
+    HyperLogLog left(12);
+    HyperLogLog right(12);
+    HyperLogLog both(12);
+    for (uint64_t i = 0; i < 30000; i++) {
+        uint64_t hash = hashInt64(i);
+        (i < 20000 ? left : right).add(hash);
+        both.add(hash);
+    }
+
+    // Overlapping halves merge into the sketch of the union, exactly
+    HyperLogLog overlap(12);
+    for (uint64_t i = 10000; i < 20000; i++) {
+        overlap.add(hashInt64(i));
+    }
+    left.merge(right);
+    left.merge(overlap);
+    assert(left.serialize() == both.serialize());
+
+    bool threw = false;
+    try {
+        left.merge(HyperLogLog(10));
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    (void)threw;
+
+    std::cout << "test_hll_merge: PASS\n";
+}
+
+void test_hll_reduce() {
+    HyperLogLog fine(14);
+    HyperLogLog coarse(10);
+    for (uint64_t i = 0; i < 50000; i++) {
+        fine.add(hashInt64(i));
+        coarse.add(hashInt64(i));
+    }
+
+    // Reducing is exact: the same registers as sketching at the lower precision
+    assert(fine.reduce(10).serialize() == coarse.serialize());
+    assert(fine.reduce(14).serialize() == fine.serialize());
+
+    bool threw = false;
+    try {
+        coarse.reduce(12);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    (void)threw;
+
+    std::cout << "test_hll_reduce: PASS\n";
+}
+
+void test_hll_serialization() {
+    HyperLogLog sketch(8);
+    for (uint64_t i = 0; i < 1000; i++) {
+        sketch.add(hashInt64(i));
+    }
+
+    auto bytes = sketch.serialize();
+    assert(bytes.size() == 1 + 256);
+    HyperLogLog restored = HyperLogLog::deserialize(bytes.data(), bytes.size());
+    assert(restored.precision() == 8);
+    assert(restored.estimate() == sketch.estimate());
+
+    // Truncated and corrupted sketches are rejected
+    int failures = 0;
+    try {
+        HyperLogLog::deserialize(bytes.data(), bytes.size() - 1);
+    } catch (const std::runtime_error&) {
+        failures++;
+    }
+    bytes[1] = 200;
+    try {
+        HyperLogLog::deserialize(bytes.data(), bytes.size());
+    } catch (const std::runtime_error&) {
+        failures++;
+    }
+    assert(failures == 2);
+    (void)failures;
+
+    std::cout << "test_hll_serialization: PASS\n";
+}
+
+void test_bloom_filter() {
+    BloomFilter filter(10000);
+    assert(filter.numBlocks() == 10000 * 10 / 256 + 1);
+    for (uint64_t i = 0; i < 10000; i++) {
+        filter.add(hashInt64(i));
+    }
+
+    // No false negatives, and few false positives at 10 bits per key
+    for (uint64_t i = 0; i < 10000; i++) {
+        assert(filter.mayContain(hashInt64(i)));
+    }
+    size_t false_positives = 0;
+    for (uint64_t i = 10000; i < 110000; i++) {
+        false_positives += filter.mayContain(hashInt64(i)) ? 1 : 0;
+    }
+    assert(false_positives < 2000);
+    (void)false_positives;
+
+    // An empty filter still has a block and contains nothing
+    BloomFilter empty(0);
+    assert(empty.numBlocks() == 1);
+    assert(!empty.mayContain(hashInt64(1)));
+
+    std::cout << "test_bloom_filter: PASS\n";
+}
+
+void test_bloom_filter_serialization() {
+    // Sized for a 1% rate, the measured rate is close to it
+    BloomFilter filter(5000, BloomFilter::bitsPerKey(0.01));
+    for (uint64_t i = 0; i < 5000; i++) {
+        filter.add(hashInt64(i));
+    }
+
+    auto bytes = filter.serialize();
+    assert(bytes.size() == filter.numBlocks() * BloomFilter::WORDS_PER_BLOCK * sizeof(uint32_t));
+    BloomFilter restored = BloomFilter::deserialize(bytes.data(), bytes.size());
+    assert(restored.numBlocks() == filter.numBlocks());
+    size_t false_positives = 0;
+    for (uint64_t i = 0; i < 105000; i++) {
+        assert(restored.mayContain(hashInt64(i)) == filter.mayContain(hashInt64(i)));
+        false_positives += i >= 5000 && restored.mayContain(hashInt64(i)) ? 1 : 0;
+    }
+    assert(false_positives < 2000);
+    (void)false_positives;
+
+    // Lower rates take more bits per key
+    assert(BloomFilter::bitsPerKey(0.001) > BloomFilter::bitsPerKey(0.01));
+    assert(BloomFilter::bitsPerKey(0.01) > BloomFilter::bitsPerKey(0.1));
+
+    size_t failures = 0;
+    for (double rate : {0.0, 1.0, -0.5}) {
+        try {
+            BloomFilter::bitsPerKey(rate);
+        } catch (const std::runtime_error&) {
+            failures++;
+        }
+    }
+    try {
+        BloomFilter::deserialize(bytes.data(), bytes.size() - 4);
+    } catch (const std::runtime_error&) {
+        failures++;
+    }
+    assert(failures == 4);
+    (void)failures;
+
+    std::cout << "test_bloom_filter_serialization: PASS\n";
+}
+
+int main() {
+    std::cout << "Running sketch tests...\n";
+
+    test_hll_precision_for_error();
+    test_hll_estimate();
+    test_hll_merge();
+    test_hll_reduce();
+    test_hll_serialization();
+    test_bloom_filter();
+    test_bloom_filter_serialization();
+
+    std::cout << "\nAll sketch tests passed.\n";
+    return 0;
+}
@@ -0,0 +1,156 @@
+// Columnar Analytics Engine
+// Author: RIAL Fares
+// Tests for sorting primitives
+
+#include "sort.h"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace columnar;
+
+Batch makeBatch(std::vector<int64_t> keys, std::vector<std::string> names) {
+    Batch batch;
+    batch.num_rows = keys.size();
+    batch.column_names = {"key", "name"};
+    batch.columns.push_back(std::move(keys));
+    batch.columns.push_back(std::move(names));
+    return batch;
+}
+
+void test_top_n_order() {
+    // Many batches of random keys, enough to trigger row store compaction
+    std::mt19937 rng(7);
+    std::vector<int64_t> all;
+    TopN<int64_t> top(50, SortOrder<int64_t>{true});
+
+    for (size_t b = 0; b < 40; b++) {
+        std::vector<int64_t> keys;
+        std::vector<std::string> names;
+        for (size_t i = 0; i < 1000; i++) {
+            int64_t key = static_cast<int64_t>(rng() % 100000);
+            keys.push_back(key);
+            names.push_back("row_" + std::to_string(key));
+            all.push_back(key);
+        }
+        top.add(makeBatch(keys, names), 0, rowPosition(b, 0));
+    }
+
+    std::sort(all.begin(), all.end(), std::greater<int64_t>());
+    auto batches = top.finish(10, 16);
+    assert(batches.size() == 3);
+
+    size_t rank = 10;
+    for (const auto& batch : batches) {
+        const auto& keys = batch.getColumn<int64_t>(0);
+        const auto& names = batch.getColumn<std::string>(1);
+        for (size_t i = 0; i < batch.num_rows; i++, rank++) {
+            assert(keys[i] == all[rank]);
+            assert(names[i] == "row_" + std::to_string(keys[i]));
+        }
+        (void)keys;
+        (void)names;
+    }
+    assert(rank == 50);
+
+    std::cout << "test_top_n_order: PASS\n";
+}
+
+void test_top_n_ties_and_admission() {
+    // Ties keep file order: the earlier position wins
+    TopN<std::string> top(2, SortOrder<std::string>{false});
+    top.add(makeBatch({1, 2, 3}, {"b", "a", "b"}), 1, rowPosition(0, 0));
+    assert(top.full());
+    assert(top.admits("a", rowPosition(0, 0)));
+    assert(!top.admits("b", rowPosition(1, 0)));
+    assert(!top.admits("c", 0));
+
+    top.add(makeBatch({4}, {"a"}), 1, rowPosition(1, 0));
+    auto batches = top.finish(0, 10);
+    assert(batches.size() == 1);
+    assert(batches[0].getColumn<int64_t>(0) == std::vector<int64_t>({2, 4}));
+
+    // Nothing is kept for n = 0
+    TopN<int64_t> none(0, SortOrder<int64_t>{});
+    none.add(makeBatch({1}, {"x"}), 0, 0);
+    assert(!none.admits(0, 0));
+    assert(none.finish(0, 10).empty());
+
+    std::cout << "test_top_n_ties_and_admission: PASS\n";
+}
+
+void test_radix_sort_rows() {
+    std::mt19937_64 rng(11);
+    std::vector<int64_t> values;
+    for (size_t i = 0; i < 5000; i++) {
+        // Few distinct values, so stability matters, spanning the sign bit
+        values.push_back(static_cast<int64_t>(rng() % 64) * 0x0101010101LL - (int64_t{1} << 40));
+    }
+
+    for (bool descending : {false, true}) {
+        std::vector<uint64_t> keys;
+        for (int64_t v : values) {
+            keys.push_back(normalizeKey(v, descending));
+        }
+        std::vector<uint32_t> rows;
+        radixSortRows(keys, rows);
+
+        std::vector<uint32_t> expected(values.size());
+        for (size_t i = 0; i < expected.size(); i++) {
+            expected[i] = static_cast<uint32_t>(i);
+        }
+        std::stable_sort(expected.begin(), expected.end(), [&](uint32_t a, uint32_t b) {
+            return descending ? values[a] > values[b] : values[a] < values[b];
+        });
+        assert(rows == expected);
+    }
+
+    // String prefixes order like the strings they start
+    assert(normalizeKey(std::string_view("apple"), false) < normalizeKey(std::string_view("apricot"), false));
+    assert(normalizeKey(std::string_view("ab"), false) < normalizeKey(std::string_view("abc"), false));
+    assert(normalizeKey(std::string_view("customer_1"), false) == normalizeKey(std::string_view("customer_2"), false));
+
+    std::cout << "test_radix_sort_rows: PASS\n";
+}
+
+void test_loser_tree_merge() {
+    // Merge 5 sorted lists (one empty) and check the result is sorted and complete
+    std::vector<std::vector<int>> lists = {{1, 4, 9}, {}, {2, 2, 3, 10}, {0}, {5, 6, 7, 8, 11}};
+    std::vector<size_t> pos(lists.size(), 0);
+    auto before = [&](size_t a, size_t b) {
+        bool a_done = pos[a] == lists[a].size();
+        bool b_done = pos[b] == lists[b].size();
+        if (a_done || b_done) {
+            return !a_done;
+        }
+        int va = lists[a][pos[a]];
+        int vb = lists[b][pos[b]];
+        return va != vb ? va < vb : a < b;
+    };
+
+    LoserTree<decltype(before)> tree(lists.size(), before);
+    std::vector<int> merged;
+    while (pos[tree.winner()] < lists[tree.winner()].size()) {
+        size_t w = tree.winner();
+        merged.push_back(lists[w][pos[w]++]);
+        tree.replay();
+    }
+    assert((merged == std::vector<int>{0, 1, 2, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}));
+
+    std::cout << "test_loser_tree_merge: PASS\n";
+}
+
+int main() {
+    std::cout << "Running sort tests...\n";
+
+    test_top_n_order();
+    test_top_n_ties_and_admission();
+    test_radix_sort_rows();
+    test_loser_tree_merge();
+
+    std::cout << "\nAll sort tests passed.\n";
+    return 0;
+}